@@ -0,0 +1,28 @@
+﻿namespace SoundFlow.Codecs.FFMpeg.Enums;
+
+/// <summary>
+/// Mirrors the SFDurationSource enum from the native soundflow-ffmpeg library: how a decoder's length was determined,
+/// from least to most reliable.
+/// </summary>
+public enum FFmpegDurationSource
+{
+    /// <summary>
+    /// The length is not known.
+    /// </summary>
+    Unknown = 0,
+
+    /// <summary>
+    /// Estimated from the bitrate. May be off for VBR and concatenated streams.
+    /// </summary>
+    Estimate = 1,
+
+    /// <summary>
+    /// Read from the container or stream headers.
+    /// </summary>
+    Header = 2,
+
+    /// <summary>
+    /// Counted packet by packet.
+    /// </summary>
+    Scanned = 3,
+}
@@ -0,0 +1,19 @@
+﻿namespace SoundFlow.Codecs.FFMpeg.Enums;
+
+/// <summary>
+/// Mirrors the SFEncoderFlags enum from the native soundflow-ffmpeg library.
+/// </summary>
+[Flags]
+public enum FFmpegEncoderFlags : uint
+{
+    /// <summary>
+    /// No special behaviour.
+    /// </summary>
+    None = 0,
+
+    /// <summary>
+    /// Switches the codec to its low-latency settings, at some cost in coding efficiency. For the native Opus encoder
+    /// this caps the look-ahead and packet duration at 10 ms; codecs without such settings, such as AAC, reject it.
+    /// </summary>
+    LowDelay = 1 << 0,
+}
@@ -80,6 +80,11 @@ public enum FFmpegResult
     /// </summary>
     DecoderErrorDecodingFailed = -20,
 
+    /// <summary>
+    /// The decoder being chained produces a different sample format, channel count or sample rate.
+    /// </summary>
+    DecoderErrorChainFormatMismatch = -21,
+
     // Encoder-specific Errors
     
     /// <summary>
@@ -141,4 +146,38 @@ public enum FFmpegResult
     /// An I/O error occurred while writing the encoded data to the output stream.
     /// </summary>
     EncoderErrorWriteFailed = -41,
+    
+    /// <summary>
+    /// The buffer passed to receive an encoded packet is smaller than the packet.
+    /// </summary>
+    EncoderErrorBufferTooSmall = -42,
+
+    // Remux-specific Errors
+
+    /// <summary>
+    /// An input's codec is not supported by the output format, or its codec parameters differ from the first input.
+    /// </summary>
+    RemuxErrorIncompatibleInput = -50,
+
+    // Transcode-specific Errors
+
+    /// <summary>
+    /// The transcode was cancelled from its progress callback.
+    /// </summary>
+    TranscodeCancelled = -60,
+
+    /// <summary>
+    /// One or more jobs of a batch transcode failed. The per-job results describe the failures.
+    /// </summary>
+    TranscodeJobFailed = -61,
+
+    /// <summary>
+    /// An input or output file of a batch transcode could not be opened.
+    /// </summary>
+    TranscodeErrorOpenFile = -62,
+
+    /// <summary>
+    /// The probe cache file could not be opened or created.
+    /// </summary>
+    ProbeCacheErrorOpenFile = -70,
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
-﻿using SoundFlow.Abstracts;
+﻿using System.Text;
+using SoundFlow.Abstracts;
 using SoundFlow.Enums;
 using SoundFlow.Interfaces;
+using SoundFlow.Metadata.Models;
 using SoundFlow.Structs;
 
 namespace SoundFlow.Codecs.FFMpeg;
@@ -55,11 +57,51 @@ public sealed class FFmpegCodecFactory : ICodecFactory
     /// <inheritdoc />
     public int Priority => 100;
 
+    /// <summary>
+    /// Gets the muxer options applied to every encoder created by this factory, keyed by FFmpeg option name.
+    /// </summary>
+    /// <remarks>
+    /// Every option must be recognised by the muxer of the format being written, otherwise creating the encoder fails,
+    /// so format-specific options belong on a factory used for that format only. Values may contain any character.
+    /// For example, <c>MuxerOptions["movflags"] = "+faststart"</c> moves the MP4/M4A <c>moov</c> atom to the front of the file
+    /// (requires a readable and seekable output stream), and <c>"+frag_keyframe+empty_moov"</c> writes fragmented MP4
+    /// that needs no header rewrite at all.
+    /// </remarks>
+    public Dictionary<string, string> MuxerOptions { get; } = new(StringComparer.Ordinal);
+
+    /// <summary>
+    /// Gets or sets how decoders created by this factory determine the stream length.
+    /// </summary>
+    /// <remarks>
+    /// Headerless streams such as ADTS AAC or MP3 without a Xing header only carry a bitrate estimate, which is wrong for
+    /// VBR and concatenated streams. <see cref="DurationAccuracy.AccurateScan"/> counts their length from packet headers
+    /// when the decoder is created, without decoding; streams whose headers state the length are never scanned.
+    /// </remarks>
+    public DurationAccuracy DurationAccuracy { get; set; } = DurationAccuracy.FastEstimate;
+
+    /// <summary>
+    /// Gets or sets whether decoders created by this factory strip the encoder delay and padding, so consecutive tracks
+    /// of a gapless album join without silence. Chain the next track with <see cref="ISoundDecoder.ChainNext"/> for a
+    /// seamless transition.
+    /// </summary>
+    public bool Gapless { get; set; }
+
+    /// <summary>
+    /// Gets or sets whether decoders created by this factory are served from the process-wide
+    /// <see cref="FFmpegDecodeCache"/>, so sounds that are opened repeatedly are probed and decoded only once.
+    /// </summary>
+    /// <remarks>
+    /// Cached decoders read from shared memory and support decoding, seeking and chaining; <see cref="Gapless"/> and the
+    /// range, reverse and silence-trimming modes do not apply to them. Only <see cref="FileStream"/> inputs are cached,
+    /// keyed by their path, length and modification time; other streams have no reliable identity and are decoded as usual.
+    /// </remarks>
+    public bool CacheDecodedAudio { get; set; }
+
     /// <inheritdoc />
     public ISoundDecoder? CreateDecoder(Stream stream, string formatId, AudioFormat format)
     {
         return SupportedFormatIds.Contains(formatId.ToLowerInvariant()) 
-            ? new FFmpegDecoder(stream, format) 
+            ? new FFmpegDecoder(stream, format, DurationAccuracy, Gapless, CacheDecodedAudio) 
             : null;
     }
 
@@ -71,7 +113,7 @@ public sealed class FFmpegCodecFactory : ICodecFactory
         {
             
             // use hint or a dummy format to initialize the decoder, but the actual format is determined by the underlying FFmpeg wrapper.
-            var decoder = new FFmpegDecoder(stream, hintFormat ?? AudioFormat.DvdHq);
+            var decoder = new FFmpegDecoder(stream, hintFormat ?? AudioFormat.DvdHq, DurationAccuracy, Gapless, CacheDecodedAudio);
 
             // If initialization succeeds, the decoder has determined the actual format.
             detectedFormat = new AudioFormat
@@ -93,6 +135,27 @@ public sealed class FFmpegCodecFactory : ICodecFactory
 
     /// <inheritdoc />
     public ISoundEncoder? CreateEncoder(Stream stream, string formatId, AudioFormat format)
+    {
+        return CreateEncoder(stream, formatId, format, null);
+    }
+
+    /// <summary>
+    /// Creates a new encoder that writes audio at a different channel count and/or sample rate than its input.
+    /// </summary>
+    /// <remarks>
+    /// The conversion is done by libswresample inside the native encoder, so there is no need to run
+    /// <see cref="SoundFlow.Utils.ChannelMixer"/> or a resampler over the samples before calling
+    /// <see cref="ISoundEncoder.Encode"/>. For example, 48 kHz stereo input can be written directly as 16 kHz mono Opus.
+    /// </remarks>
+    /// <param name="stream">The output stream to write encoded audio to.</param>
+    /// <param name="formatId">The specific format identifier being requested (e.g., "opus").</param>
+    /// <param name="format">The audio format of the raw PCM samples passed to the encoder.</param>
+    /// <param name="targetFormat">
+    /// The channel count and sample rate to encode at. Zero fields, or a null value, keep the input values.
+    /// The sample format is always chosen by the codec.
+    /// </param>
+    /// <returns>A valid <see cref="ISoundEncoder"/> instance on success, or <c>null</c> if the format is not supported.</returns>
+    public ISoundEncoder? CreateEncoder(Stream stream, string formatId, AudioFormat format, AudioFormat? targetFormat)
     {
         // The native wrapper handles resampling from the source format to what the encoder needs.
         var encoderName = formatId.ToLowerInvariant();
@@ -105,7 +168,27 @@ public sealed class FFmpegCodecFactory : ICodecFactory
         }
         
         return SupportedFormatIds.Contains(formatId.ToLowerInvariant()) 
-            ? new FFmpegEncoder(stream, encoderName, format) 
+            ? new FFmpegEncoder(stream, encoderName, format, targetFormat, FormatMuxerOptions()) 
             : null;
     }
+
+    private string? FormatMuxerOptions()
+    {
+        return MuxerOptions.Count == 0
+            ? null
+            : string.Join(':', MuxerOptions.Select(option => $"{EscapeOption(option.Key)}={EscapeOption(option.Value)}"));
+    }
+
+    // FFmpeg splits the list on unescaped ':' and '=', and trims unescaped whitespace around each token.
+    private static string EscapeOption(string text)
+    {
+        var builder = new StringBuilder(text.Length);
+        foreach (var c in text)
+        {
+            if (c is ':' or '=' or '\\' or '\'' || char.IsWhiteSpace(c))
+                builder.Append('\\');
+            builder.Append(c);
+        }
+        return builder.ToString();
+    }
 }
\ No newline at end of file
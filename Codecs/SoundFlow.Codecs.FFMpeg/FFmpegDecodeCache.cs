@@ -0,0 +1,49 @@
+﻿using SoundFlow.Codecs.FFMpeg.Native;
+
+namespace SoundFlow.Codecs.FFMpeg;
+
+/// <summary>
+/// Counters of the <see cref="FFmpegDecodeCache"/>.
+/// </summary>
+/// <param name="Hits">Decoders served from an already decoded asset.</param>
+/// <param name="Misses">Decoders that had to probe and decode their asset.</param>
+/// <param name="Evictions">Assets evicted to stay within the budget.</param>
+/// <param name="Entries">Assets currently cached.</param>
+/// <param name="Bytes">Memory held by the cached PCM, in bytes.</param>
+/// <param name="Budget">The memory budget, in bytes.</param>
+public readonly record struct FFmpegDecodeCacheStatistics(long Hits, long Misses, long Evictions, long Entries, long Bytes, long Budget);
+
+/// <summary>
+/// The process-wide cache of fully decoded assets used by decoders created with
+/// <see cref="FFmpegCodecFactory.CacheDecodedAudio"/>. Entries are evicted least recently used first once the memory
+/// budget is reached; decoders still reading an evicted asset keep it alive until they are disposed.
+/// </summary>
+public static class FFmpegDecodeCache
+{
+    /// <summary>
+    /// Gets or sets the memory budget in bytes. Defaults to 64 MiB; 0 disables caching.
+    /// </summary>
+    public static long Budget
+    {
+        get => GetStatistics().Budget;
+        set
+        {
+            ArgumentOutOfRangeException.ThrowIfNegative(value);
+            FFmpeg.SetCacheBudget(value);
+        }
+    }
+
+    /// <summary>
+    /// Gets the cache's hit, miss and eviction counters and its current size.
+    /// </summary>
+    public static FFmpegDecodeCacheStatistics GetStatistics()
+    {
+        FFmpeg.GetCacheStats(out var stats);
+        return new FFmpegDecodeCacheStatistics(stats.Hits, stats.Misses, stats.Evictions, stats.Entries, stats.Bytes, stats.Budget);
+    }
+
+    /// <summary>
+    /// Removes every asset from the cache.
+    /// </summary>
+    public static void Clear() => FFmpeg.ClearCache();
+}
@@ -1,7 +1,9 @@
-﻿using SoundFlow.Codecs.FFMpeg.Enums;
+﻿using System.Buffers;
+using SoundFlow.Codecs.FFMpeg.Enums;
 using SoundFlow.Codecs.FFMpeg.Exceptions;
 using SoundFlow.Enums;
 using SoundFlow.Interfaces;
+using SoundFlow.Metadata.Models;
 using SoundFlow.Structs;
 using SoundFlow.Codecs.FFMpeg.Native;
 using SoundFlow.Utils;
@@ -18,13 +20,25 @@ internal sealed class FFmpegDecoder : ISoundDecoder
     private readonly Stream _stream;
     private readonly FFmpeg.ReadCallback _readCallback;
     private readonly FFmpeg.SeekCallback _seekCallback;
+    private FFmpegDecoder? _next;
+    private bool _planar;
 
     /// <summary>
     /// Initializes a new instance of the <see cref="FFmpegDecoder"/> class.
     /// </summary>
     /// <param name="stream">The input stream containing the audio data to decode.</param>
     /// <param name="targetFormat">The desired output format for the decoded PCM data.</param>
-    public FFmpegDecoder(Stream stream, AudioFormat targetFormat)
+    /// <param name="durationAccuracy">
+    /// With <see cref="DurationAccuracy.AccurateScan"/>, a length that is estimated or missing from the headers is
+    /// counted by scanning the stream's packets.
+    /// </param>
+    /// <param name="gapless">Whether to strip the encoder delay and padding, for gapless playback.</param>
+    /// <param name="cached">
+    /// Whether to serve the audio from the process-wide <see cref="FFmpegDecodeCache"/>. Only a <see cref="FileStream"/>
+    /// is cached, keyed by its path, length and modification time; any other stream is decoded as usual.
+    /// </param>
+    public FFmpegDecoder(Stream stream, AudioFormat targetFormat, DurationAccuracy durationAccuracy = DurationAccuracy.FastEstimate,
+        bool gapless = false, bool cached = false)
     {
         _stream = stream;
 
@@ -35,8 +49,17 @@ internal sealed class FFmpegDecoder : ISoundDecoder
         if (_handle.IsInvalid)
             throw new InvalidOperationException("Failed to create FFmpeg decoder handle.");
 
-        var result = FFmpeg.InitializeDecoder(_handle, _readCallback, _seekCallback, IntPtr.Zero,
-            targetFormat.Format, out var nativeFormat, out var channels, out var sampleRate);
+        // Only files have a key. The decode cache needs one to tell assets apart, and files go through the probe cache only
+        // while FFmpegProbeCache is open, as the lookup reads and rewinds the file head.
+        var key = GetCacheKey(stream);
+        var result = cached && key != null
+            ? FFmpeg.InitializeDecoderCached(_handle, key, _readCallback, _seekCallback, IntPtr.Zero,
+                targetFormat.Format, out var nativeFormat, out var channels, out var sampleRate)
+            : key != null && FFmpegProbeCache.IsOpen
+                ? FFmpeg.InitializeDecoderProbeCached(_handle, key, _readCallback, _seekCallback, IntPtr.Zero,
+                    targetFormat.Format, out nativeFormat, out channels, out sampleRate)
+                : FFmpeg.InitializeDecoder(_handle, _readCallback, _seekCallback, IntPtr.Zero,
+                    targetFormat.Format, out nativeFormat, out channels, out sampleRate);
 
         if (result != FFmpegResult.Success)
         {
@@ -50,7 +73,14 @@ internal sealed class FFmpegDecoder : ISoundDecoder
         Channels = targetFormat.Channels = (int)channels;
         SampleRate = targetFormat.SampleRate = (int)sampleRate;
         
-        var lengthInFrames = FFmpeg.GetLengthInPcmFrames(_handle);
+        if (gapless)
+        {
+            result = FFmpeg.SetGapless(_handle, 1);
+            if (result != FFmpegResult.Success)
+                Log.Warning($"Failed to enable FFmpeg gapless decoding. Result: {result}");
+        }
+
+        var lengthInFrames = FFmpeg.GetLengthInfo(_handle, out var lengthSource);
         if (lengthInFrames < 0)
         {
             const string logMessage = "Failed to get stream length, the decoder handle may be invalid.";
@@ -58,8 +88,28 @@ internal sealed class FFmpegDecoder : ISoundDecoder
             _handle.Dispose();
             throw new InvalidOperationException(logMessage);
         }
+        if (durationAccuracy == DurationAccuracy.AccurateScan && lengthSource < FFmpegDurationSource.Header && stream.CanSeek)
+        {
+            result = FFmpeg.ScanLength(_handle, out var scannedFrames);
+            if (result == FFmpegResult.Success)
+            {
+                lengthInFrames = scannedFrames;
+                lengthSource = FFmpegDurationSource.Scanned;
+            }
+            else
+            {
+                Log.Warning($"FFmpeg duration scan failed, keeping the {lengthSource} length. Result: {result}");
+            }
+        }
+
         Length = (int)(lengthInFrames * Channels);
+        LengthSource = lengthSource;
     }
+
+    /// <summary>
+    /// Gets how <see cref="Length"/> was determined.
+    /// </summary>
+    public FFmpegDurationSource LengthSource { get; }
     
     /// <inheritdoc />
     public bool IsDisposed => _handle.IsClosed;
@@ -84,6 +134,14 @@ internal sealed class FFmpegDecoder : ISoundDecoder
     {
         if (IsDisposed || samples.IsEmpty) return 0;
 
+        // Never read through a chained decoder that has since been disposed.
+        if (_next is { IsDisposed: true })
+        {
+            FFmpeg.Unchain(_handle, IntPtr.Zero);
+            _next = null;
+        }
+
+        LeavePlanarMode();
         var framesToRead = samples.Length / Channels;
         long framesRead;
 
@@ -105,6 +163,67 @@ internal sealed class FFmpegDecoder : ISoundDecoder
         return samplesRead;
     }
 
+    /// <inheritdoc />
+    public unsafe int DecodePlanar(Memory<float>[] channels)
+    {
+        ArgumentNullException.ThrowIfNull(channels);
+        if (channels.Length != Channels) throw new ArgumentException("Expected one buffer per channel.", nameof(channels));
+        if (IsDisposed) return 0;
+
+        var frameCount = int.MaxValue;
+        foreach (var channel in channels) frameCount = Math.Min(frameCount, channel.Length);
+        if (frameCount == 0) return 0;
+
+        // Planar mode excludes chaining, looped ranges and reverse playback; those keep splitting interleaved output.
+        if (!_planar)
+        {
+            _planar = _next == null && FFmpeg.SetPlanar(_handle, 1) == FFmpegResult.Success;
+            if (!_planar) return DecoderHelper.DecodeAndSplit(this, channels, frameCount);
+        }
+
+        var pointers = stackalloc IntPtr[Channels];
+        var handles = ArrayPool<MemoryHandle>.Shared.Rent(Channels);
+        long framesRead;
+        try
+        {
+            for (var c = 0; c < Channels; c++)
+            {
+                handles[c] = channels[c].Pin();
+                pointers[c] = (IntPtr)handles[c].Pointer;
+            }
+
+            var result = FFmpeg.ReadPcmFramesPlanar(_handle, (IntPtr)pointers, frameCount, out framesRead);
+            if (result != FFmpegResult.Success)
+            {
+                throw new FFmpegException(result, $"An unrecoverable error occurred during decoding. Result: {result}");
+            }
+        }
+        finally
+        {
+            for (var c = 0; c < Channels; c++) handles[c].Dispose();
+            ArrayPool<MemoryHandle>.Shared.Return(handles, true);
+        }
+
+        if (framesRead == 0)
+        {
+            EndOfStreamReached?.Invoke(this, EventArgs.Empty);
+        }
+
+        return (int)framesRead;
+    }
+
+    /// <summary>
+    /// Returns the native decoder to interleaved output before a read or mode that needs it.
+    /// </summary>
+    private void LeavePlanarMode()
+    {
+        if (!_planar) return;
+        var result = FFmpeg.SetPlanar(_handle, 0);
+        if (result != FFmpegResult.Success)
+            throw new FFmpegException(result, $"Failed to leave FFmpeg planar decoding. Result: {result}");
+        _planar = false;
+    }
+
     /// <inheritdoc />
     public bool Seek(int sampleOffset)
     {
@@ -115,6 +234,84 @@ internal sealed class FFmpegDecoder : ISoundDecoder
         return result == FFmpegResult.Success;
     }
 
+    /// <inheritdoc />
+    public bool SetRange(int startSample, int endSample, bool loop)
+    {
+        if (IsDisposed || !_stream.CanSeek) return false;
+
+        if (loop) LeavePlanarMode();
+        var result = FFmpeg.SetRange(_handle, startSample / Channels, endSample / Channels, loop ? 1 : 0);
+        return result == FFmpegResult.Success;
+    }
+
+    /// <inheritdoc />
+    public bool SetReverse(bool reverse)
+    {
+        if (IsDisposed || !_stream.CanSeek) return false;
+
+        if (reverse) LeavePlanarMode();
+        var result = FFmpeg.SetReverse(_handle, reverse ? 1 : 0);
+        return result == FFmpegResult.Success;
+    }
+
+    /// <inheritdoc />
+    public bool TrimSilence(float thresholdDb, int holdMilliseconds, out int startSample, out int endSample)
+    {
+        startSample = endSample = 0;
+        if (IsDisposed || !_stream.CanSeek) return false;
+
+        LeavePlanarMode();
+        var result = FFmpeg.TrimSilence(_handle, thresholdDb, holdMilliseconds, out var firstFrame, out var lastFrame);
+        if (result != FFmpegResult.Success)
+        {
+            Log.Warning($"FFmpeg silence analysis failed. Result: {result}");
+            return false;
+        }
+        if (firstFrame < 0) return false;
+
+        startSample = (int)(firstFrame * Channels);
+        endSample = (int)((lastFrame + 1) * Channels);
+        return true;
+    }
+
+    /// <inheritdoc />
+    public bool ChainNext(ISoundDecoder? next)
+    {
+        if (IsDisposed) return false;
+
+        if (next == null)
+        {
+            FFmpeg.Unchain(_handle, IntPtr.Zero);
+            _next = null;
+            return true;
+        }
+
+        if (next is not FFmpegDecoder { IsDisposed: false } decoder) return false;
+
+        LeavePlanarMode();
+        decoder.LeavePlanarMode();
+
+        var result = FFmpeg.Chain(_handle, decoder._handle);
+        if (result != FFmpegResult.Success)
+        {
+            Log.Warning($"Failed to chain FFmpeg decoder. Result: {result}");
+            return false;
+        }
+
+        _next = decoder;
+        return true;
+    }
+
+    /// <summary>
+    /// Keys files by path, size and modification time; other streams are keyed natively by a hash of their content.
+    /// </summary>
+    private static string? GetCacheKey(Stream stream)
+    {
+        if (stream is not FileStream fileStream) return null;
+        var path = Path.GetFullPath(fileStream.Name);
+        return $"{path}|{fileStream.Length}|{File.GetLastWriteTimeUtc(path).Ticks}";
+    }
+
     private unsafe nuint OnRead(IntPtr pUserData, IntPtr pBuffer, nuint bytesToRead)
     {
         try
@@ -16,6 +16,8 @@ internal sealed class FFmpegEncoder : ISoundEncoder
     private readonly SafeEncoderHandle _handle;
     private readonly Stream _stream;
     private readonly FFmpeg.WriteCallback _writeCallback;
+    private readonly FFmpeg.ReadCallback? _readCallback;
+    private readonly FFmpeg.SeekCallback? _seekCallback;
     private readonly int _channels;
 
     /// <summary>
@@ -24,18 +26,36 @@ internal sealed class FFmpegEncoder : ISoundEncoder
     /// <param name="stream">The output stream to write the encoded audio data to.</param>
     /// <param name="formatId">The string identifier of the target audio format (e.g., "mp3", "flac").</param>
     /// <param name="sourceFormat">The format of the raw PCM input data.</param>
-    public FFmpegEncoder(Stream stream, string formatId, AudioFormat sourceFormat)
+    /// <param name="targetFormat">
+    /// The optional channel count and sample rate to encode at. When it differs from <paramref name="sourceFormat"/>,
+    /// the native encoder converts the input with libswresample. A zero field keeps the source value.
+    /// </param>
+    /// <param name="muxerOptions">
+    /// Optional muxer options in FFmpeg's <c>key=value:key=value</c> form, e.g. <c>movflags=+faststart</c>, with ':', '='
+    /// and '\' inside a value escaped by a backslash. An option the muxer does not recognise fails with
+    /// <see cref="FFmpegResult.ErrorInvalidArgs"/>.
+    /// </param>
+    /// <remarks>
+    /// When <paramref name="stream"/> is seekable, the muxer is allowed to seek back and finalise its headers in place
+    /// (WAV sizes, FLAC STREAMINFO, MP4 <c>moov</c>). If it is also readable, muxers that read back their own output,
+    /// such as MP4 with <c>faststart</c>, are supported as well.
+    /// </remarks>
+    public FFmpegEncoder(Stream stream, string formatId, AudioFormat sourceFormat, AudioFormat? targetFormat = null,
+        string? muxerOptions = null)
     {
         _stream = stream;
         _channels = sourceFormat.Channels;
         _writeCallback = OnWrite;
+        _seekCallback = stream.CanSeek ? OnSeek : null;
+        _readCallback = stream is { CanSeek: true, CanRead: true } ? OnRead : null;
         
         _handle = FFmpeg.CreateEncoder();
         if (_handle.IsInvalid)
             throw new InvalidOperationException("Failed to create FFmpeg encoder handle.");
         
-        var result = FFmpeg.InitializeEncoder(_handle, formatId, _writeCallback, IntPtr.Zero,
-            sourceFormat.Format, (uint)sourceFormat.Channels, (uint)sourceFormat.SampleRate);
+        var result = FFmpeg.InitializeEncoder(_handle, formatId, _writeCallback, _readCallback, _seekCallback, IntPtr.Zero,
+            sourceFormat.Format, (uint)sourceFormat.Channels, (uint)sourceFormat.SampleRate,
+            (uint)(targetFormat?.Channels ?? 0), (uint)(targetFormat?.SampleRate ?? 0), muxerOptions);
             
         if (result != FFmpegResult.Success)
         {
@@ -84,11 +104,42 @@ internal sealed class FFmpegEncoder : ISoundEncoder
         }
     }
     
+    private unsafe nuint OnRead(IntPtr pUserData, IntPtr pBuffer, nuint bytesToRead)
+    {
+        try
+        {
+            var buffer = new Span<byte>((void*)pBuffer, (int)bytesToRead);
+            return (nuint)_stream.Read(buffer);
+        }
+        catch
+        {
+            Log.Critical("Failed to read back from stream.");
+            return 0;
+        }
+    }
+
+    private long OnSeek(IntPtr pUserData, long offset, SeekWhence whence)
+    {
+        try
+        {
+            return _stream.Seek(offset, (SeekOrigin)whence);
+        }
+        catch
+        {
+            Log.Critical("Failed to seek stream.");
+            return -1;
+        }
+    }
+    
     /// <inheritdoc />
     public void Dispose()
     {
         if (IsDisposed) return;
+        
+        // The native free flushes the encoder and writes the trailer, which may still call back into the stream.
         _handle.Dispose();
         GC.KeepAlive(_writeCallback);
+        GC.KeepAlive(_readCallback);
+        GC.KeepAlive(_seekCallback);
     }
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+﻿using SoundFlow.Codecs.FFMpeg.Enums;
+using SoundFlow.Codecs.FFMpeg.Exceptions;
+using SoundFlow.Codecs.FFMpeg.Native;
+using SoundFlow.Enums;
+using SoundFlow.Utils;
+
+namespace SoundFlow.Codecs.FFMpeg;
+
+/// <summary>
+/// Decodes individual compressed packets (e.g. Opus or AAC received over the network) into PCM without a container.
+/// </summary>
+/// <remarks>
+/// Packets are queued in a native jitter buffer that reorders them by timestamp and holds a small cushion before playout.
+/// Packets that are still missing when their turn comes are concealed by fading out a repeat of the last decoded frame,
+/// and packets that arrive after their slot was played are dropped and deepen the buffer. Call <see cref="Decode"/>
+/// once per audio period; it returns fewer samples than requested while the buffer is filling.
+/// </remarks>
+public sealed class FFmpegPacketDecoder : IDisposable
+{
+    private readonly SafeDecoderHandle _handle;
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="FFmpegPacketDecoder"/> class.
+    /// </summary>
+    /// <param name="codecName">The FFmpeg decoder name, e.g. "opus", "aac" or "mp3".</param>
+    /// <param name="channels">The channel count of the stream, or 0 if the extradata describes it.</param>
+    /// <param name="sampleRate">The sample rate of the stream, or 0 if the extradata describes it. Packet timestamps are in samples at this rate.</param>
+    /// <param name="extraData">The codec's out-of-band configuration, such as <see cref="FFmpegPacketEncoder.ExtraData"/>.</param>
+    /// <param name="jitterDepth">The minimum number of packets to buffer before playout, or 0 for the native default.</param>
+    public unsafe FFmpegPacketDecoder(string codecName, int channels = 0, int sampleRate = 0, byte[]? extraData = null, int jitterDepth = 0)
+    {
+        _handle = FFmpeg.CreateDecoder();
+        if (_handle.IsInvalid)
+            throw new InvalidOperationException("Failed to create FFmpeg decoder handle.");
+
+        FFmpegResult result;
+        uint outChannels, outSampleRate;
+        fixed (byte* pExtraData = extraData)
+        {
+            result = FFmpeg.InitializeRawDecoder(_handle, codecName, (IntPtr)pExtraData, extraData?.Length ?? 0,
+                (uint)channels, (uint)sampleRate, jitterDepth, SampleFormat.F32, out _, out outChannels, out outSampleRate);
+        }
+
+        if (result != FFmpegResult.Success)
+        {
+            var logMessage = $"Failed to initialize FFmpeg packet decoder for codec '{codecName}'. Result: {result}";
+            Log.Error(logMessage);
+            _handle.Dispose();
+            throw new FFmpegException(result, logMessage);
+        }
+
+        Channels = (int)outChannels;
+        SampleRate = (int)outSampleRate;
+    }
+
+    /// <summary>
+    /// Gets a value indicating whether this decoder has been disposed.
+    /// </summary>
+    public bool IsDisposed => _handle.IsClosed;
+
+    /// <summary>
+    /// Gets the number of channels in the decoded output.
+    /// </summary>
+    public int Channels { get; }
+
+    /// <summary>
+    /// Gets the sample rate of the decoded output.
+    /// </summary>
+    public int SampleRate { get; }
+
+    /// <summary>
+    /// Gets the number of packets currently waiting in the jitter buffer.
+    /// </summary>
+    public int BufferedPackets => GetStats().BufferedPackets;
+
+    /// <summary>
+    /// Gets the number of packets the jitter buffer currently holds back before playout.
+    /// </summary>
+    public int TargetDepth => GetStats().TargetDepth;
+
+    /// <summary>
+    /// Gets the number of frames synthesized to conceal missing packets.
+    /// </summary>
+    public long ConcealedFrames => GetStats().ConcealedFrames;
+
+    /// <summary>
+    /// Gets the number of packets dropped because they arrived after their slot was played.
+    /// </summary>
+    public long LatePackets => GetStats().LatePackets;
+
+    /// <summary>
+    /// Queues a compressed packet for decoding.
+    /// </summary>
+    /// <param name="packet">The packet payload.</param>
+    /// <param name="pts">The presentation timestamp in samples at <see cref="SampleRate"/>, or -1 to play the packet in arrival order.</param>
+    public unsafe void SendPacket(ReadOnlySpan<byte> packet, long pts)
+    {
+        ObjectDisposedException.ThrowIf(IsDisposed, this);
+        if (packet.IsEmpty) return;
+
+        fixed (byte* pPacket = packet)
+        {
+            var result = FFmpeg.SendPacket(_handle, (IntPtr)pPacket, packet.Length, pts);
+            if (result != FFmpegResult.Success)
+                throw new FFmpegException(result, $"Failed to queue a packet for decoding. Result: {result}");
+        }
+    }
+
+    /// <summary>
+    /// Decodes queued packets into interleaved 32-bit float samples.
+    /// </summary>
+    /// <param name="samples">The buffer to fill.</param>
+    /// <returns>The number of samples written, which is less than requested while the jitter buffer is filling.</returns>
+    public unsafe int Decode(Span<float> samples)
+    {
+        ObjectDisposedException.ThrowIf(IsDisposed, this);
+        if (samples.IsEmpty) return 0;
+
+        long framesRead;
+        fixed (float* pSamples = samples)
+        {
+            var result = FFmpeg.ReadPcmFrames(_handle, (IntPtr)pSamples, samples.Length / Channels, out framesRead);
+            if (result != FFmpegResult.Success)
+                throw new FFmpegException(result, $"An unrecoverable error occurred during decoding. Result: {result}");
+        }
+
+        return (int)framesRead * Channels;
+    }
+
+    private (int BufferedPackets, int TargetDepth, long ConcealedFrames, long LatePackets) GetStats()
+    {
+        ObjectDisposedException.ThrowIf(IsDisposed, this);
+        FFmpeg.GetJitterStats(_handle, out var buffered, out var targetDepth, out var concealed, out var late);
+        return (buffered, targetDepth, concealed, late);
+    }
+
+    /// <inheritdoc />
+    public void Dispose()
+    {
+        if (IsDisposed) return;
+        _handle.Dispose();
+    }
+}
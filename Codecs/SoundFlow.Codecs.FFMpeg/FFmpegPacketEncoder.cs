@@ -0,0 +1,157 @@
+﻿using SoundFlow.Codecs.FFMpeg.Enums;
+using SoundFlow.Codecs.FFMpeg.Exceptions;
+using SoundFlow.Codecs.FFMpeg.Native;
+using SoundFlow.Enums;
+using SoundFlow.Structs;
+using SoundFlow.Utils;
+
+namespace SoundFlow.Codecs.FFMpeg;
+
+/// <summary>
+/// Encodes raw PCM into individual compressed packets (e.g. Opus or AAC) without a container.
+/// </summary>
+/// <remarks>
+/// Unlike <see cref="FFmpegCodecFactory.CreateEncoder(Stream, string, AudioFormat)"/>, no muxer or I/O buffering is involved:
+/// each packet becomes available as soon as the codec produces it, ready to be framed into RTP, WebSocket messages or any
+/// other transport. Timestamps are expressed in samples at the encoded sample rate.
+/// </remarks>
+public sealed class FFmpegPacketEncoder : IDisposable
+{
+    private readonly SafeEncoderHandle _handle;
+    private readonly int _channels;
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="FFmpegPacketEncoder"/> class.
+    /// </summary>
+    /// <param name="codecName">The FFmpeg encoder name, e.g. "opus", "aac" or "libmp3lame".</param>
+    /// <param name="sourceFormat">The format of the 32-bit float PCM passed to <see cref="Encode"/>. Only the channel count and sample rate are used.</param>
+    /// <param name="targetFormat">The optional channel count and sample rate to encode at. Zero fields keep the source value.</param>
+    /// <param name="flags">Encoder behaviour flags, such as <see cref="FFmpegEncoderFlags.LowDelay"/>.</param>
+    /// <param name="codecOptions">
+    /// Optional codec options in FFmpeg's <c>key=value:key=value</c> form, e.g. <c>b=24000</c>, or <c>opus_delay=10</c> to
+    /// bound the native Opus encoder's packet duration in milliseconds. Options the codec does not recognise are rejected.
+    /// </param>
+    public FFmpegPacketEncoder(string codecName, AudioFormat sourceFormat, AudioFormat? targetFormat = null,
+        FFmpegEncoderFlags flags = FFmpegEncoderFlags.None, string? codecOptions = null)
+    {
+        _channels = sourceFormat.Channels;
+
+        _handle = FFmpeg.CreateEncoder();
+        if (_handle.IsInvalid)
+            throw new InvalidOperationException("Failed to create FFmpeg encoder handle.");
+
+        var result = FFmpeg.InitializeRawEncoder(_handle, codecName, SampleFormat.F32,
+            (uint)sourceFormat.Channels, (uint)sourceFormat.SampleRate,
+            (uint)(targetFormat?.Channels ?? 0), (uint)(targetFormat?.SampleRate ?? 0), flags, codecOptions);
+
+        if (result != FFmpegResult.Success)
+        {
+            var logMessage = $"Failed to initialize FFmpeg packet encoder for codec '{codecName}'. Result: {result}";
+            Log.Error(logMessage);
+            _handle.Dispose();
+            throw new FFmpegException(result, logMessage);
+        }
+
+        FrameSize = FFmpeg.GetEncoderFrameSize(_handle);
+        ExtraData = ReadExtraData();
+    }
+
+    /// <summary>
+    /// Gets a value indicating whether this encoder has been disposed.
+    /// </summary>
+    public bool IsDisposed => _handle.IsClosed;
+
+    /// <summary>
+    /// Gets the number of samples per channel in each encoded packet, or 0 if the codec accepts variable sizes.
+    /// </summary>
+    public int FrameSize { get; }
+
+    /// <summary>
+    /// Gets the codec's out-of-band configuration (e.g. the AAC AudioSpecificConfig or the Opus identification header),
+    /// which a receiver needs to construct a matching decoder. Empty if the codec has none.
+    /// </summary>
+    public byte[] ExtraData { get; }
+
+    /// <summary>
+    /// Feeds interleaved PCM samples to the encoder. Completed packets can then be retrieved with <see cref="TryReceivePacket"/>.
+    /// </summary>
+    /// <param name="samples">The interleaved samples to encode.</param>
+    /// <returns>
+    /// The number of samples consumed. This is 0 while 1024 encoded packets are waiting to be retrieved with
+    /// <see cref="TryReceivePacket"/>.
+    /// </returns>
+    public unsafe int Encode(ReadOnlySpan<float> samples)
+    {
+        ObjectDisposedException.ThrowIf(IsDisposed, this);
+        if (samples.IsEmpty) return 0;
+
+        long framesWritten;
+        fixed (float* pSamples = samples)
+        {
+            var result = FFmpeg.WritePcmFrames(_handle, (IntPtr)pSamples, samples.Length / _channels, out framesWritten);
+            if (result != FFmpegResult.Success)
+                throw new FFmpegException(result, $"An unrecoverable error occurred during encoding. Result: {result}");
+        }
+
+        return (int)framesWritten * _channels;
+    }
+
+    /// <summary>
+    /// Encodes any buffered samples and flushes the codec so the final packets become available.
+    /// No more samples can be encoded afterwards.
+    /// </summary>
+    public void Flush()
+    {
+        ObjectDisposedException.ThrowIf(IsDisposed, this);
+        var result = FFmpeg.FlushEncoder(_handle);
+        if (result != FFmpegResult.Success)
+            throw new FFmpegException(result, $"Failed to flush the encoder. Result: {result}");
+    }
+
+    /// <summary>
+    /// Retrieves the next encoded packet, if one is available.
+    /// </summary>
+    /// <param name="destination">The buffer to copy the packet into.</param>
+    /// <param name="bytesWritten">The size of the packet in bytes.</param>
+    /// <param name="pts">The presentation timestamp of the packet, in samples at the encoded sample rate.</param>
+    /// <param name="duration">The duration of the packet, in samples at the encoded sample rate.</param>
+    /// <returns><c>true</c> if a packet was copied; <c>false</c> if none is pending.</returns>
+    /// <exception cref="ArgumentException">The destination is smaller than the pending packet. The packet is kept for the next call.</exception>
+    public unsafe bool TryReceivePacket(Span<byte> destination, out int bytesWritten, out long pts, out long duration)
+    {
+        ObjectDisposedException.ThrowIf(IsDisposed, this);
+
+        FFmpegResult result;
+        fixed (byte* pDestination = destination)
+        {
+            result = FFmpeg.ReceivePacket(_handle, (IntPtr)pDestination, destination.Length, out bytesWritten, out pts, out duration);
+        }
+
+        if (result == FFmpegResult.EncoderErrorBufferTooSmall)
+            throw new ArgumentException($"The destination must hold at least {bytesWritten} bytes.", nameof(destination));
+        if (result != FFmpegResult.Success)
+            throw new FFmpegException(result, $"Failed to receive an encoded packet. Result: {result}");
+
+        return bytesWritten > 0;
+    }
+
+    private unsafe byte[] ReadExtraData()
+    {
+        var size = FFmpeg.GetEncoderExtraData(_handle, IntPtr.Zero, 0);
+        if (size <= 0) return [];
+
+        var extraData = new byte[size];
+        fixed (byte* pExtraData = extraData)
+        {
+            FFmpeg.GetEncoderExtraData(_handle, (IntPtr)pExtraData, size);
+        }
+        return extraData;
+    }
+
+    /// <inheritdoc />
+    public void Dispose()
+    {
+        if (IsDisposed) return;
+        _handle.Dispose();
+    }
+}
@@ -0,0 +1,45 @@
+﻿using SoundFlow.Codecs.FFMpeg.Enums;
+using SoundFlow.Codecs.FFMpeg.Exceptions;
+using SoundFlow.Codecs.FFMpeg.Native;
+
+namespace SoundFlow.Codecs.FFMpeg;
+
+/// <summary>
+/// A file that remembers, across runs, what probing found in each audio file opened by an <see cref="FFmpegCodecFactory"/>:
+/// the container format, codec parameters, duration and seek index. Files seen before open without being probed again,
+/// which makes reopening large libraries much faster. Only <see cref="FileStream"/> inputs are cached, keyed by their
+/// path, size, modification time and first bytes. The cache is process-wide and off until <see cref="Open"/> is called.
+/// </summary>
+public static class FFmpegProbeCache
+{
+    private static volatile bool _isOpen;
+
+    /// <summary>
+    /// Gets whether a cache file is open. Decoders skip the cache lookup, and the read of the file head it needs, while it is not.
+    /// </summary>
+    public static bool IsOpen => _isOpen;
+
+    /// <summary>
+    /// Opens the cache file at <paramref name="path"/>, creating it if needed, and closes any cache opened before.
+    /// A file written by a different FFmpeg build is started over.
+    /// </summary>
+    /// <param name="path">The path of the cache file.</param>
+    /// <exception cref="FFmpegException">The file could not be opened or created.</exception>
+    public static void Open(string path)
+    {
+        ArgumentNullException.ThrowIfNull(path);
+        var result = FFmpeg.OpenProbeCache(Path.GetFullPath(path));
+        _isOpen = result == FFmpegResult.Success;
+        if (result != FFmpegResult.Success)
+            throw new FFmpegException(result, $"Failed to open the FFmpeg probe cache '{path}'. Result: {result}");
+    }
+
+    /// <summary>
+    /// Closes the cache file. Decoders created afterwards probe their input as usual.
+    /// </summary>
+    public static void Close()
+    {
+        _isOpen = false;
+        FFmpeg.CloseProbeCache();
+    }
+}
@@ -0,0 +1,86 @@
+﻿using System.Runtime.InteropServices;
+using SoundFlow.Codecs.FFMpeg.Enums;
+using SoundFlow.Codecs.FFMpeg.Exceptions;
+using SoundFlow.Codecs.FFMpeg.Native;
+using SoundFlow.Utils;
+
+namespace SoundFlow.Codecs.FFMpeg;
+
+/// <summary>
+/// Copies compressed audio between containers without decoding or re-encoding it.
+/// </summary>
+/// <remarks>
+/// Stream copy is lossless and I/O bound. Trimming happens at packet boundaries, so the packets spanning a cut are kept
+/// whole, and concatenated segments must share the codec, sample rate, channel count and codec configuration.
+/// </remarks>
+public static class FFmpegRemuxer
+{
+    /// <summary>
+    /// Copies the audio of <paramref name="input"/>, optionally trimmed, into a new container.
+    /// </summary>
+    /// <param name="input">A readable stream containing the source audio.</param>
+    /// <param name="output">The stream to write the new container to.</param>
+    /// <param name="formatId">The output container, e.g. "mka", "mp3" or "mp4".</param>
+    /// <param name="startFrame">The first PCM frame to copy. 0 starts at the beginning.</param>
+    /// <param name="endFrame">The PCM frame to stop before. 0 copies to the end.</param>
+    /// <param name="muxerOptions">Optional muxer options in FFmpeg's <c>key=value:key=value</c> form.</param>
+    public static void Remux(Stream input, Stream output, string formatId, long startFrame = 0, long endFrame = 0,
+        string? muxerOptions = null)
+    {
+        Remux([new RemuxSegment(input, startFrame, endFrame)], output, formatId, muxerOptions);
+    }
+
+    /// <summary>
+    /// Concatenates the audio of several segments, each optionally trimmed, into a new container.
+    /// </summary>
+    /// <param name="segments">The segments to copy, in order.</param>
+    /// <param name="output">The stream to write the new container to.</param>
+    /// <param name="formatId">The output container, e.g. "mka", "mp3" or "mp4".</param>
+    /// <param name="muxerOptions">Optional muxer options in FFmpeg's <c>key=value:key=value</c> form.</param>
+    /// <exception cref="FFmpegException">A segment could not be read, is incompatible with the first one, or the output could not be written.</exception>
+    public static void Remux(IReadOnlyList<RemuxSegment> segments, Stream output, string formatId, string? muxerOptions = null)
+    {
+        ArgumentNullException.ThrowIfNull(segments);
+        ArgumentNullException.ThrowIfNull(output);
+        if (segments.Count == 0)
+            throw new ArgumentException("At least one segment is required.", nameof(segments));
+
+        var handles = new List<GCHandle>(segments.Count + 1);
+        try
+        {
+            var inputs = new RemuxInput[segments.Count];
+            for (var i = 0; i < segments.Count; i++)
+            {
+                var handle = GCHandle.Alloc(segments[i].Stream);
+                handles.Add(handle);
+                inputs[i] = new RemuxInput
+                {
+                    OnRead = Marshal.GetFunctionPointerForDelegate(StreamCallbacks.Read),
+                    OnSeek = Marshal.GetFunctionPointerForDelegate(StreamCallbacks.Seek),
+                    UserData = GCHandle.ToIntPtr(handle),
+                    StartFrame = segments[i].StartFrame,
+                    EndFrame = segments[i].EndFrame
+                };
+            }
+
+            var outputHandle = GCHandle.Alloc(output);
+            handles.Add(outputHandle);
+
+            var result = FFmpeg.Remux(inputs, inputs.Length, formatId, StreamCallbacks.Write,
+                output is { CanSeek: true, CanRead: true } ? StreamCallbacks.Read : null,
+                output.CanSeek ? StreamCallbacks.Seek : null,
+                GCHandle.ToIntPtr(outputHandle), muxerOptions);
+
+            if (result != FFmpegResult.Success)
+            {
+                var logMessage = $"Failed to remux {segments.Count} segment(s) to format '{formatId}'. Result: {result}";
+                Log.Error(logMessage);
+                throw new FFmpegException(result, logMessage);
+            }
+        }
+        finally
+        {
+            foreach (var handle in handles) handle.Free();
+        }
+    }
+}
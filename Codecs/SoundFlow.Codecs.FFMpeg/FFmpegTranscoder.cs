@@ -0,0 +1,144 @@
+﻿using System.Runtime.InteropServices;
+using SoundFlow.Codecs.FFMpeg.Enums;
+using SoundFlow.Codecs.FFMpeg.Exceptions;
+using SoundFlow.Codecs.FFMpeg.Native;
+using SoundFlow.Structs;
+using SoundFlow.Utils;
+
+namespace SoundFlow.Codecs.FFMpeg;
+
+/// <summary>
+/// Converts audio from one format to another in a single native call.
+/// </summary>
+/// <remarks>
+/// The decoder feeds the encoder directly inside the native library, so no samples cross into managed code.
+/// This is considerably cheaper than pairing an <see cref="FFmpegDecoder"/> with an <see cref="FFmpegEncoder"/>
+/// when the audio is not otherwise processed.
+/// </remarks>
+public static class FFmpegTranscoder
+{
+    /// <summary>
+    /// Transcodes <paramref name="input"/> into <paramref name="formatId"/>, writing the result to <paramref name="output"/>.
+    /// </summary>
+    /// <param name="input">A readable stream containing the source audio.</param>
+    /// <param name="output">The stream to write the encoded audio to.</param>
+    /// <param name="formatId">The output format, e.g. "mp3", "flac" or "opus".</param>
+    /// <param name="targetFormat">The optional channel count and sample rate to encode at. Zero fields keep the source value.</param>
+    /// <param name="gain">A linear gain applied to every sample before encoding.</param>
+    /// <param name="muxerOptions">Optional muxer options in FFmpeg's <c>key=value:key=value</c> form.</param>
+    /// <param name="progress">Receives the completed fraction, from 0 to 1, after each block. Not reported when the input length is unknown.</param>
+    /// <param name="cancellationToken">Stops the transcode; the output is finalised up to that point.</param>
+    /// <exception cref="OperationCanceledException">The transcode was cancelled.</exception>
+    /// <exception cref="FFmpegException">The input could not be decoded or the output could not be encoded.</exception>
+    public static void Transcode(Stream input, Stream output, string formatId, AudioFormat? targetFormat = null,
+        float gain = 1f, string? muxerOptions = null, IProgress<double>? progress = null,
+        CancellationToken cancellationToken = default)
+    {
+        ArgumentNullException.ThrowIfNull(input);
+        ArgumentNullException.ThrowIfNull(output);
+
+        FFmpeg.ProgressCallback? progressCallback = progress != null || cancellationToken.CanBeCanceled
+            ? (_, framesDone, totalFrames) =>
+            {
+                if (totalFrames > 0) progress?.Report(Math.Min(1.0, (double)framesDone / totalFrames));
+                return cancellationToken.IsCancellationRequested ? 1 : 0;
+            }
+            : null;
+
+        var inputHandle = GCHandle.Alloc(input);
+        var outputHandle = GCHandle.Alloc(output);
+        FFmpegResult result;
+        try
+        {
+            result = FFmpeg.Transcode(StreamCallbacks.Read, StreamCallbacks.Seek, GCHandle.ToIntPtr(inputHandle), formatId,
+                StreamCallbacks.Write,
+                output is { CanSeek: true, CanRead: true } ? StreamCallbacks.Read : null,
+                output.CanSeek ? StreamCallbacks.Seek : null,
+                GCHandle.ToIntPtr(outputHandle),
+                (uint)(targetFormat?.Channels ?? 0), (uint)(targetFormat?.SampleRate ?? 0), gain, muxerOptions,
+                progressCallback, IntPtr.Zero);
+            GC.KeepAlive(progressCallback);
+        }
+        finally
+        {
+            inputHandle.Free();
+            outputHandle.Free();
+        }
+
+        if (result == FFmpegResult.TranscodeCancelled)
+            throw new OperationCanceledException(cancellationToken);
+
+        if (result != FFmpegResult.Success)
+        {
+            var logMessage = $"Failed to transcode to format '{formatId}'. Result: {result}";
+            Log.Error(logMessage);
+            throw new FFmpegException(result, logMessage);
+        }
+    }
+
+    /// <summary>
+    /// Runs a batch of file conversions on a native worker pool and waits for all of them to finish.
+    /// </summary>
+    /// <param name="jobs">The conversions to run.</param>
+    /// <param name="workerCount">The number of worker threads, or 0 for one per CPU core.</param>
+    /// <param name="onJobCompleted">
+    /// Called with the job index and result as each job finishes. It runs on a native worker thread and must be thread-safe.
+    /// </param>
+    /// <returns>The result of each job, in the order of <paramref name="jobs"/>.</returns>
+    /// <remarks>
+    /// Files are read and written natively, so neither the garbage collector nor the interop layer is involved per block.
+    /// Each worker keeps its sample buffer from job to job; the FFmpeg format, codec and resampler contexts are opened
+    /// afresh for every file, since consecutive files can differ in format.
+    /// </remarks>
+    public static FFmpegResult[] TranscodeBatch(IReadOnlyList<TranscodeJob> jobs, int workerCount = 0,
+        Action<int, FFmpegResult>? onJobCompleted = null)
+    {
+        ArgumentNullException.ThrowIfNull(jobs);
+        var results = new FFmpegResult[jobs.Count];
+        if (jobs.Count == 0) return results;
+
+        var nativeJobs = new NativeTranscodeJob[jobs.Count];
+        try
+        {
+            for (var i = 0; i < jobs.Count; i++)
+            {
+                var job = jobs[i];
+                nativeJobs[i] = new NativeTranscodeJob
+                {
+                    InputPath = Marshal.StringToCoTaskMemUTF8(job.InputPath),
+                    OutputPath = Marshal.StringToCoTaskMemUTF8(job.OutputPath),
+                    FormatName = Marshal.StringToCoTaskMemUTF8(job.FormatId),
+                    TargetChannels = (uint)(job.TargetFormat?.Channels ?? 0),
+                    TargetSampleRate = (uint)(job.TargetFormat?.SampleRate ?? 0),
+                    Gain = job.Gain,
+                    MuxerOptions = job.MuxerOptions != null ? Marshal.StringToCoTaskMemUTF8(job.MuxerOptions) : IntPtr.Zero
+                };
+            }
+
+            FFmpeg.JobCompleteCallback? completeCallback = onJobCompleted != null
+                ? (_, jobIndex, result) => onJobCompleted(jobIndex, result)
+                : null;
+
+            var batchResult = FFmpeg.TranscodeBatch(nativeJobs, nativeJobs.Length, workerCount, IntPtr.Zero,
+                completeCallback, IntPtr.Zero, results);
+            GC.KeepAlive(completeCallback);
+
+            if (batchResult is not (FFmpegResult.Success or FFmpegResult.TranscodeJobFailed))
+                throw new FFmpegException(batchResult, $"Failed to start the batch transcode. Result: {batchResult}");
+            if (batchResult == FFmpegResult.TranscodeJobFailed)
+                Log.Warning($"{results.Count(r => r != FFmpegResult.Success)} of {jobs.Count} transcode jobs failed.");
+        }
+        finally
+        {
+            foreach (var job in nativeJobs)
+            {
+                Marshal.FreeCoTaskMem(job.InputPath);
+                Marshal.FreeCoTaskMem(job.OutputPath);
+                Marshal.FreeCoTaskMem(job.FormatName);
+                Marshal.FreeCoTaskMem(job.MuxerOptions);
+            }
+        }
+
+        return results;
+    }
+}
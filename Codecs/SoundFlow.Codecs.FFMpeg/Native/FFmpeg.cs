@@ -24,6 +24,48 @@ internal enum SeekWhence
     End = 2,
 }
 
+/// <summary>
+/// Mirrors the native SF_RemuxInput struct. The callbacks are unmanaged function pointers.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+internal struct RemuxInput
+{
+    public IntPtr OnRead;
+    public IntPtr OnSeek;
+    public IntPtr UserData;
+    public long StartFrame;
+    public long EndFrame;
+}
+
+/// <summary>
+/// Mirrors the native SF_TranscodeJob struct. The strings are unmanaged UTF-8 pointers.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+internal struct NativeTranscodeJob
+{
+    public IntPtr InputPath;
+    public IntPtr OutputPath;
+    public IntPtr FormatName;
+    public uint TargetChannels;
+    public uint TargetSampleRate;
+    public float Gain;
+    public IntPtr MuxerOptions;
+}
+
+/// <summary>
+/// Mirrors the native SF_CacheStats struct.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+internal struct NativeCacheStats
+{
+    public long Hits;
+    public long Misses;
+    public long Evictions;
+    public long Entries;
+    public long Bytes;
+    public long Budget;
+}
+
 /// <summary>
 /// Provides P/Invoke declarations for the native soundflow_ffmpeg library.
 /// </summary>
@@ -41,6 +83,12 @@ internal static partial class FFmpeg
 
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
     public delegate nuint WriteCallback(IntPtr pUserData, IntPtr pBuffer, nuint bytesToWrite);
+
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate int ProgressCallback(IntPtr pUserData, long framesDone, long totalFrames);
+
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void JobCompleteCallback(IntPtr pUserData, int jobIndex, FFmpegResult result);
     
     #endregion
     
@@ -187,15 +235,84 @@ internal static partial class FFmpeg
     public static partial FFmpegResult InitializeDecoder(SafeDecoderHandle decoder, ReadCallback onRead, SeekCallback onSeek, IntPtr pUserData,
         SampleFormat targetFormat, out SampleFormat outNativeFormat, out uint outChannels, out uint outSamplerate);
 
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_init_cached", StringMarshalling = StringMarshalling.Utf8)]
+    public static partial FFmpegResult InitializeDecoderCached(SafeDecoderHandle decoder, string? key, ReadCallback onRead, SeekCallback onSeek,
+        IntPtr pUserData, SampleFormat targetFormat, out SampleFormat outNativeFormat, out uint outChannels, out uint outSamplerate);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_cache_set_budget")]
+    public static partial void SetCacheBudget(long bytes);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_cache_clear")]
+    public static partial void ClearCache();
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_cache_get_stats")]
+    public static partial void GetCacheStats(out NativeCacheStats stats);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_probe_cache_open", StringMarshalling = StringMarshalling.Utf8)]
+    public static partial FFmpegResult OpenProbeCache(string path);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_probe_cache_close")]
+    public static partial void CloseProbeCache();
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_init_probe_cached", StringMarshalling = StringMarshalling.Utf8)]
+    public static partial FFmpegResult InitializeDecoderProbeCached(SafeDecoderHandle decoder, string key, ReadCallback onRead, SeekCallback onSeek,
+        IntPtr pUserData, SampleFormat targetFormat, out SampleFormat outNativeFormat, out uint outChannels, out uint outSamplerate);
+
     [LibraryImport(LibraryName, EntryPoint = "sf_decoder_get_length_in_pcm_frames")]
     public static partial long GetLengthInPcmFrames(SafeDecoderHandle decoder);
 
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_get_length_info")]
+    public static partial long GetLengthInfo(SafeDecoderHandle decoder, out FFmpegDurationSource source);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_scan_length")]
+    public static partial FFmpegResult ScanLength(SafeDecoderHandle decoder, out long frames);
+
     [LibraryImport(LibraryName, EntryPoint = "sf_decoder_read_pcm_frames")]
     public static partial FFmpegResult ReadPcmFrames(SafeDecoderHandle decoder, IntPtr pFramesOut, long frameCount, out long outFramesRead);
 
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_set_planar")]
+    public static partial FFmpegResult SetPlanar(SafeDecoderHandle decoder, int planar);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_read_pcm_frames_planar")]
+    public static partial FFmpegResult ReadPcmFramesPlanar(SafeDecoderHandle decoder, IntPtr pChannelsOut, long frameCount, out long outFramesRead);
+
     [LibraryImport(LibraryName, EntryPoint = "sf_decoder_seek_to_pcm_frame")]
     public static partial FFmpegResult SeekToPcmFrame(SafeDecoderHandle decoder, long frameIndex);
 
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_set_range")]
+    public static partial FFmpegResult SetRange(SafeDecoderHandle decoder, long startFrame, long endFrame, int loop);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_set_reverse")]
+    public static partial FFmpegResult SetReverse(SafeDecoderHandle decoder, int reverse);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_analyze_silence")]
+    public static partial FFmpegResult AnalyzeSilence(SafeDecoderHandle decoder, float thresholdDb, int holdMs,
+        out long firstFrame, out long lastFrame);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_trim_silence")]
+    public static partial FFmpegResult TrimSilence(SafeDecoderHandle decoder, float thresholdDb, int holdMs,
+        out long firstFrame, out long lastFrame);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_set_gapless")]
+    public static partial FFmpegResult SetGapless(SafeDecoderHandle decoder, int gapless);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_chain")]
+    public static partial FFmpegResult Chain(SafeDecoderHandle decoder, SafeDecoderHandle next);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_chain")]
+    public static partial FFmpegResult Unchain(SafeDecoderHandle decoder, IntPtr next);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_init_raw", StringMarshalling = StringMarshalling.Utf8)]
+    public static partial FFmpegResult InitializeRawDecoder(SafeDecoderHandle decoder, string codecName, IntPtr pExtraData, int extraDataSize,
+        uint channels, uint sampleRate, int jitterDepth, SampleFormat targetFormat, out SampleFormat outNativeFormat, out uint outChannels, out uint outSampleRate);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_send_packet")]
+    public static partial FFmpegResult SendPacket(SafeDecoderHandle decoder, IntPtr pData, int size, long pts);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_decoder_get_jitter_stats")]
+    public static partial FFmpegResult GetJitterStats(SafeDecoderHandle decoder, out int outBufferedPackets, out int outTargetDepth,
+        out long outConcealedFrames, out long outLatePackets);
+
     [LibraryImport(LibraryName, EntryPoint = "sf_decoder_free")]
     public static partial void FreeDecoder(IntPtr decoder);
 
@@ -207,17 +324,56 @@ internal static partial class FFmpeg
     public static partial SafeEncoderHandle CreateEncoder();
 
     [LibraryImport(LibraryName, EntryPoint = "sf_encoder_init", StringMarshalling = StringMarshalling.Utf8)]
-    public static partial FFmpegResult InitializeEncoder(SafeEncoderHandle encoder, string formatName, WriteCallback onWrite, IntPtr pUserData,
-        SampleFormat sampleFormat, uint channels, uint sampleRate);
+    public static partial FFmpegResult InitializeEncoder(SafeEncoderHandle encoder, string formatName, WriteCallback onWrite,
+        ReadCallback? onRead, SeekCallback? onSeek, IntPtr pUserData, SampleFormat sampleFormat, uint channels, uint sampleRate,
+        uint targetChannels, uint targetSampleRate, string? muxerOptions);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_encoder_init_raw", StringMarshalling = StringMarshalling.Utf8)]
+    public static partial FFmpegResult InitializeRawEncoder(SafeEncoderHandle encoder, string codecName, SampleFormat sampleFormat,
+        uint channels, uint sampleRate, uint targetChannels, uint targetSampleRate, FFmpegEncoderFlags flags, string? codecOptions);
 
     [LibraryImport(LibraryName, EntryPoint = "sf_encoder_write_pcm_frames")]
     public static partial FFmpegResult WritePcmFrames(SafeEncoderHandle encoder, IntPtr pFramesIn, long frameCount, out long outFramesWritten);
 
+    [LibraryImport(LibraryName, EntryPoint = "sf_encoder_flush")]
+    public static partial FFmpegResult FlushEncoder(SafeEncoderHandle encoder);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_encoder_receive_packet")]
+    public static partial FFmpegResult ReceivePacket(SafeEncoderHandle encoder, IntPtr pPacketOut, int capacity,
+        out int outSize, out long outPts, out long outDuration);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_encoder_get_extradata")]
+    public static partial int GetEncoderExtraData(SafeEncoderHandle encoder, IntPtr pOut, int capacity);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_encoder_get_frame_size")]
+    public static partial int GetEncoderFrameSize(SafeEncoderHandle encoder);
+
     [LibraryImport(LibraryName, EntryPoint = "sf_encoder_free")]
     public static partial void FreeEncoder(IntPtr encoder);
 
     #endregion
 
+    #region Remux Functions
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_remux", StringMarshalling = StringMarshalling.Utf8)]
+    public static partial FFmpegResult Remux(RemuxInput[] inputs, int inputCount, string formatName, WriteCallback onWrite,
+        ReadCallback? onRead, SeekCallback? onSeek, IntPtr pUserData, string? muxerOptions);
+
+    #endregion
+
+    #region Transcode Functions
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_transcode", StringMarshalling = StringMarshalling.Utf8)]
+    public static partial FFmpegResult Transcode(ReadCallback onRead, SeekCallback onSeek, IntPtr pInputUserData, string formatName,
+        WriteCallback onWrite, ReadCallback? onOutputRead, SeekCallback? onOutputSeek, IntPtr pOutputUserData,
+        uint targetChannels, uint targetSampleRate, float gain, string? muxerOptions, ProgressCallback? onProgress, IntPtr pProgressUserData);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_transcode_batch")]
+    public static partial FFmpegResult TranscodeBatch(NativeTranscodeJob[] jobs, int jobCount, int workerCount, IntPtr onProgress,
+        JobCompleteCallback? onComplete, IntPtr pUserData, [Out] FFmpegResult[] outResults);
+
+    #endregion
+
     #region Helper Functions
     
     [LibraryImport(LibraryName, EntryPoint = "sf_result_to_string")]
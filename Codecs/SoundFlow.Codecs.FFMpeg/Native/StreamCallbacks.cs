@@ -0,0 +1,60 @@
+﻿using System.Runtime.InteropServices;
+using SoundFlow.Utils;
+
+namespace SoundFlow.Codecs.FFMpeg.Native;
+
+/// <summary>
+/// Native I/O callbacks for one-shot operations that take several streams at once.
+/// The user data pointer is a <see cref="GCHandle"/> to the <see cref="Stream"/> being accessed,
+/// so a single set of delegates serves every call.
+/// </summary>
+internal static class StreamCallbacks
+{
+    public static readonly FFmpeg.ReadCallback Read = OnRead;
+    public static readonly FFmpeg.SeekCallback Seek = OnSeek;
+    public static readonly FFmpeg.WriteCallback Write = OnWrite;
+
+    private static unsafe nuint OnRead(IntPtr pUserData, IntPtr pBuffer, nuint bytesToRead)
+    {
+        try
+        {
+            var stream = (Stream)GCHandle.FromIntPtr(pUserData).Target!;
+            return (nuint)stream.Read(new Span<byte>((void*)pBuffer, (int)bytesToRead));
+        }
+        catch
+        {
+            Log.Critical("Failed to read from stream.");
+            return 0;
+        }
+    }
+
+    private static unsafe nuint OnWrite(IntPtr pUserData, IntPtr pBuffer, nuint bytesToWrite)
+    {
+        try
+        {
+            var stream = (Stream)GCHandle.FromIntPtr(pUserData).Target!;
+            stream.Write(new ReadOnlySpan<byte>((void*)pBuffer, (int)bytesToWrite));
+            return bytesToWrite;
+        }
+        catch
+        {
+            Log.Critical("Failed to write to stream.");
+            return 0;
+        }
+    }
+
+    private static long OnSeek(IntPtr pUserData, long offset, SeekWhence whence)
+    {
+        try
+        {
+            var stream = (Stream)GCHandle.FromIntPtr(pUserData).Target!;
+            if (!stream.CanSeek) return -1;
+            return stream.Seek(offset, (SeekOrigin)whence);
+        }
+        catch
+        {
+            Log.Critical("Failed to seek stream.");
+            return -1;
+        }
+    }
+}
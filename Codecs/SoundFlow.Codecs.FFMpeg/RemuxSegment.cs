@@ -0,0 +1,9 @@
+﻿namespace SoundFlow.Codecs.FFMpeg;
+
+/// <summary>
+/// One input of <see cref="FFmpegRemuxer"/>: a readable stream and the range of it to copy.
+/// </summary>
+/// <param name="Stream">A readable stream containing the compressed audio.</param>
+/// <param name="StartFrame">The first PCM frame to copy, at the input's sample rate. 0 starts at the beginning.</param>
+/// <param name="EndFrame">The PCM frame to stop before, at the input's sample rate. 0 copies to the end.</param>
+public readonly record struct RemuxSegment(Stream Stream, long StartFrame = 0, long EndFrame = 0);
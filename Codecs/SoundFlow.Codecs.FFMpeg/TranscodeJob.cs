@@ -0,0 +1,20 @@
+﻿using SoundFlow.Structs;
+
+namespace SoundFlow.Codecs.FFMpeg;
+
+/// <summary>
+/// One file conversion in a <see cref="FFmpegTranscoder.TranscodeBatch"/> call.
+/// </summary>
+/// <param name="InputPath">The path of the file to decode.</param>
+/// <param name="OutputPath">The path of the file to create. An existing file is overwritten.</param>
+/// <param name="FormatId">The output format, e.g. "mp3", "flac" or "opus".</param>
+/// <param name="TargetFormat">The optional channel count and sample rate to encode at. Zero fields keep the source value.</param>
+/// <param name="Gain">A linear gain applied to every sample before encoding.</param>
+/// <param name="MuxerOptions">Optional muxer options in FFmpeg's <c>key=value:key=value</c> form.</param>
+public readonly record struct TranscodeJob(
+    string InputPath,
+    string OutputPath,
+    string FormatId,
+    AudioFormat? TargetFormat = null,
+    float Gain = 1f,
+    string? MuxerOptions = null);
@@ -1,20 +1,139 @@
+﻿// 64-bit file offsets for the batch engine's stdio callbacks on 32-bit targets.
+#define _FILE_OFFSET_BITS 64
+
 #include "soundflow-ffmpeg.h"
 
 #include <libavcodec/avcodec.h>
+#include <libavcodec/bsf.h>
 #include <libavformat/avformat.h>
 #include <libavutil/opt.h>
+#include <libavutil/avstring.h>
 #include <libavutil/channel_layout.h>
 #include <libavutil/audio_fifo.h>
+#include <libavutil/fifo.h>
 #include <libavutil/mathematics.h>
+#include <libavutil/cpu.h>
+#include <libavutil/intreadwrite.h>
+#include <libavutil/time.h>
 #include <libswresample/swresample.h>
+#include <math.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SF_HAVE_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SF_HAVE_NEON 1
+#endif
+
 #define IO_BUFFER_SIZE 32768
+// Length of the pre-decoded loop head kept by sf_decoder_set_range.
+#define LOOP_HEAD_MS 500
+// Length of the blocks decoded and reversed at a time in reverse mode.
+#define REVERSE_BLOCK_MS 1000
+// Frames decoded per read by the silence analyser.
+#define SILENCE_SCAN_FRAMES 4096
+// Dips below the silence threshold shorter than this (zero crossings, brief pauses) do not end a stretch of sound.
+#define SILENCE_GAP_MS 50
+// Length of the next decoder's head pre-decoded by sf_decoder_chain.
+#define CHAIN_HEAD_MS 500
+#define CACHE_BUCKETS 256
+#define CACHE_DEFAULT_BUDGET (64 * 1024 * 1024)
+// Bytes at the start of a file hashed into its probe cache key, so rewritten files miss even with an unchanged size and mtime.
+#define PROBE_HEAD_BYTES 4096
+// Seek index entries kept per probe record; longer indexes are thinned evenly.
+#define PROBE_INDEX_MAX 512
+#define PROBE_FILE_VERSION 1
+// Encoded packets a raw encoder holds for sf_encoder_receive_packet before it stops accepting input.
+#define RAW_PACKET_QUEUE_MAX 1024
 
 // Internal Structs
 
+// Reorders packets by PTS (in samples) before they reach the codec. Packets that are
+// still missing when their turn comes are declared lost and concealed.
+typedef struct {
+    AVPacket** packets;        // Sorted by PTS, oldest first.
+    int capacity;
+    int count;
+    int min_depth;
+    int target_depth;          // Packets to hold before playout; grows on late packets and underruns.
+    int buffering;             // Waiting for target_depth packets before (re)starting playout.
+    int stable_packets;        // Packets played since the target depth last changed.
+    int64_t next_pts;          // PTS of the next expected packet, AV_NOPTS_VALUE until the first one plays.
+    AVFrame* plc_frame;        // Copy of the last decoded frame, the source for concealment.
+    int plc_count;             // Consecutive concealed frames.
+    int64_t concealed_frames;
+    int64_t late_packets;
+} SF_JitterBuffer;
+
+// A fully decoded asset in the process-wide cache. Immutable once published; freed when the last reference goes.
+typedef struct SF_CacheEntry {
+    _Atomic(struct SF_CacheEntry*) next; // Bucket chain. Changed under cache_lock, walked without it.
+    struct SF_CacheEntry* retired_next;  // Retired list, under cache_lock.
+    uint64_t hash;
+    char* key;                           // The caller's key, or NULL when keyed by content hash.
+    enum AVSampleFormat format;
+    int channels;
+    int sample_rate;
+    SFSampleFormat native_format;
+    uint8_t* pcm;
+    int64_t frames;
+    int64_t bytes;
+    atomic_int refs;                     // One for being in the cache, one per decoder reading it.
+    atomic_llong last_used;              // Time of the last hit, for LRU eviction.
+} SF_CacheEntry;
+
+// A probe cache record: what avformat_find_stream_info learned about a file. Stored as is in the cache file,
+// followed by index_count SF_ProbeIndexEntry and extradata_size bytes of extradata, padded to 8 bytes.
+typedef struct {
+    uint32_t size;               // Whole record, trailing data and padding included.
+    uint32_t checksum;           // Over the bytes after this field; a torn or foreign record fails it.
+    uint64_t key_hash;
+    uint64_t head_hash;
+    char format_name[32];        // Demuxer short name, opened directly on a hit instead of probing.
+    int32_t stream_index;
+    int32_t codec_id;
+    int32_t sample_format;
+    int32_t sample_rate;
+    int32_t channels;
+    int32_t frame_size;
+    uint64_t channel_mask;       // 0 when the layout is not a native channel mask.
+    int32_t block_align;
+    int32_t initial_padding;
+    int32_t trailing_padding;
+    int32_t seek_preroll;
+    int64_t bit_rate;
+    int32_t time_base_num;       // The stream time base start_time, duration and the index are in.
+    int32_t time_base_den;
+    int64_t start_time;
+    int64_t duration;
+    int64_t format_duration;     // In AV_TIME_BASE units.
+    int32_t extradata_size;
+    int32_t index_count;
+} SF_ProbeRecord;
+
+typedef struct {
+    int64_t pos;
+    int64_t timestamp;
+    int32_t size;
+    int32_t min_distance;
+    int32_t flags;
+    int32_t reserved;
+} SF_ProbeIndexEntry;
+
 struct SF_Decoder {
     AVFormatContext* format_ctx;
     AVCodecContext* codec_ctx;
@@ -29,6 +148,45 @@ struct SF_Decoder {
     void* pUserData;
     int target_bytes_per_sample;
     int target_channels;
+    enum AVSampleFormat target_av_format;
+    int64_t position;            // Index of the next frame returned to the caller.
+    int length_scanned;          // scanned_length holds the result of sf_decoder_scan_length.
+    int64_t scanned_length;
+    int64_t skip_until;          // After a seek, decoded frames before this index are dropped; -1 otherwise.
+    // Playback range (sf_decoder_set_range).
+    int range_set;
+    int range_loop;
+    int64_t range_start;
+    int64_t range_end;           // 0 to play to the end of the stream.
+    uint8_t* loop_head;          // Frames pre-decoded from range_start, spliced in on every wrap.
+    int64_t loop_head_frames;
+    int64_t loop_head_pos;       // Read position in loop_head, or -1 when not serving from it.
+    int loop_resume_pending;     // Seek to range_start + loop_head_frames once loop_head is used up.
+    // Reverse mode (sf_decoder_set_reverse): the next frame returned is position - 1.
+    int reverse;
+    uint8_t* reverse_block;      // Decoded frames in reverse order, the last one first.
+    int64_t reverse_capacity;
+    int64_t reverse_block_start; // Index of the earliest frame in reverse_block.
+    int64_t reverse_block_frames;
+    // Gapless mode (sf_decoder_set_gapless): the encoder delay and padding lie outside [base_start, base_end).
+    // Public frame indices are relative to base_start.
+    int gapless;
+    int64_t base_start;          // Index of the first real frame; 0 unless gapless.
+    int64_t base_end;            // Index after the last real frame, or 0 when the stream's own end marks it.
+    int64_t gapless_delay;
+    int64_t gapless_padding;
+    // Planar mode (sf_decoder_set_planar): the resampler writes one buffer per channel.
+    int planar;
+    // Chaining (sf_decoder_chain): reads continue into next once this stream ends.
+    SF_Decoder* next;
+    uint8_t* chain_head;         // The first frames of next, decoded when it was chained.
+    int64_t chain_head_frames;
+    int64_t chain_head_pos;
+    int chain_handed_over;       // This stream has ended; reads are served from chain_head, then next.
+    // Cache hit (sf_decoder_init_cached): no FFmpeg state, reads are served from the entry's memory.
+    SF_CacheEntry* cache_entry;
+    // Raw packet mode (sf_decoder_init_raw): no demuxer, packets arrive through sf_decoder_send_packet.
+    SF_JitterBuffer* jitter;
 };
 
 struct SF_Encoder {
@@ -43,7 +201,19 @@ struct SF_Encoder {
     uint8_t* io_buffer;
     AVAudioFifo* fifo;
     sf_write_callback onWrite;
+    sf_read_callback onRead;
+    sf_seek_callback onSeek;
     void* pUserData;
+    // Byte positions used to share one user stream between the write context and
+    // the read-back context a muxer may open when finalising (e.g. mov faststart).
+    // All are relative to io_base_pos, where the user stream stood when the encoder was initialised.
+    int64_t io_base_pos;
+    int64_t io_stream_pos;
+    int64_t io_write_pos;
+    int64_t io_read_pos;
+    int io_stream_writing;  // Direction of the last transfer on the user stream, -1 after a seek.
+    AVFifo* raw_packets;  // Queue of AVPacket* when encoding without a muxer, NULL otherwise.
+    int finished;
     int64_t next_pts;
     SFSampleFormat input_format;
     uint32_t input_sample_rate;
@@ -98,16 +268,291 @@ static int64_t seek_callback_wrapper(void* opaque, int64_t offset, int whence) {
     return decoder->onSeek(decoder->pUserData, offset, whence);
 }
 
+// Moves the user stream to an absolute position if another I/O context left it elsewhere. A change of direction
+// always seeks, even in place: a stdio stream opened for update must not switch between reading and writing without.
+static int encoder_sync_stream_pos(SF_Encoder* encoder, int64_t pos, int writing) {
+    if (encoder->io_stream_pos == pos && (encoder->io_stream_writing == writing || encoder->io_stream_writing < 0)) {
+        encoder->io_stream_writing = writing;
+        return 0;
+    }
+    if (!encoder->onSeek || encoder->onSeek(encoder->pUserData, encoder->io_base_pos + pos, SEEK_SET) < 0) return AVERROR(EIO);
+    encoder->io_stream_pos = pos;
+    encoder->io_stream_writing = writing;
+    return 0;
+}
+
 static int write_packet_callback(void* opaque, const uint8_t* buf, int buf_size) {
     SF_Encoder* encoder = (SF_Encoder*)opaque;
+    if (encoder_sync_stream_pos(encoder, encoder->io_write_pos, 1) < 0) return AVERROR(EIO);
+
     size_t bytes_written = encoder->onWrite(encoder->pUserData, (void*)buf, buf_size);
     if (bytes_written < buf_size) {
         // Signal an I/O error to FFmpeg if the write was incomplete.
         return AVERROR(EIO);
     }
+    encoder->io_write_pos += (int64_t)bytes_written;
+    encoder->io_stream_pos = encoder->io_write_pos;
     return (int)bytes_written;
 }
 
+static int64_t encoder_seek_user_stream(SF_Encoder* encoder, int64_t offset, int whence) {
+    whence &= ~AVSEEK_FORCE;
+    // The size is unknown to the write context; muxers only need absolute seeks.
+    if (whence == AVSEEK_SIZE) return -1;
+    if (whence == SEEK_SET) offset += encoder->io_base_pos;
+    int64_t pos = encoder->onSeek(encoder->pUserData, offset, whence);
+    if (pos < 0) return pos;
+    pos -= encoder->io_base_pos;
+    encoder->io_stream_pos = pos;
+    encoder->io_stream_writing = -1;
+    return pos;
+}
+
+static int64_t encoder_write_seek_callback(void* opaque, int64_t offset, int whence) {
+    SF_Encoder* encoder = (SF_Encoder*)opaque;
+    // Relative seeks are resolved against this context's own position, not the shared stream.
+    if ((whence & ~AVSEEK_FORCE) == SEEK_CUR) { offset += encoder->io_write_pos; whence = SEEK_SET; }
+    int64_t pos = encoder_seek_user_stream(encoder, offset, whence);
+    if (pos >= 0) encoder->io_write_pos = pos;
+    return pos;
+}
+
+static int encoder_read_packet_callback(void* opaque, uint8_t* buf, int buf_size) {
+    SF_Encoder* encoder = (SF_Encoder*)opaque;
+    if (encoder_sync_stream_pos(encoder, encoder->io_read_pos, 0) < 0) return AVERROR(EIO);
+
+    size_t bytes_read = encoder->onRead(encoder->pUserData, buf, buf_size);
+    if (bytes_read == 0) return AVERROR_EOF;
+    encoder->io_read_pos += (int64_t)bytes_read;
+    encoder->io_stream_pos = encoder->io_read_pos;
+    return (int)bytes_read;
+}
+
+static int64_t encoder_read_seek_callback(void* opaque, int64_t offset, int whence) {
+    SF_Encoder* encoder = (SF_Encoder*)opaque;
+    if ((whence & ~AVSEEK_FORCE) == SEEK_CUR) { offset += encoder->io_read_pos; whence = SEEK_SET; }
+    int64_t pos = encoder_seek_user_stream(encoder, offset, whence);
+    if (pos >= 0) encoder->io_read_pos = pos;
+    return pos;
+}
+
+// Muxers that move data while finalising (mov/mp4 faststart) re-open the output for reading.
+// With custom I/O there is no URL, so the request is served from the user's read callback.
+static int encoder_io_open(AVFormatContext* s, AVIOContext** pb, const char* url, int flags, AVDictionary** options) {
+    SF_Encoder* encoder = (SF_Encoder*)s->opaque;
+    (void)url; (void)options;
+    if (!encoder || !encoder->onRead || !encoder->onSeek || (flags & AVIO_FLAG_WRITE)) return AVERROR(ENOSYS);
+
+    uint8_t* buffer = (uint8_t*)av_malloc(IO_BUFFER_SIZE);
+    if (!buffer) return AVERROR(ENOMEM);
+
+    encoder->io_read_pos = 0;
+    *pb = avio_alloc_context(buffer, IO_BUFFER_SIZE, 0, encoder, encoder_read_packet_callback, NULL, encoder_read_seek_callback);
+    if (!*pb) { av_free(buffer); return AVERROR(ENOMEM); }
+    return 0;
+}
+
+static int encoder_io_close(AVFormatContext* s, AVIOContext* pb) {
+    (void)s;
+    if (!pb) return 0;
+    av_freep(&pb->buffer);
+    avio_context_free(&pb);
+    return 0;
+}
+
+
+// Decoded PCM Cache
+//
+// Lookups take no lock. Bucket chains are atomic pointers, and a hit takes its reference with a compare-and-swap that
+// fails once the entry's count has reached zero. Writers (insertion, eviction, clearing) serialise on cache_lock and
+// retire what they unlink instead of releasing it: before dropping the cache's reference they advance the epoch and
+// wait for the lookups that entered under the old one, so no reader can still be walking into a reclaimed entry.
+// Readers never wait for writers. Decoders holding their own reference keep an evicted entry alive; the last release
+// frees it.
+
+static struct {
+    _Atomic(SF_CacheEntry*) buckets[CACHE_BUCKETS];
+    atomic_uint epoch;
+    atomic_int readers[2];    // Lookups in flight, by the parity of the epoch they entered under.
+    SF_CacheEntry* retired;   // Unlinked entries waiting for the lookups that may still see them, under cache_lock.
+    atomic_llong hits;
+    atomic_llong misses;
+    atomic_llong evictions;
+    int64_t entries;  // Writer-side, under cache_lock.
+    int64_t bytes;
+    int64_t budget;
+} g_cache = { .budget = CACHE_DEFAULT_BUDGET };
+
+#ifdef _WIN32
+static SRWLOCK g_cache_lock = SRWLOCK_INIT;
+static void cache_lock(void) { AcquireSRWLockExclusive(&g_cache_lock); }
+static void cache_unlock(void) { ReleaseSRWLockExclusive(&g_cache_lock); }
+static void cache_yield(void) { SwitchToThread(); }
+#else
+static pthread_mutex_t g_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static void cache_lock(void) { pthread_mutex_lock(&g_cache_lock); }
+static void cache_unlock(void) { pthread_mutex_unlock(&g_cache_lock); }
+static void cache_yield(void) { sched_yield(); }
+#endif
+
+// FNV-1a, continuing from hash.
+static uint64_t cache_hash_bytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#define CACHE_HASH_SEED 0xcbf29ce484222325ULL
+
+static void cache_entry_release(SF_CacheEntry* entry) {
+    if (!entry || atomic_fetch_sub(&entry->refs, 1) != 1) return;
+    av_free(entry->pcm);
+    av_free(entry->key);
+    av_free(entry);
+}
+
+static int cache_entry_matches(const SF_CacheEntry* entry, uint64_t hash, const char* key, enum AVSampleFormat format) {
+    if (entry->hash != hash || entry->format != format) return 0;
+    if (!key || !entry->key) return !key && !entry->key;
+    return strcmp(entry->key, key) == 0;
+}
+
+// Counts the calling lookup under the current epoch and returns the slot to leave. Retries if a writer advanced the
+// epoch in between, since that writer may not have waited for this slot.
+static unsigned cache_read_enter(void) {
+    for (;;) {
+        unsigned epoch = atomic_load(&g_cache.epoch);
+        atomic_fetch_add(&g_cache.readers[epoch & 1], 1);
+        if (atomic_load(&g_cache.epoch) == epoch) return epoch & 1;
+        atomic_fetch_sub(&g_cache.readers[epoch & 1], 1);
+    }
+}
+
+static void cache_read_leave(unsigned slot) {
+    atomic_fetch_sub(&g_cache.readers[slot], 1);
+}
+
+// Returns the entry with a reference taken, or NULL.
+static SF_CacheEntry* cache_lookup(uint64_t hash, const char* key, enum AVSampleFormat format) {
+    const unsigned slot = cache_read_enter();
+    SF_CacheEntry* found = NULL;
+    for (SF_CacheEntry* entry = atomic_load(&g_cache.buckets[hash % CACHE_BUCKETS]); entry; entry = atomic_load(&entry->next)) {
+        if (!cache_entry_matches(entry, hash, key, format)) continue;
+        int refs = atomic_load(&entry->refs);
+        while (refs > 0 && !atomic_compare_exchange_weak(&entry->refs, &refs, refs + 1)) {}
+        if (refs > 0) {
+            atomic_store(&entry->last_used, av_gettime_relative());
+            found = entry;
+        }
+        break;
+    }
+    cache_read_leave(slot);
+    return found;
+}
+
+// Under cache_lock. Unlinks the entry and retires it; cache_reclaim drops the cache's reference later. The entry's
+// own next link is left intact for lookups that are standing on it.
+static void cache_unlink(SF_CacheEntry* entry) {
+    _Atomic(SF_CacheEntry*)* link = &g_cache.buckets[entry->hash % CACHE_BUCKETS];
+    while (atomic_load(link) != entry) link = &atomic_load(link)->next;
+    atomic_store(link, atomic_load(&entry->next));
+
+    g_cache.entries--;
+    g_cache.bytes -= entry->bytes;
+    entry->retired_next = g_cache.retired;
+    g_cache.retired = entry;
+}
+
+// Under cache_lock. Advances the epoch, waits for the lookups that entered under the previous one, then drops the
+// cache's reference to every retired entry. Lookups that enter afterwards cannot reach them.
+static void cache_reclaim(void) {
+    if (!g_cache.retired) return;
+    const unsigned slot = atomic_fetch_add(&g_cache.epoch, 1) & 1;
+    while (atomic_load(&g_cache.readers[slot]) != 0) cache_yield();
+
+    SF_CacheEntry* entry = g_cache.retired;
+    g_cache.retired = NULL;
+    while (entry) {
+        SF_CacheEntry* next = entry->retired_next;
+        cache_entry_release(entry);
+        entry = next;
+    }
+}
+
+// Under cache_lock. Evicts least recently used entries until size more bytes fit in the budget. Chains only change
+// under cache_lock, so the walk sees a stable list.
+static void cache_evict_for(int64_t size) {
+    while (g_cache.entries > 0 && g_cache.bytes + size > g_cache.budget) {
+        SF_CacheEntry* oldest = NULL;
+        for (int b = 0; b < CACHE_BUCKETS; b++) {
+            for (SF_CacheEntry* entry = atomic_load(&g_cache.buckets[b]); entry; entry = atomic_load(&entry->next)) {
+                if (!oldest || atomic_load(&entry->last_used) < atomic_load(&oldest->last_used)) oldest = entry;
+            }
+        }
+        cache_unlink(oldest);
+        atomic_fetch_add(&g_cache.evictions, 1);
+    }
+}
+
+// Publishes a new entry, which must carry one reference for the caller. If an equivalent entry was published
+// meanwhile, the new one is dropped and the existing one returned (referenced) instead.
+static SF_CacheEntry* cache_insert(SF_CacheEntry* entry) {
+    cache_lock();
+    SF_CacheEntry* existing = cache_lookup(entry->hash, entry->key, entry->format);
+    if (existing) {
+        cache_unlock();
+        cache_entry_release(entry);
+        return existing;
+    }
+
+    if (entry->bytes <= g_cache.budget) {
+        cache_evict_for(entry->bytes);
+        atomic_fetch_add(&entry->refs, 1);
+        atomic_store(&entry->last_used, av_gettime_relative());
+        _Atomic(SF_CacheEntry*)* head = &g_cache.buckets[entry->hash % CACHE_BUCKETS];
+        atomic_store(&entry->next, atomic_load(head));
+        atomic_store(head, entry);
+        g_cache.entries++;
+        g_cache.bytes += entry->bytes;
+        cache_reclaim();
+    }
+    cache_unlock();
+    return entry;
+}
+
+SF_FFMPEG_API void sf_cache_set_budget(int64_t bytes) {
+    cache_lock();
+    g_cache.budget = FFMAX(0, bytes);
+    cache_evict_for(0);
+    cache_reclaim();
+    cache_unlock();
+}
+
+SF_FFMPEG_API void sf_cache_clear(void) {
+    cache_lock();
+    for (int b = 0; b < CACHE_BUCKETS; b++) {
+        SF_CacheEntry* entry;
+        while ((entry = atomic_load(&g_cache.buckets[b]))) cache_unlink(entry);
+    }
+    cache_reclaim();
+    cache_unlock();
+}
+
+SF_FFMPEG_API void sf_cache_get_stats(SF_CacheStats* out_stats) {
+    if (!out_stats) return;
+    out_stats->hits = atomic_load(&g_cache.hits);
+    out_stats->misses = atomic_load(&g_cache.misses);
+    out_stats->evictions = atomic_load(&g_cache.evictions);
+    cache_lock();
+    out_stats->entries = g_cache.entries;
+    out_stats->bytes = g_cache.bytes;
+    out_stats->budget = g_cache.budget;
+    cache_unlock();
+}
+
 
 //  Decoder Implementation
 
@@ -115,14 +560,118 @@ SF_FFMPEG_API SF_Decoder* sf_decoder_create() {
     return (SF_Decoder*)calloc(1, sizeof(SF_Decoder));
 }
 
-SF_FFMPEG_API SF_Result sf_decoder_init(SF_Decoder* decoder, sf_read_callback onRead, sf_seek_callback onSeek, void* pUserData,
-                                        SFSampleFormat target_format, SFSampleFormat* out_native_format,
-                                        uint32_t* out_channels, uint32_t* out_samplerate) {
-    if (!decoder) return SF_RESULT_ERROR_INVALID_ARGS;
+static const SF_ProbeIndexEntry* probe_record_index(const SF_ProbeRecord* record) {
+    return (const SF_ProbeIndexEntry*)(record + 1);
+}
 
-    // Set FFmpeg to only log errors
-    av_log_set_level(AV_LOG_ERROR);
+static const uint8_t* probe_record_extradata(const SF_ProbeRecord* record) {
+    return (const uint8_t*)(probe_record_index(record) + record->index_count);
+}
+
+// Restores a probe record onto a freshly opened demuxer in place of avformat_find_stream_info. Parameters the
+// demuxer's header already supplied are kept. Returns 0 when the stream does not look like the recorded one.
+static int probe_record_apply(AVFormatContext* format_ctx, const SF_ProbeRecord* record) {
+    if (record->stream_index < 0 || (unsigned int)record->stream_index >= format_ctx->nb_streams) return 0;
+    AVStream* stream = format_ctx->streams[record->stream_index];
+    AVCodecParameters* par = stream->codecpar;
+    if (par->codec_type != AVMEDIA_TYPE_AUDIO || par->codec_id != (enum AVCodecID)record->codec_id) return 0;
+
+    if (par->format < 0) par->format = record->sample_format;
+    if (par->sample_rate <= 0) par->sample_rate = record->sample_rate;
+    if (par->ch_layout.nb_channels <= 0) {
+        av_channel_layout_uninit(&par->ch_layout);
+        if (record->channel_mask) av_channel_layout_from_mask(&par->ch_layout, record->channel_mask);
+        else av_channel_layout_default(&par->ch_layout, record->channels);
+    }
+    if (par->frame_size <= 0) par->frame_size = record->frame_size;
+    if (par->block_align <= 0) par->block_align = record->block_align;
+    if (par->initial_padding <= 0) par->initial_padding = record->initial_padding;
+    if (par->trailing_padding <= 0) par->trailing_padding = record->trailing_padding;
+    if (par->seek_preroll <= 0) par->seek_preroll = record->seek_preroll;
+    if (par->bit_rate <= 0) par->bit_rate = record->bit_rate;
+
+    if (par->extradata_size <= 0 && record->extradata_size > 0) {
+        av_freep(&par->extradata);
+        par->extradata = (uint8_t*)av_mallocz(record->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+        if (!par->extradata) return 0;
+        memcpy(par->extradata, probe_record_extradata(record), record->extradata_size);
+        par->extradata_size = record->extradata_size;
+    }
+
+    // Timestamps are only reused in the time base they were recorded in.
+    if (stream->time_base.num == record->time_base_num && stream->time_base.den == record->time_base_den) {
+        if (stream->start_time == AV_NOPTS_VALUE) stream->start_time = record->start_time;
+        if (stream->duration == AV_NOPTS_VALUE) stream->duration = record->duration;
+        if (avformat_index_get_entries_count(stream) == 0) {
+            const SF_ProbeIndexEntry* index = probe_record_index(record);
+            for (int i = 0; i < record->index_count; i++) {
+                av_add_index_entry(stream, index[i].pos, index[i].timestamp, index[i].size, index[i].min_distance, index[i].flags);
+            }
+        }
+    }
+    if (format_ctx->duration == AV_NOPTS_VALUE) format_ctx->duration = record->format_duration;
+    return 1;
+}
+
+// Captures the probed parameters of the selected stream as a record for the cache file.
+static SF_ProbeRecord* probe_record_build(AVFormatContext* format_ctx, int stream_index, uint64_t key_hash, uint64_t head_hash) {
+    AVStream* stream = format_ctx->streams[stream_index];
+    AVCodecParameters* par = stream->codecpar;
+    int index_total = avformat_index_get_entries_count(stream);
+    int index_count = FFMIN(index_total, PROBE_INDEX_MAX);
+    int extradata_size = FFMAX(par->extradata_size, 0);
+
+    size_t size = sizeof(SF_ProbeRecord) + (size_t)index_count * sizeof(SF_ProbeIndexEntry) + (size_t)extradata_size;
+    size = (size + 7) & ~(size_t)7;
+    SF_ProbeRecord* record = (SF_ProbeRecord*)av_mallocz(size);
+    if (!record) return NULL;
+
+    record->size = (uint32_t)size;
+    record->key_hash = key_hash;
+    record->head_hash = head_hash;
+    // Demuxers answer to their first name; av_find_input_format does not match the full comma-separated list.
+    const char* name = format_ctx->iformat->name;
+    size_t name_length = strcspn(name, ",");
+    if (name_length >= sizeof(record->format_name)) { av_free(record); return NULL; }
+    memcpy(record->format_name, name, name_length);
+
+    record->stream_index = stream_index;
+    record->codec_id = par->codec_id;
+    record->sample_format = par->format;
+    record->sample_rate = par->sample_rate;
+    record->channels = par->ch_layout.nb_channels;
+    record->channel_mask = par->ch_layout.order == AV_CHANNEL_ORDER_NATIVE ? par->ch_layout.u.mask : 0;
+    record->frame_size = par->frame_size;
+    record->block_align = par->block_align;
+    record->initial_padding = par->initial_padding;
+    record->trailing_padding = par->trailing_padding;
+    record->seek_preroll = par->seek_preroll;
+    record->bit_rate = par->bit_rate;
+    record->time_base_num = stream->time_base.num;
+    record->time_base_den = stream->time_base.den;
+    record->start_time = stream->start_time;
+    record->duration = stream->duration;
+    record->format_duration = format_ctx->duration;
+    record->extradata_size = extradata_size;
+    record->index_count = index_count;
+
+    SF_ProbeIndexEntry* index = (SF_ProbeIndexEntry*)(record + 1);
+    for (int i = 0; i < index_count; i++) {
+        const AVIndexEntry* entry = avformat_index_get_entry(stream, (int)((int64_t)i * index_total / index_count));
+        index[i].pos = entry->pos;
+        index[i].timestamp = entry->timestamp;
+        index[i].size = entry->size;
+        index[i].min_distance = entry->min_distance;
+        index[i].flags = entry->flags;
+    }
+    if (extradata_size) memcpy(index + index_count, par->extradata, extradata_size);
+    return record;
+}
 
+// Opens the demuxer on the user's stream and selects the best audio stream, discarding the others.
+// With a probe record the recorded demuxer is opened directly and stream probing is skipped.
+static SF_Result decoder_open_input(SF_Decoder* decoder, sf_read_callback onRead, sf_seek_callback onSeek, void* pUserData,
+                                    const SF_ProbeRecord* probe) {
     decoder->onRead = onRead;
     decoder->onSeek = onSeek;
     decoder->pUserData = pUserData;
@@ -142,11 +691,17 @@ SF_FFMPEG_API SF_Result sf_decoder_init(SF_Decoder* decoder, sf_read_callback on
     av_dict_set(&options, "probesize", "5000000", 0);
     av_dict_set(&options, "analyzeduration", "10000000", 0);
 
-    if (avformat_open_input(&decoder->format_ctx, NULL, NULL, &options) != 0) return SF_RESULT_DECODER_ERROR_OPEN_INPUT;
-    if (avformat_find_stream_info(decoder->format_ctx, NULL) < 0) return SF_RESULT_DECODER_ERROR_FIND_STREAM_INFO;
+    const AVInputFormat* input_format = probe ? av_find_input_format(probe->format_name) : NULL;
+    if (avformat_open_input(&decoder->format_ctx, NULL, input_format, &options) != 0) return SF_RESULT_DECODER_ERROR_OPEN_INPUT;
+
+    if (input_format && probe_record_apply(decoder->format_ctx, probe)) {
+        decoder->stream_index = probe->stream_index;
+    } else {
+        if (avformat_find_stream_info(decoder->format_ctx, NULL) < 0) return SF_RESULT_DECODER_ERROR_FIND_STREAM_INFO;
 
-    decoder->stream_index = av_find_best_stream(decoder->format_ctx, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0);
-    if (decoder->stream_index < 0) return SF_RESULT_DECODER_ERROR_NO_AUDIO_STREAM;
+        decoder->stream_index = av_find_best_stream(decoder->format_ctx, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0);
+        if (decoder->stream_index < 0) return SF_RESULT_DECODER_ERROR_NO_AUDIO_STREAM;
+    }
 
     // Ignore all non-audio streams
     for (unsigned int i = 0; i < decoder->format_ctx->nb_streams; i++) {
@@ -155,15 +710,38 @@ SF_FFMPEG_API SF_Result sf_decoder_init(SF_Decoder* decoder, sf_read_callback on
         }
     }
 
+    return SF_RESULT_SUCCESS;
+}
+
+// (Re)opens the codec for the selected stream with the given AV_CODEC_FLAG2_* flags.
+static SF_Result decoder_open_codec(SF_Decoder* decoder, int flags2) {
     AVStream* stream = decoder->format_ctx->streams[decoder->stream_index];
     const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
     if (!codec) return SF_RESULT_DECODER_ERROR_CODEC_NOT_FOUND;
 
+    avcodec_free_context(&decoder->codec_ctx);
     decoder->codec_ctx = avcodec_alloc_context3(codec);
     if (!decoder->codec_ctx) return SF_RESULT_DECODER_ERROR_CODEC_CONTEXT_ALLOC;
 
     avcodec_parameters_to_context(decoder->codec_ctx, stream->codecpar);
+    decoder->codec_ctx->flags2 |= flags2;
     if (avcodec_open2(decoder->codec_ctx, codec, NULL) < 0) return SF_RESULT_DECODER_ERROR_CODEC_OPEN_FAILED;
+    return SF_RESULT_SUCCESS;
+}
+
+static SF_Result decoder_init(SF_Decoder* decoder, sf_read_callback onRead, sf_seek_callback onSeek, void* pUserData,
+                              const SF_ProbeRecord* probe, SFSampleFormat target_format, SFSampleFormat* out_native_format,
+                              uint32_t* out_channels, uint32_t* out_samplerate) {
+    if (!decoder) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    // Set FFmpeg to only log errors
+    av_log_set_level(AV_LOG_ERROR);
+
+    SF_Result result = decoder_open_input(decoder, onRead, onSeek, pUserData, probe);
+    if (result != SF_RESULT_SUCCESS) return result;
+
+    result = decoder_open_codec(decoder, 0);
+    if (result != SF_RESULT_SUCCESS) return result;
 
     *out_channels = decoder->codec_ctx->ch_layout.nb_channels;
     *out_samplerate = decoder->codec_ctx->sample_rate;
@@ -172,8 +750,11 @@ SF_FFMPEG_API SF_Result sf_decoder_init(SF_Decoder* decoder, sf_read_callback on
     enum AVSampleFormat target_av_format = to_ffmpeg_sample_format(target_format);
     if (target_av_format == AV_SAMPLE_FMT_NONE) return SF_RESULT_DECODER_ERROR_INVALID_TARGET_FORMAT;
 
+    decoder->target_av_format = target_av_format;
     decoder->target_bytes_per_sample = av_get_bytes_per_sample(target_av_format);
     decoder->target_channels = decoder->codec_ctx->ch_layout.nb_channels;
+    decoder->skip_until = -1;
+    decoder->loop_head_pos = -1;
 
     // Setup resampler to convert from native format to the requested target format
     swr_alloc_set_opts2(&decoder->swr_ctx,
@@ -189,113 +770,210 @@ SF_FFMPEG_API SF_Result sf_decoder_init(SF_Decoder* decoder, sf_read_callback on
     return SF_RESULT_SUCCESS;
 }
 
-SF_FFMPEG_API int64_t sf_decoder_get_length_in_pcm_frames(SF_Decoder* decoder) {
-    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0) return -1;
-    AVStream* stream = decoder->format_ctx->streams[decoder->stream_index];
-    if (stream->duration != AV_NOPTS_VALUE) {
-        return av_rescale_q(stream->duration, stream->time_base, (AVRational){1, stream->codecpar->sample_rate});
+SF_FFMPEG_API SF_Result sf_decoder_init(SF_Decoder* decoder, sf_read_callback onRead, sf_seek_callback onSeek, void* pUserData,
+                                        SFSampleFormat target_format, SFSampleFormat* out_native_format,
+                                        uint32_t* out_channels, uint32_t* out_samplerate) {
+    return decoder_init(decoder, onRead, onSeek, pUserData, NULL, target_format, out_native_format, out_channels, out_samplerate);
+}
+
+// Raw Packet Decoding
+
+#define JITTER_DEFAULT_DEPTH 2
+#define JITTER_MAX_PACKETS 64
+// Packets played without a late arrival or underrun before the target depth shrinks by one.
+#define JITTER_STABLE_PACKETS 500
+// Concealed frames per gap; the fade reaches silence on the last one.
+#define PLC_MAX_FRAMES 4
+
+static void jitter_free(SF_JitterBuffer* jitter) {
+    if (!jitter) return;
+    for (int i = 0; i < jitter->count; i++) {
+        av_packet_free(&jitter->packets[i]);
     }
-    // Fallback for formats without duration info (e.g. WAV)
-    if (decoder->format_ctx->duration != AV_NOPTS_VALUE) {
-        return av_rescale(decoder->format_ctx->duration, AV_TIME_BASE, stream->codecpar->sample_rate);
+    av_free(jitter->packets);
+    av_frame_free(&jitter->plc_frame);
+    av_free(jitter);
+}
+
+static SF_JitterBuffer* jitter_alloc(int min_depth) {
+    SF_JitterBuffer* jitter = (SF_JitterBuffer*)av_mallocz(sizeof(SF_JitterBuffer));
+    if (!jitter) return NULL;
+
+    jitter->min_depth = min_depth > 0 ? min_depth : JITTER_DEFAULT_DEPTH;
+    jitter->capacity = FFMAX(JITTER_MAX_PACKETS, jitter->min_depth * 4);
+    jitter->packets = (AVPacket**)av_calloc(jitter->capacity, sizeof(AVPacket*));
+    jitter->plc_frame = av_frame_alloc();
+    if (!jitter->packets || !jitter->plc_frame) {
+        jitter_free(jitter);
+        return NULL;
+    }
+
+    jitter->target_depth = jitter->min_depth;
+    jitter->buffering = 1;
+    jitter->next_pts = AV_NOPTS_VALUE;
+    return jitter;
+}
+
+static void jitter_adjust_depth(SF_JitterBuffer* jitter, int delta) {
+    jitter->target_depth = av_clip(jitter->target_depth + delta, jitter->min_depth, jitter->capacity / 2);
+    jitter->stable_packets = 0;
+}
+
+static AVPacket* jitter_pop(SF_JitterBuffer* jitter) {
+    AVPacket* packet = jitter->packets[0];
+    jitter->count--;
+    memmove(jitter->packets, jitter->packets + 1, jitter->count * sizeof(AVPacket*));
+    return packet;
+}
+
+// Builds nb_samples of concealment by repeating the last decoded frame under a linear fade.
+static int plc_build_frame(AVFrame* dst, const AVFrame* src, int nb_samples, float start_gain, float end_gain) {
+    dst->format = src->format;
+    dst->sample_rate = src->sample_rate;
+    dst->nb_samples = nb_samples;
+    if (av_channel_layout_copy(&dst->ch_layout, &src->ch_layout) < 0) return -1;
+    if (av_frame_get_buffer(dst, 0) < 0) return -1;
+
+    enum AVSampleFormat fmt = av_get_packed_sample_fmt((enum AVSampleFormat)src->format);
+    int planar = av_sample_fmt_is_planar((enum AVSampleFormat)src->format);
+    int planes = planar ? src->ch_layout.nb_channels : 1;
+    int stride = planar ? 1 : src->ch_layout.nb_channels;
+    int count = nb_samples * stride;
+    int src_count = src->nb_samples * stride;
+    float step = (end_gain - start_gain) / nb_samples;
+
+    for (int p = 0; p < planes; p++) {
+        const uint8_t* in = src->extended_data[p];
+        uint8_t* out = dst->extended_data[p];
+        for (int i = 0; i < count; i++) {
+            float gain = start_gain + step * (i / stride);
+            int s = i % src_count;
+            switch (fmt) {
+                case AV_SAMPLE_FMT_U8:  out[i] = (uint8_t)(128 + (in[s] - 128) * gain); break;
+                case AV_SAMPLE_FMT_S16: ((int16_t*)out)[i] = (int16_t)(((const int16_t*)in)[s] * gain); break;
+                case AV_SAMPLE_FMT_S32: ((int32_t*)out)[i] = (int32_t)(((const int32_t*)in)[s] * (double)gain); break;
+                case AV_SAMPLE_FMT_S64: ((int64_t*)out)[i] = (int64_t)(((const int64_t*)in)[s] * (double)gain); break;
+                case AV_SAMPLE_FMT_FLT: ((float*)out)[i] = ((const float*)in)[s] * gain; break;
+                case AV_SAMPLE_FMT_DBL: ((double*)out)[i] = ((const double*)in)[s] * gain; break;
+                default: return -1;
+            }
+        }
     }
     return 0;
 }
 
-SF_FFMPEG_API SF_Result sf_decoder_read_pcm_frames(SF_Decoder* decoder, void* pFramesOut, int64_t frameCount, int64_t* out_frames_read) {
-    if (!decoder || !pFramesOut || !out_frames_read || frameCount <= 0) return SF_RESULT_ERROR_INVALID_ARGS;
+// Converts a decoded frame into the caller's buffer. In raw mode the resampler is created on the
+// first frame, since the codec may only report its output layout once it has decoded something.
+static int decoder_convert_frame(SF_Decoder* decoder, uint8_t** out_ptr, int capacity, const AVFrame* frame) {
+    if (!decoder->swr_ctx) {
+        AVChannelLayout out_layout;
+        av_channel_layout_default(&out_layout, decoder->target_channels);
+        swr_alloc_set_opts2(&decoder->swr_ctx,
+                            &out_layout, decoder->target_av_format, frame->sample_rate,
+                            &frame->ch_layout, (enum AVSampleFormat)frame->format, frame->sample_rate,
+                            0, NULL);
+        av_channel_layout_uninit(&out_layout);
+        if (!decoder->swr_ctx || swr_init(decoder->swr_ctx) < 0) {
+            swr_free(&decoder->swr_ctx);
+            return AVERROR(EINVAL);
+        }
+    }
 
-    *out_frames_read = 0;
+    int out_samples = swr_convert(decoder->swr_ctx, out_ptr, capacity, (const uint8_t**)frame->extended_data, frame->nb_samples);
+    if (out_samples > 0) {
+        *out_ptr += out_samples * decoder->target_channels * decoder->target_bytes_per_sample;
+    }
+    return out_samples;
+}
+
+static SF_Result jitter_read_pcm_frames(SF_Decoder* decoder, void* pFramesOut, int64_t frameCount, int64_t* out_frames_read) {
+    SF_JitterBuffer* jitter = decoder->jitter;
     uint8_t* out_ptr[] = { (uint8_t*)pFramesOut };
     int64_t frames_read = 0;
-    int draining = 0;
+    *out_frames_read = 0;
 
     while (frames_read < frameCount) {
-        // Check if the resampler has data buffered from previous calls.
-        if (swr_get_out_samples(decoder->swr_ctx, 0) > 0) {
-            // Call swr_convert with NULL input to flush/read buffered data
-            int out_samples = swr_convert(decoder->swr_ctx,
-                                         out_ptr,
-                                         (int)(frameCount - frames_read),
-                                         NULL, 0);
-
+        // Samples the resampler held back from earlier frames come first.
+        if (decoder->swr_ctx && swr_get_out_samples(decoder->swr_ctx, 0) > 0) {
+            int out_samples = swr_convert(decoder->swr_ctx, out_ptr, (int)(frameCount - frames_read), NULL, 0);
             if (out_samples > 0) {
                 out_ptr[0] += out_samples * decoder->target_channels * decoder->target_bytes_per_sample;
                 frames_read += out_samples;
-
-                // If we filled the user buffer, we are done for this call.
-                if (frames_read >= frameCount) break;
+                continue;
             }
         }
 
-        // Try to receive a decoded frame
+        // Everything the codec produced for the previous packet is drained before the next one is
+        // chosen, so next_pts is exact when the jitter buffer looks for a gap.
         int ret = avcodec_receive_frame(decoder->codec_ctx, decoder->frame);
-
         if (ret == 0) {
-            // Resample the frame to target format
-            int out_samples = swr_convert(decoder->swr_ctx,
-                                         out_ptr,
-                                         (int)(frameCount - frames_read),
-                                         (const uint8_t**)decoder->frame->data,
-                                         decoder->frame->nb_samples);
+            if (jitter->next_pts != AV_NOPTS_VALUE) jitter->next_pts += decoder->frame->nb_samples;
+            av_frame_unref(jitter->plc_frame);
+            av_frame_ref(jitter->plc_frame, decoder->frame);
+            jitter->plc_count = 0;
 
-            if (out_samples > 0) {
-                out_ptr[0] += out_samples * decoder->target_channels * decoder->target_bytes_per_sample;
-                frames_read += out_samples;
-            }
+            int out_samples = decoder_convert_frame(decoder, out_ptr, (int)(frameCount - frames_read), decoder->frame);
             av_frame_unref(decoder->frame);
+            if (out_samples < 0) {
+                *out_frames_read = frames_read;
+                return SF_RESULT_DECODER_ERROR_RESAMPLER_INIT_FAILED;
+            }
+            frames_read += out_samples;
             continue;
         }
-        else if (ret == AVERROR_EOF) {
-            // Drain the resampler completely
-            int flushed_samples;
-            do {
-                flushed_samples = swr_convert(decoder->swr_ctx,
-                                             out_ptr,
-                                             (int)(frameCount - frames_read),
-                                             NULL, 0);
-                if (flushed_samples > 0) {
-                    out_ptr[0] += flushed_samples * decoder->target_channels * decoder->target_bytes_per_sample;
-                    frames_read += flushed_samples;
-                }
-            } while (flushed_samples > 0 && frames_read < frameCount);
-
-            // End of stream is not an error, break loop and return success.
-            break;
-        }
-        else if (ret != AVERROR(EAGAIN)) {
-            // A unrecoverable decoding error occurred.
+        if (ret != AVERROR(EAGAIN)) {
             *out_frames_read = frames_read;
             return SF_RESULT_DECODER_ERROR_DECODING_FAILED;
         }
 
-        // If we need more input data (ret == AVERROR(EAGAIN))
-        if (draining) {
-            // We are draining and still need more data, which means we are done.
+        if (jitter->buffering) {
+            if (jitter->count < jitter->target_depth) break;
+            jitter->buffering = 0;
+        }
+        if (jitter->count == 0) {
+            // Underrun: packets are arriving later than the buffer allows for, so rebuild a deeper cushion.
+            jitter->buffering = 1;
+            jitter_adjust_depth(jitter, 1);
             break;
         }
 
-        // Read a new packet from the stream
-        av_packet_unref(decoder->packet);
-        int read_ret = av_read_frame(decoder->format_ctx, decoder->packet);
-
-        if (read_ret == 0) {
-            if (decoder->packet->stream_index == decoder->stream_index) {
-                if (avcodec_send_packet(decoder->codec_ctx, decoder->packet) < 0) {
-                    av_packet_unref(decoder->packet);
-                    *out_frames_read = frames_read;
-                    return SF_RESULT_DECODER_ERROR_DECODING_FAILED;
-                }
+        AVPacket* head = jitter->packets[0];
+        if (head->pts != AV_NOPTS_VALUE && jitter->next_pts != AV_NOPTS_VALUE && head->pts > jitter->next_pts &&
+            jitter->plc_frame->nb_samples > 0 && jitter->plc_count < PLC_MAX_FRAMES) {
+            // The packet due now never arrived. Conceal one frame of the gap; after PLC_MAX_FRAMES the
+            // fade has reached silence and playout resyncs to the next packet that did arrive.
+            int nb_samples = (int)FFMIN(head->pts - jitter->next_pts, jitter->plc_frame->nb_samples);
+            float start_gain = 1.0f - (float)jitter->plc_count / PLC_MAX_FRAMES;
+            float end_gain = 1.0f - (float)(jitter->plc_count + 1) / PLC_MAX_FRAMES;
+
+            AVFrame* conceal = av_frame_alloc();
+            if (!conceal || plc_build_frame(conceal, jitter->plc_frame, nb_samples, start_gain, end_gain) < 0) {
+                av_frame_free(&conceal);
+                *out_frames_read = frames_read;
+                return SF_RESULT_ERROR_ALLOCATION_FAILED;
             }
-            av_packet_unref(decoder->packet);
-        }
-        else if (read_ret == AVERROR_EOF) {
-            // Reached end of stream, start draining process by sending a NULL packet.
-            avcodec_send_packet(decoder->codec_ctx, NULL);
-            draining = 1;
+            int out_samples = decoder_convert_frame(decoder, out_ptr, (int)(frameCount - frames_read), conceal);
+            av_frame_free(&conceal);
+            if (out_samples < 0) {
+                *out_frames_read = frames_read;
+                return SF_RESULT_DECODER_ERROR_RESAMPLER_INIT_FAILED;
+            }
+
+            frames_read += out_samples;
+            jitter->next_pts += nb_samples;
+            jitter->plc_count++;
+            jitter->concealed_frames++;
+            continue;
         }
-        else {
-            // A read error occurred.
+
+        head = jitter_pop(jitter);
+        if (head->pts != AV_NOPTS_VALUE) jitter->next_pts = head->pts;
+        if (++jitter->stable_packets >= JITTER_STABLE_PACKETS) jitter_adjust_depth(jitter, -1);
+
+        ret = avcodec_send_packet(decoder->codec_ctx, head);
+        av_packet_free(&head);
+        // A corrupt packet produces no output and is concealed like a lost one.
+        if (ret < 0 && ret != AVERROR_INVALIDDATA) {
             *out_frames_read = frames_read;
             return SF_RESULT_DECODER_ERROR_DECODING_FAILED;
         }
@@ -305,60 +983,1109 @@ SF_FFMPEG_API SF_Result sf_decoder_read_pcm_frames(SF_Decoder* decoder, void* pF
     return SF_RESULT_SUCCESS;
 }
 
-SF_FFMPEG_API SF_Result sf_decoder_seek_to_pcm_frame(SF_Decoder* decoder, int64_t frameIndex) {
-    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0) return SF_RESULT_ERROR_INVALID_ARGS;
-
-    AVStream* stream = decoder->format_ctx->streams[decoder->stream_index];
-    int64_t timestamp = av_rescale_q(frameIndex, (AVRational){1, stream->codecpar->sample_rate}, stream->time_base);
+SF_FFMPEG_API SF_Result sf_decoder_init_raw(SF_Decoder* decoder, const char* codec_name,
+                                            const void* pExtraData, int32_t extraDataSize,
+                                            uint32_t channels, uint32_t sampleRate, int32_t jitterDepth,
+                                            SFSampleFormat target_format, SFSampleFormat* out_native_format,
+                                            uint32_t* out_channels, uint32_t* out_samplerate) {
+    if (!decoder || !codec_name || extraDataSize < 0 || (extraDataSize > 0 && !pExtraData)) return SF_RESULT_ERROR_INVALID_ARGS;
 
-    // Flush buffers and seek
-    avcodec_flush_buffers(decoder->codec_ctx);
-    swr_init(decoder->swr_ctx);  // Reset resampler state
+    // Set FFmpeg to only log errors
+    av_log_set_level(AV_LOG_ERROR);
 
-    int ret = av_seek_frame(decoder->format_ctx, decoder->stream_index, timestamp, AVSEEK_FLAG_BACKWARD);
-    if (ret < 0) {
-        return SF_RESULT_DECODER_ERROR_SEEK_FAILED;
-    }
+    decoder->stream_index = -1;
 
-    // Read and discard packets until we reach the desired position
-    AVPacket* pkt = av_packet_alloc();
-    while (av_read_frame(decoder->format_ctx, pkt) >= 0) {
-        if (pkt->stream_index == decoder->stream_index) {
-            av_packet_unref(pkt);
-            break;
-        }
-        av_packet_unref(pkt);
-    }
-    av_packet_free(&pkt);
+    const AVCodec* codec = avcodec_find_decoder_by_name(codec_name);
+    if (!codec) return SF_RESULT_DECODER_ERROR_CODEC_NOT_FOUND;
 
-    return SF_RESULT_SUCCESS;
-}
+    decoder->codec_ctx = avcodec_alloc_context3(codec);
+    if (!decoder->codec_ctx) return SF_RESULT_DECODER_ERROR_CODEC_CONTEXT_ALLOC;
 
-SF_FFMPEG_API void sf_decoder_free(SF_Decoder* decoder) {
-    if (!decoder) return;
-    avcodec_free_context(&decoder->codec_ctx);
+    if (channels > 0) av_channel_layout_default(&decoder->codec_ctx->ch_layout, (int)channels);
+    decoder->codec_ctx->sample_rate = (int)sampleRate;
+    if (sampleRate > 0) decoder->codec_ctx->pkt_timebase = (AVRational){1, (int)sampleRate};
 
-    // Custom IO context needs special handling for freeing
-    if (decoder->format_ctx) {
-        if (decoder->format_ctx->pb) {
-            av_freep(&decoder->format_ctx->pb->buffer);
-            avio_context_free(&decoder->format_ctx->pb);
-        }
-        avformat_close_input(&decoder->format_ctx);
+    if (extraDataSize > 0) {
+        decoder->codec_ctx->extradata = (uint8_t*)av_mallocz(extraDataSize + AV_INPUT_BUFFER_PADDING_SIZE);
+        if (!decoder->codec_ctx->extradata) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+        memcpy(decoder->codec_ctx->extradata, pExtraData, extraDataSize);
+        decoder->codec_ctx->extradata_size = extraDataSize;
     }
 
-    av_packet_free(&decoder->packet);
-    av_frame_free(&decoder->frame);
-    swr_free(&decoder->swr_ctx);
-    free(decoder);
-}
-
+    if (avcodec_open2(decoder->codec_ctx, codec, NULL) < 0) return SF_RESULT_DECODER_ERROR_CODEC_OPEN_FAILED;
 
-// Encoder Implementation
+    // Without a container the layout and rate must come from the caller or the extradata.
+    if (decoder->codec_ctx->ch_layout.nb_channels <= 0 || decoder->codec_ctx->sample_rate <= 0) return SF_RESULT_ERROR_INVALID_ARGS;
 
-SF_FFMPEG_API SF_Encoder* sf_encoder_create() {
-    return (SF_Encoder*)calloc(1, sizeof(SF_Encoder));
-}
+    *out_channels = decoder->codec_ctx->ch_layout.nb_channels;
+    *out_samplerate = decoder->codec_ctx->sample_rate;
+    *out_native_format = from_ffmpeg_sample_format(decoder->codec_ctx->sample_fmt);
+
+    enum AVSampleFormat target_av_format = to_ffmpeg_sample_format(target_format);
+    if (target_av_format == AV_SAMPLE_FMT_NONE) return SF_RESULT_DECODER_ERROR_INVALID_TARGET_FORMAT;
+
+    decoder->target_av_format = target_av_format;
+    decoder->target_bytes_per_sample = av_get_bytes_per_sample(target_av_format);
+    decoder->target_channels = decoder->codec_ctx->ch_layout.nb_channels;
+
+    decoder->packet = av_packet_alloc();
+    decoder->frame = av_frame_alloc();
+    if (!decoder->packet || !decoder->frame) return SF_RESULT_DECODER_ERROR_PACKET_FRAME_ALLOC;
+
+    decoder->jitter = jitter_alloc(jitterDepth);
+    if (!decoder->jitter) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+
+    return SF_RESULT_SUCCESS;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_send_packet(SF_Decoder* decoder, const void* pData, int32_t size, int64_t pts) {
+    if (!decoder || !decoder->jitter || !pData || size <= 0) return SF_RESULT_ERROR_INVALID_ARGS;
+    SF_JitterBuffer* jitter = decoder->jitter;
+
+    if (pts < 0) pts = AV_NOPTS_VALUE;
+
+    if (pts != AV_NOPTS_VALUE && jitter->next_pts != AV_NOPTS_VALUE && pts < jitter->next_pts) {
+        // Its slot has already been played or concealed; a deeper buffer would have caught it.
+        jitter->late_packets++;
+        jitter_adjust_depth(jitter, 1);
+        return SF_RESULT_SUCCESS;
+    }
+
+    // Search from the back, where in-order packets land. Packets without a PTS play in arrival order.
+    int index = jitter->count;
+    if (pts != AV_NOPTS_VALUE) {
+        while (index > 0 && jitter->packets[index - 1]->pts != AV_NOPTS_VALUE && jitter->packets[index - 1]->pts > pts) {
+            index--;
+        }
+        if (index > 0 && jitter->packets[index - 1]->pts == pts) return SF_RESULT_SUCCESS;  // Duplicate
+    }
+
+    if (jitter->count == jitter->capacity) {
+        // The reader has stalled. Drop the oldest packet to bound the latency.
+        if (index == 0) return SF_RESULT_SUCCESS;
+        AVPacket* oldest = jitter_pop(jitter);
+        av_packet_free(&oldest);
+        index--;
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    if (!packet || av_new_packet(packet, size) < 0) {
+        av_packet_free(&packet);
+        return SF_RESULT_ERROR_ALLOCATION_FAILED;
+    }
+    memcpy(packet->data, pData, size);
+    packet->pts = pts;
+    packet->dts = pts;
+
+    memmove(jitter->packets + index + 1, jitter->packets + index, (jitter->count - index) * sizeof(AVPacket*));
+    jitter->packets[index] = packet;
+    jitter->count++;
+    return SF_RESULT_SUCCESS;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_get_jitter_stats(SF_Decoder* decoder, int32_t* out_buffered_packets, int32_t* out_target_depth,
+                                                    int64_t* out_concealed_frames, int64_t* out_late_packets) {
+    if (!decoder || !decoder->jitter) return SF_RESULT_ERROR_INVALID_ARGS;
+    if (out_buffered_packets) *out_buffered_packets = decoder->jitter->count;
+    if (out_target_depth) *out_target_depth = decoder->jitter->target_depth;
+    if (out_concealed_frames) *out_concealed_frames = decoder->jitter->concealed_frames;
+    if (out_late_packets) *out_late_packets = decoder->jitter->late_packets;
+    return SF_RESULT_SUCCESS;
+}
+
+// The length of the decoded stream, including any encoder delay and padding.
+static int64_t decoder_raw_length(SF_Decoder* decoder, SFDurationSource* out_source) {
+    if (out_source) *out_source = SF_DURATION_UNKNOWN;
+
+    if (decoder->length_scanned) {
+        if (out_source) *out_source = SF_DURATION_SCANNED;
+        return decoder->scanned_length;
+    }
+
+    // Without a header the demuxer guesses from the bitrate, which is wrong for VBR and concatenated streams.
+    SFDurationSource source = decoder->format_ctx->duration_estimation_method == AVFMT_DURATION_FROM_BITRATE
+        ? SF_DURATION_ESTIMATE : SF_DURATION_HEADER;
+
+    AVStream* stream = decoder->format_ctx->streams[decoder->stream_index];
+    if (stream->duration != AV_NOPTS_VALUE) {
+        if (out_source) *out_source = source;
+        return av_rescale_q(stream->duration, stream->time_base, (AVRational){1, stream->codecpar->sample_rate});
+    }
+    // Fallback for formats without duration info (e.g. WAV)
+    if (decoder->format_ctx->duration != AV_NOPTS_VALUE) {
+        if (out_source) *out_source = source;
+        return av_rescale(decoder->format_ctx->duration, stream->codecpar->sample_rate, AV_TIME_BASE);
+    }
+    return 0;
+}
+
+SF_FFMPEG_API int64_t sf_decoder_get_length_info(SF_Decoder* decoder, SFDurationSource* out_source) {
+    if (out_source) *out_source = SF_DURATION_UNKNOWN;
+    if (decoder && decoder->cache_entry) {
+        if (out_source) *out_source = SF_DURATION_SCANNED;
+        return decoder->cache_entry->frames;
+    }
+    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0) return -1;
+
+    int64_t length = decoder_raw_length(decoder, out_source);
+    if (!decoder->gapless) return length;
+    if (decoder->base_end > 0) return decoder->base_end - decoder->base_start;
+    return length > 0 ? FFMAX(0, length - decoder->gapless_delay - decoder->gapless_padding) : 0;
+}
+
+// Index after the last frame reads can return, or 0 when the length is unknown.
+static int64_t decoder_end_index(SF_Decoder* decoder) {
+    int64_t length = sf_decoder_get_length_in_pcm_frames(decoder);
+    return length > 0 ? decoder->base_start + length : 0;
+}
+
+SF_FFMPEG_API int64_t sf_decoder_get_length_in_pcm_frames(SF_Decoder* decoder) {
+    return sf_decoder_get_length_info(decoder, NULL);
+}
+
+// After an exact seek, returns how many leading samples of a decoded frame precede the target.
+static int64_t decoder_samples_before_target(SF_Decoder* decoder, const AVFrame* frame) {
+    if (decoder->skip_until < 0) return 0;
+    if (frame->best_effort_timestamp == AV_NOPTS_VALUE) {
+        decoder->skip_until = -1;
+        return 0;
+    }
+
+    AVStream* stream = decoder->format_ctx->streams[decoder->stream_index];
+    int64_t frame_start = av_rescale_q(frame->best_effort_timestamp, stream->time_base, (AVRational){1, stream->codecpar->sample_rate});
+    int64_t before = decoder->skip_until - frame_start;
+    if (before < frame->nb_samples) decoder->skip_until = -1;  // The target lies in this frame.
+    return FFMAX(before, 0);
+}
+
+static void advance_planes(uint8_t** planes, int plane_count, int64_t bytes) {
+    for (int i = 0; i < plane_count; i++) planes[i] += bytes;
+}
+
+// Decodes into the caller's buffer, or one buffer per channel in planar mode.
+static SF_Result decoder_read_planes(SF_Decoder* decoder, uint8_t* const* planes, int64_t frameCount, int64_t* out_frames_read) {
+    *out_frames_read = 0;
+    if (decoder->base_end > 0) frameCount = FFMIN(frameCount, decoder->base_end - decoder->position);
+    if (frameCount <= 0) return SF_RESULT_SUCCESS;
+    int plane_count = decoder->planar ? decoder->target_channels : 1;
+    int stride = decoder->planar ? decoder->target_bytes_per_sample : decoder->target_channels * decoder->target_bytes_per_sample;
+    uint8_t* out_ptr[SWR_CH_MAX];
+    for (int i = 0; i < plane_count; i++) out_ptr[i] = planes[i];
+    int64_t frames_read = 0;
+    int draining = 0;
+
+    while (frames_read < frameCount) {
+        // Check if the resampler has data buffered from previous calls.
+        if (swr_get_out_samples(decoder->swr_ctx, 0) > 0) {
+            // Call swr_convert with NULL input to flush/read buffered data
+            int out_samples = swr_convert(decoder->swr_ctx,
+                                         out_ptr,
+                                         (int)(frameCount - frames_read),
+                                         NULL, 0);
+
+            if (out_samples > 0) {
+                advance_planes(out_ptr, plane_count, (int64_t)out_samples * stride);
+                frames_read += out_samples;
+
+                // If we filled the user buffer, we are done for this call.
+                if (frames_read >= frameCount) break;
+            }
+        }
+
+        // Try to receive a decoded frame
+        int ret = avcodec_receive_frame(decoder->codec_ctx, decoder->frame);
+
+        if (ret == 0) {
+            // Trim the part of the frame that lies before an exact seek target.
+            int64_t before = decoder_samples_before_target(decoder, decoder->frame);
+            if (before >= decoder->frame->nb_samples) {
+                av_frame_unref(decoder->frame);
+                continue;
+            }
+            if (before > 0) swr_drop_output(decoder->swr_ctx, (int)before);
+
+            // In gapless mode the codec leaves the end padding in place and marks it on the last frames.
+            int nb_samples = decoder->frame->nb_samples;
+            AVFrameSideData* skip = decoder->gapless ? av_frame_get_side_data(decoder->frame, AV_FRAME_DATA_SKIP_SAMPLES) : NULL;
+            if (skip && skip->size >= 8) nb_samples = FFMAX(0, nb_samples - (int)AV_RL32(skip->data + 4));
+
+            // Resample the frame to target format
+            int out_samples = swr_convert(decoder->swr_ctx,
+                                         out_ptr,
+                                         (int)(frameCount - frames_read),
+                                         (const uint8_t**)decoder->frame->data,
+                                         nb_samples);
+
+            if (out_samples > 0) {
+                advance_planes(out_ptr, plane_count, (int64_t)out_samples * stride);
+                frames_read += out_samples;
+            }
+            av_frame_unref(decoder->frame);
+            continue;
+        }
+        else if (ret == AVERROR_EOF) {
+            // Drain the resampler completely
+            int flushed_samples;
+            do {
+                flushed_samples = swr_convert(decoder->swr_ctx,
+                                             out_ptr,
+                                             (int)(frameCount - frames_read),
+                                             NULL, 0);
+                if (flushed_samples > 0) {
+                    advance_planes(out_ptr, plane_count, (int64_t)flushed_samples * stride);
+                    frames_read += flushed_samples;
+                }
+            } while (flushed_samples > 0 && frames_read < frameCount);
+
+            // End of stream is not an error, break loop and return success.
+            break;
+        }
+        else if (ret != AVERROR(EAGAIN)) {
+            // A unrecoverable decoding error occurred.
+            *out_frames_read = frames_read;
+            return SF_RESULT_DECODER_ERROR_DECODING_FAILED;
+        }
+
+        // If we need more input data (ret == AVERROR(EAGAIN))
+        if (draining) {
+            // We are draining and still need more data, which means we are done.
+            break;
+        }
+
+        // Read a new packet from the stream
+        av_packet_unref(decoder->packet);
+        int read_ret = av_read_frame(decoder->format_ctx, decoder->packet);
+
+        if (read_ret == 0) {
+            if (decoder->packet->stream_index == decoder->stream_index) {
+                if (avcodec_send_packet(decoder->codec_ctx, decoder->packet) < 0) {
+                    av_packet_unref(decoder->packet);
+                    *out_frames_read = frames_read;
+                    return SF_RESULT_DECODER_ERROR_DECODING_FAILED;
+                }
+            }
+            av_packet_unref(decoder->packet);
+        }
+        else if (read_ret == AVERROR_EOF) {
+            // Reached end of stream, start draining process by sending a NULL packet.
+            avcodec_send_packet(decoder->codec_ctx, NULL);
+            draining = 1;
+        }
+        else {
+            // A read error occurred.
+            *out_frames_read = frames_read;
+            return SF_RESULT_DECODER_ERROR_DECODING_FAILED;
+        }
+    }
+
+    *out_frames_read = frames_read;
+    decoder->position += frames_read;
+    return SF_RESULT_SUCCESS;
+}
+
+static SF_Result decoder_read_frames(SF_Decoder* decoder, void* pFramesOut, int64_t frameCount, int64_t* out_frames_read) {
+    uint8_t* planes[] = { (uint8_t*)pFramesOut };
+    return decoder_read_planes(decoder, planes, frameCount, out_frames_read);
+}
+
+// Seeks so that the next frame returned is exactly frameIndex. The demuxer lands on an earlier packet
+// (earlier still by the codec's seek preroll) and decoder_read_frames drops the samples before the target.
+static SF_Result decoder_seek_exact(SF_Decoder* decoder, int64_t frameIndex) {
+    AVStream* stream = decoder->format_ctx->streams[decoder->stream_index];
+    int64_t seek_frame = FFMAX(0, frameIndex - stream->codecpar->seek_preroll);
+    int64_t timestamp = av_rescale_q(seek_frame, (AVRational){1, stream->codecpar->sample_rate}, stream->time_base);
+
+    // Flush buffers and seek
+    avcodec_flush_buffers(decoder->codec_ctx);
+    swr_init(decoder->swr_ctx);  // Reset resampler state
+
+    if (av_seek_frame(decoder->format_ctx, decoder->stream_index, timestamp, AVSEEK_FLAG_BACKWARD) < 0) {
+        return SF_RESULT_DECODER_ERROR_SEEK_FAILED;
+    }
+
+    decoder->skip_until = frameIndex;
+    decoder->position = frameIndex;
+    return SF_RESULT_SUCCESS;
+}
+
+// Starts a new pass of the loop. With a pre-decoded head the splice is served from memory and the seek
+// to the continuation point is deferred until the head is used up.
+static SF_Result decoder_wrap_range(SF_Decoder* decoder) {
+    if (decoder->loop_head_frames > 0) {
+        decoder->position = decoder->range_start;
+        decoder->loop_head_pos = 0;
+        decoder->loop_resume_pending = 1;
+        return SF_RESULT_SUCCESS;
+    }
+    return decoder_seek_exact(decoder, decoder->range_start);
+}
+
+static SF_Result decoder_read_range(SF_Decoder* decoder, uint8_t* out, int64_t frameCount, int64_t* out_frames_read) {
+    int frame_bytes = decoder->target_channels * decoder->target_bytes_per_sample;
+    int64_t frames_read = 0;
+    int64_t frames_at_last_wrap = -1;
+    SF_Result result = SF_RESULT_SUCCESS;
+
+    while (frames_read < frameCount) {
+        if (decoder->loop_head_pos >= 0) {
+            int64_t count = FFMIN(frameCount - frames_read, decoder->loop_head_frames - decoder->loop_head_pos);
+            memcpy(out + frames_read * frame_bytes, decoder->loop_head + decoder->loop_head_pos * frame_bytes, count * frame_bytes);
+            frames_read += count;
+            decoder->position += count;
+            decoder->loop_head_pos += count;
+            if (decoder->loop_head_pos >= decoder->loop_head_frames) decoder->loop_head_pos = -1;
+            continue;
+        }
+
+        if (decoder->loop_resume_pending) {
+            decoder->loop_resume_pending = 0;
+            result = decoder_seek_exact(decoder, decoder->range_start + decoder->loop_head_frames);
+            if (result != SF_RESULT_SUCCESS) break;
+        }
+
+        int64_t wanted = frameCount - frames_read;
+        if (decoder->range_end > 0) wanted = FFMIN(wanted, decoder->range_end - decoder->position);
+
+        int64_t got = 0;
+        if (wanted > 0) {
+            result = decoder_read_frames(decoder, out + frames_read * frame_bytes, wanted, &got);
+            frames_read += got;
+            if (result != SF_RESULT_SUCCESS) break;
+            if (got == wanted) continue;
+        }
+
+        // End of the range or of the stream. Stop unless looping, and never wrap twice without output.
+        if (!decoder->range_loop || frames_at_last_wrap == frames_read) break;
+        frames_at_last_wrap = frames_read;
+        result = decoder_wrap_range(decoder);
+    }
+
+    *out_frames_read = frames_read;
+    return result;
+}
+
+// Reverses the order of frames in place. Mono and stereo 32-bit frames are swapped a vector at a time
+// from both ends; other layouts fall back to swapping byte by byte.
+static void reverse_frames(uint8_t* data, int64_t frames, int frame_bytes) {
+    int64_t lo = 0, hi = frames - 1;
+
+#if defined(SF_HAVE_SSE2) || defined(SF_HAVE_NEON)
+    if (frame_bytes == 4 || frame_bytes == 8) {
+        int per_vector = 16 / frame_bytes;
+        while (hi - lo + 1 >= 2 * per_vector) {
+            uint8_t* a = data + lo * frame_bytes;
+            uint8_t* b = data + (hi - per_vector + 1) * frame_bytes;
+#ifdef SF_HAVE_SSE2
+            __m128i va = _mm_loadu_si128((const __m128i*)a);
+            __m128i vb = _mm_loadu_si128((const __m128i*)b);
+            if (frame_bytes == 4) {
+                va = _mm_shuffle_epi32(va, _MM_SHUFFLE(0, 1, 2, 3));
+                vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 1, 2, 3));
+            } else {
+                va = _mm_shuffle_epi32(va, _MM_SHUFFLE(1, 0, 3, 2));
+                vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2));
+            }
+            _mm_storeu_si128((__m128i*)a, vb);
+            _mm_storeu_si128((__m128i*)b, va);
+#else
+            uint32x4_t va = vld1q_u32((const uint32_t*)a);
+            uint32x4_t vb = vld1q_u32((const uint32_t*)b);
+            if (frame_bytes == 4) {
+                va = vrev64q_u32(va);
+                vb = vrev64q_u32(vb);
+            }
+            va = vcombine_u32(vget_high_u32(va), vget_low_u32(va));
+            vb = vcombine_u32(vget_high_u32(vb), vget_low_u32(vb));
+            vst1q_u32((uint32_t*)a, vb);
+            vst1q_u32((uint32_t*)b, va);
+#endif
+            lo += per_vector;
+            hi -= per_vector;
+        }
+    }
+#endif
+
+    for (; lo < hi; lo++, hi--) {
+        uint8_t* a = data + lo * frame_bytes;
+        uint8_t* b = data + hi * frame_bytes;
+        for (int i = 0; i < frame_bytes; i++) {
+            uint8_t t = a[i];
+            a[i] = b[i];
+            b[i] = t;
+        }
+    }
+}
+
+// Decodes the block of frames that ends at position, going no lower than lower, and reverses it.
+static SF_Result decoder_fill_reverse_block(SF_Decoder* decoder, int64_t lower) {
+    int64_t end = decoder->position;
+    int64_t start = FFMAX(lower, end - decoder->reverse_capacity);
+
+    decoder->reverse_block_frames = 0;
+    SF_Result result = decoder_seek_exact(decoder, start);
+    if (result != SF_RESULT_SUCCESS) return result;
+
+    int64_t got = 0;
+    result = decoder_read_frames(decoder, decoder->reverse_block, end - start, &got);
+    if (result != SF_RESULT_SUCCESS) return result;
+
+    reverse_frames(decoder->reverse_block, got, decoder->target_channels * decoder->target_bytes_per_sample);
+    decoder->reverse_block_start = start;
+    decoder->reverse_block_frames = got;
+    // A stream shorter than its reported length ends inside the block; continue from its real end.
+    decoder->position = start + got;
+    return SF_RESULT_SUCCESS;
+}
+
+static SF_Result decoder_read_reverse(SF_Decoder* decoder, uint8_t* out, int64_t frameCount, int64_t* out_frames_read) {
+    int frame_bytes = decoder->target_channels * decoder->target_bytes_per_sample;
+    int64_t lower = decoder->range_set ? decoder->range_start : decoder->base_start;
+    int64_t upper = decoder->range_end > 0 ? decoder->range_end : decoder_end_index(decoder);
+    int64_t frames_read = 0;
+    int64_t frames_at_last_wrap = -1;
+    SF_Result result = SF_RESULT_SUCCESS;
+
+    if (decoder->range_set && upper > 0 && decoder->position > upper) decoder->position = upper;
+
+    while (frames_read < frameCount) {
+        if (decoder->position <= lower) {
+            // Start of the range or of the stream. Stop unless looping, and never wrap twice without output.
+            if (!decoder->range_loop || upper <= lower || frames_at_last_wrap == frames_read) break;
+            frames_at_last_wrap = frames_read;
+            decoder->position = upper;
+            continue;
+        }
+
+        int64_t block_end = decoder->reverse_block_start + decoder->reverse_block_frames;
+        if (decoder->position <= decoder->reverse_block_start || decoder->position > block_end) {
+            result = decoder_fill_reverse_block(decoder, lower);
+            if (result != SF_RESULT_SUCCESS) break;
+            continue;
+        }
+
+        int64_t count = FFMIN(frameCount - frames_read, decoder->position - decoder->reverse_block_start);
+        memcpy(out + frames_read * frame_bytes, decoder->reverse_block + (block_end - decoder->position) * frame_bytes, count * frame_bytes);
+        frames_read += count;
+        decoder->position -= count;
+    }
+
+    *out_frames_read = frames_read;
+    return result;
+}
+
+static SF_Result decoder_read_own(SF_Decoder* decoder, void* pFramesOut, int64_t frameCount, int64_t* out_frames_read) {
+    if (decoder->cache_entry) {
+        const SF_CacheEntry* entry = decoder->cache_entry;
+        int64_t count = FFMAX(0, FFMIN(frameCount, entry->frames - decoder->position));
+        int frame_bytes = entry->channels * av_get_bytes_per_sample(entry->format);
+        memcpy(pFramesOut, entry->pcm + decoder->position * frame_bytes, count * frame_bytes);
+        decoder->position += count;
+        *out_frames_read = count;
+        return SF_RESULT_SUCCESS;
+    }
+    if (decoder->jitter) return jitter_read_pcm_frames(decoder, pFramesOut, frameCount, out_frames_read);
+    if (decoder->reverse) return decoder_read_reverse(decoder, (uint8_t*)pFramesOut, frameCount, out_frames_read);
+    if (decoder->range_set) return decoder_read_range(decoder, (uint8_t*)pFramesOut, frameCount, out_frames_read);
+    return decoder_read_frames(decoder, pFramesOut, frameCount, out_frames_read);
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_read_pcm_frames(SF_Decoder* decoder, void* pFramesOut, int64_t frameCount, int64_t* out_frames_read) {
+    if (!decoder || !pFramesOut || !out_frames_read || frameCount <= 0 || decoder->planar) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    int64_t frames_read = 0;
+    if (!decoder->chain_handed_over) {
+        SF_Result result = decoder_read_own(decoder, pFramesOut, frameCount, &frames_read);
+        if (result != SF_RESULT_SUCCESS || frames_read == frameCount || !decoder->next) {
+            *out_frames_read = frames_read;
+            return result;
+        }
+        decoder->chain_handed_over = 1;
+    }
+
+    // This stream has ended: continue with the chained decoder's pre-decoded head, then the decoder itself.
+    int frame_bytes = decoder->target_channels * decoder->target_bytes_per_sample;
+    uint8_t* out = (uint8_t*)pFramesOut;
+    int64_t count = FFMIN(frameCount - frames_read, decoder->chain_head_frames - decoder->chain_head_pos);
+    if (count > 0) {
+        memcpy(out + frames_read * frame_bytes, decoder->chain_head + decoder->chain_head_pos * frame_bytes, count * frame_bytes);
+        frames_read += count;
+        decoder->chain_head_pos += count;
+    }
+
+    SF_Result result = SF_RESULT_SUCCESS;
+    if (frames_read < frameCount && decoder->next) {
+        int64_t got = 0;
+        result = sf_decoder_read_pcm_frames(decoder->next, out + frames_read * frame_bytes, frameCount - frames_read, &got);
+        frames_read += got;
+    }
+    *out_frames_read = frames_read;
+    return result;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_read_pcm_frames_planar(SF_Decoder* decoder, void** pChannelsOut, int64_t frameCount,
+                                                         int64_t* out_frames_read) {
+    if (!decoder || !pChannelsOut || !out_frames_read || frameCount <= 0 || !decoder->planar) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    // Planar mode excludes loops, so a range only bounds the read.
+    *out_frames_read = 0;
+    if (decoder->range_set && decoder->range_end > 0) frameCount = FFMIN(frameCount, decoder->range_end - decoder->position);
+    if (frameCount <= 0) return SF_RESULT_SUCCESS;
+    return decoder_read_planes(decoder, (uint8_t* const*)pChannelsOut, frameCount, out_frames_read);
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_set_planar(SF_Decoder* decoder, int32_t planar) {
+    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0) return SF_RESULT_ERROR_INVALID_ARGS;
+    if ((planar != 0) == decoder->planar) return SF_RESULT_SUCCESS;
+    if (planar && (decoder->reverse || decoder->range_loop || decoder->next || decoder->target_channels > SWR_CH_MAX)) {
+        return SF_RESULT_ERROR_INVALID_ARGS;
+    }
+
+    enum AVSampleFormat format = planar ? av_get_planar_sample_fmt(decoder->target_av_format) : decoder->target_av_format;
+    SwrContext* swr_ctx = NULL;
+    swr_alloc_set_opts2(&swr_ctx,
+                        &decoder->codec_ctx->ch_layout, format, decoder->codec_ctx->sample_rate,
+                        &decoder->codec_ctx->ch_layout, decoder->codec_ctx->sample_fmt, decoder->codec_ctx->sample_rate,
+                        0, NULL);
+    if (!swr_ctx || swr_init(swr_ctx) < 0) {
+        swr_free(&swr_ctx);
+        return SF_RESULT_DECODER_ERROR_RESAMPLER_INIT_FAILED;
+    }
+
+    // Output the old resampler still holds would be lost; re-decode it through the new one.
+    int pending = swr_get_out_samples(decoder->swr_ctx, 0) > 0;
+    swr_free(&decoder->swr_ctx);
+    decoder->swr_ctx = swr_ctx;
+    decoder->planar = planar != 0;
+    return pending ? decoder_seek_exact(decoder, decoder->position) : SF_RESULT_SUCCESS;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_seek_to_pcm_frame(SF_Decoder* decoder, int64_t frameIndex) {
+    if (decoder && decoder->cache_entry && !decoder->chain_handed_over && frameIndex >= 0) {
+        decoder->position = FFMIN(frameIndex, decoder->cache_entry->frames);
+        return SF_RESULT_SUCCESS;
+    }
+    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0 || frameIndex < 0) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    // After the hand-over this decoder stands in for the chained one.
+    if (decoder->chain_handed_over && decoder->next) {
+        decoder->chain_head_pos = decoder->chain_head_frames;
+        return sf_decoder_seek_to_pcm_frame(decoder->next, frameIndex);
+    }
+    frameIndex += decoder->base_start;
+
+    // In reverse mode blocks are decoded on demand, so a seek only moves the read position.
+    if (decoder->reverse) {
+        decoder->position = frameIndex;
+        return SF_RESULT_SUCCESS;
+    }
+
+    // Seeking back to the loop start is the common case for looped ranges; splice it from the head.
+    if (decoder->range_set && frameIndex == decoder->range_start && decoder->loop_head_frames > 0) {
+        return decoder_wrap_range(decoder);
+    }
+
+    decoder->loop_head_pos = -1;
+    decoder->loop_resume_pending = 0;
+    return decoder_seek_exact(decoder, frameIndex);
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_set_range(SF_Decoder* decoder, int64_t start_frame, int64_t end_frame, int32_t loop) {
+    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0) return SF_RESULT_ERROR_INVALID_ARGS;
+    if (start_frame < 0 || (end_frame > 0 && end_frame <= start_frame) || (loop && decoder->planar)) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    av_freep(&decoder->loop_head);
+    decoder->loop_head_frames = 0;
+    decoder->loop_head_pos = -1;
+    decoder->loop_resume_pending = 0;
+
+    decoder->range_start = decoder->base_start + start_frame;
+    decoder->range_end = end_frame > 0 ? decoder->base_start + end_frame : 0;
+    decoder->range_loop = loop != 0;
+    decoder->range_set = start_frame > 0 || end_frame > 0 || loop;
+
+    // Reverse playback starts from the end of the range and needs no loop head.
+    if (decoder->reverse) {
+        decoder->position = decoder->range_end > 0 ? decoder->range_end : decoder_end_index(decoder);
+        return SF_RESULT_SUCCESS;
+    }
+
+    SF_Result result = decoder_seek_exact(decoder, decoder->range_start);
+    if (result != SF_RESULT_SUCCESS || !decoder->range_loop) return result;
+
+    // Pre-decode the head of the loop now, while nothing is waiting on the decoder.
+    int64_t head_frames = decoder->codec_ctx->sample_rate * LOOP_HEAD_MS / 1000;
+    if (decoder->range_end > 0) head_frames = FFMIN(head_frames, decoder->range_end - decoder->range_start);
+
+    int frame_bytes = decoder->target_channels * decoder->target_bytes_per_sample;
+    decoder->loop_head = (uint8_t*)av_malloc(head_frames * frame_bytes);
+    if (!decoder->loop_head) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+
+    int64_t got = 0;
+    result = decoder_read_frames(decoder, decoder->loop_head, head_frames, &got);
+    if (result != SF_RESULT_SUCCESS) {
+        av_freep(&decoder->loop_head);
+        return result;
+    }
+
+    // Playback starts from the head; the decoder itself is already positioned right after it.
+    decoder->loop_head_frames = got;
+    decoder->loop_head_pos = got > 0 ? 0 : -1;
+    decoder->position = decoder->range_start;
+    return SF_RESULT_SUCCESS;
+}
+
+static SF_Result decoder_alloc_reverse_block(SF_Decoder* decoder) {
+    if (decoder->reverse_block) return SF_RESULT_SUCCESS;
+    decoder->reverse_capacity = FFMAX(1, (int64_t)decoder->codec_ctx->sample_rate * REVERSE_BLOCK_MS / 1000);
+    decoder->reverse_block = (uint8_t*)av_malloc(decoder->reverse_capacity * decoder->target_channels * decoder->target_bytes_per_sample);
+    return decoder->reverse_block ? SF_RESULT_SUCCESS : SF_RESULT_ERROR_ALLOCATION_FAILED;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_set_reverse(SF_Decoder* decoder, int32_t reverse) {
+    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0 || (reverse && decoder->planar)) return SF_RESULT_ERROR_INVALID_ARGS;
+    if ((reverse != 0) == decoder->reverse) return SF_RESULT_SUCCESS;
+
+    decoder->loop_head_pos = -1;
+    decoder->loop_resume_pending = 0;
+
+    if (!reverse) {
+        // Resume forward decoding from where the reverse reads left off.
+        decoder->reverse = 0;
+        return decoder_seek_exact(decoder, decoder->position);
+    }
+
+    SF_Result result = decoder_alloc_reverse_block(decoder);
+    if (result != SF_RESULT_SUCCESS) return result;
+    decoder->reverse_block_frames = 0;
+    decoder->reverse = 1;
+    return SF_RESULT_SUCCESS;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_scan_length(SF_Decoder* decoder, int64_t* out_frames) {
+    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    if (!decoder->length_scanned) {
+        // The scan reads to the end of the input, so it must be able to come back.
+        if (!decoder->format_ctx->pb || !(decoder->format_ctx->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
+            return SF_RESULT_DECODER_ERROR_SEEK_FAILED;
+        }
+
+        AVStream* stream = decoder->format_ctx->streams[decoder->stream_index];
+        int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        if (av_seek_frame(decoder->format_ctx, decoder->stream_index, start, AVSEEK_FLAG_BACKWARD) < 0) {
+            return SF_RESULT_DECODER_ERROR_SEEK_FAILED;
+        }
+
+        // The demuxer's parser splits the input at frame headers and stamps each packet with its
+        // duration, so summing durations counts every frame without decoding any of them. Summing
+        // (rather than taking the last timestamp) also holds for concatenated streams whose
+        // timestamps restart.
+        int64_t total = 0;
+        int64_t last_duration = stream->codecpar->frame_size > 0
+            ? av_rescale_q(stream->codecpar->frame_size, (AVRational){1, stream->codecpar->sample_rate}, stream->time_base)
+            : 0;
+        int ret;
+        while ((ret = av_read_frame(decoder->format_ctx, decoder->packet)) == 0) {
+            if (decoder->packet->stream_index == decoder->stream_index) {
+                if (decoder->packet->duration > 0) last_duration = decoder->packet->duration;
+                total += last_duration;
+            }
+            av_packet_unref(decoder->packet);
+        }
+
+        SF_Result result = decoder_seek_exact(decoder, decoder->position);
+        if (ret != AVERROR_EOF) return SF_RESULT_DECODER_ERROR_DECODING_FAILED;
+        if (result != SF_RESULT_SUCCESS) return result;
+
+        decoder->scanned_length = av_rescale_q(total, stream->time_base, (AVRational){1, stream->codecpar->sample_rate});
+        decoder->length_scanned = 1;
+    }
+
+    if (out_frames) *out_frames = decoder->scanned_length;
+    return SF_RESULT_SUCCESS;
+}
+
+// Reads the stream's first packet for its start index and the skip count the demuxer attached to it
+// (LAME/Xing headers, Opus pre-skip, MP4 edit lists); out_skip stays -1 when there is none.
+static void decoder_probe_start(SF_Decoder* decoder, int64_t* out_first, int64_t* out_skip) {
+    AVStream* stream = decoder->format_ctx->streams[decoder->stream_index];
+    *out_first = 0;
+    *out_skip = -1;
+
+    int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    if (av_seek_frame(decoder->format_ctx, decoder->stream_index, start, AVSEEK_FLAG_BACKWARD) < 0) return;
+
+    while (av_read_frame(decoder->format_ctx, decoder->packet) == 0) {
+        if (decoder->packet->stream_index != decoder->stream_index) {
+            av_packet_unref(decoder->packet);
+            continue;
+        }
+        if (decoder->packet->pts != AV_NOPTS_VALUE) {
+            *out_first = av_rescale_q(decoder->packet->pts, stream->time_base, (AVRational){1, stream->codecpar->sample_rate});
+        }
+        size_t size = 0;
+        const uint8_t* skip = av_packet_get_side_data(decoder->packet, AV_PKT_DATA_SKIP_SAMPLES, &size);
+        if (skip && size >= 4) *out_skip = AV_RL32(skip);
+        av_packet_unref(decoder->packet);
+        break;
+    }
+}
+
+// Parses iTunes gapless metadata: " 00000000 <delay> <padding> <sample count> ..." in hex.
+static int parse_itunsmpb(const AVDictionary* metadata, int64_t* out_delay, int64_t* out_padding, int64_t* out_length) {
+    const AVDictionaryEntry* entry = av_dict_get(metadata, "iTunSMPB", NULL, 0);
+    unsigned int reserved, delay, padding;
+    unsigned long long length;
+    if (!entry || sscanf(entry->value, "%x %x %x %llx", &reserved, &delay, &padding, &length) != 4) return 0;
+
+    *out_delay = delay;
+    *out_padding = padding;
+    *out_length = (int64_t)length;
+    return 1;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_set_gapless(SF_Decoder* decoder, int32_t gapless) {
+    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0) return SF_RESULT_ERROR_INVALID_ARGS;
+    if ((gapless != 0) == decoder->gapless) return SF_RESULT_SUCCESS;
+
+    // With SKIP_MANUAL the codec reports the delay and padding instead of trimming them itself.
+    SF_Result result = decoder_open_codec(decoder, gapless ? AV_CODEC_FLAG2_SKIP_MANUAL : 0);
+    if (result != SF_RESULT_SUCCESS) return result;
+
+    // Everything positioned in the old timeline is dropped.
+    av_freep(&decoder->loop_head);
+    decoder->loop_head_frames = 0;
+    decoder->loop_head_pos = -1;
+    decoder->loop_resume_pending = 0;
+    decoder->range_set = decoder->range_loop = 0;
+    decoder->range_start = decoder->range_end = 0;
+    decoder->reverse_block_frames = 0;
+
+    decoder->gapless = gapless != 0;
+    decoder->base_start = decoder->base_end = 0;
+    decoder->gapless_delay = decoder->gapless_padding = 0;
+
+    if (decoder->gapless) {
+        AVStream* stream = decoder->format_ctx->streams[decoder->stream_index];
+        int64_t first, skip, smpb_delay = 0, smpb_padding = 0, smpb_length = 0;
+        decoder_probe_start(decoder, &first, &skip);
+        int has_smpb = parse_itunsmpb(decoder->format_ctx->metadata, &smpb_delay, &smpb_padding, &smpb_length) ||
+                       parse_itunsmpb(stream->metadata, &smpb_delay, &smpb_padding, &smpb_length);
+
+        // The demuxer's skip count is exact; iTunes metadata and the codec parameters are the fallbacks.
+        decoder->gapless_delay = skip >= 0 ? skip : has_smpb ? smpb_delay : stream->codecpar->initial_padding;
+        decoder->gapless_padding = has_smpb ? smpb_padding : stream->codecpar->trailing_padding;
+        decoder->base_start = first + decoder->gapless_delay;
+
+        // A known real length ends reads exactly; otherwise the codec marks the padding on the last frames.
+        SFDurationSource source;
+        int64_t raw_length = decoder_raw_length(decoder, &source);
+        if (has_smpb && smpb_length > 0) {
+            decoder->base_end = decoder->base_start + smpb_length;
+        } else if (decoder->gapless_padding > 0 && raw_length > 0 && source >= SF_DURATION_HEADER) {
+            decoder->base_end = decoder->base_start + FFMAX(1, raw_length - decoder->gapless_delay - decoder->gapless_padding);
+        }
+    }
+
+    return decoder_seek_exact(decoder, decoder->base_start);
+}
+
+static int decoder_sample_rate(const SF_Decoder* decoder) {
+    if (decoder->cache_entry) return decoder->cache_entry->sample_rate;
+    return decoder->codec_ctx ? decoder->codec_ctx->sample_rate : 0;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_chain(SF_Decoder* decoder, SF_Decoder* next) {
+    if (!decoder || next == decoder || (next && (decoder->planar || next->planar))) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    // Once handed over, this decoder stands in for the chained one.
+    if (decoder->chain_handed_over && decoder->next) return sf_decoder_chain(decoder->next, next);
+
+    if (next && (next->target_av_format != decoder->target_av_format || next->target_channels != decoder->target_channels ||
+                 decoder_sample_rate(next) != decoder_sample_rate(decoder))) {
+        return SF_RESULT_DECODER_ERROR_CHAIN_FORMAT_MISMATCH;
+    }
+
+    av_freep(&decoder->chain_head);
+    decoder->chain_head_frames = decoder->chain_head_pos = 0;
+    decoder->next = next;
+    if (!next) return SF_RESULT_SUCCESS;
+
+    // Decode the head of the next stream now, so the transition never waits on its demuxer or codec start-up.
+    int frame_bytes = decoder->target_channels * decoder->target_bytes_per_sample;
+    int64_t head_frames = FFMAX(1, (int64_t)decoder_sample_rate(decoder) * CHAIN_HEAD_MS / 1000);
+    decoder->chain_head = (uint8_t*)av_malloc(head_frames * frame_bytes);
+    if (!decoder->chain_head) {
+        decoder->next = NULL;
+        return SF_RESULT_ERROR_ALLOCATION_FAILED;
+    }
+
+    SF_Result result = sf_decoder_read_pcm_frames(next, decoder->chain_head, head_frames, &decoder->chain_head_frames);
+    if (result != SF_RESULT_SUCCESS) {
+        av_freep(&decoder->chain_head);
+        decoder->chain_head_frames = 0;
+        decoder->next = NULL;
+    }
+    return result;
+}
+
+SF_FFMPEG_API int32_t sf_decoder_chain_finished(SF_Decoder* decoder) {
+    if (!decoder || !decoder->next || !decoder->chain_handed_over) return 0;
+    return decoder->chain_head_pos >= decoder->chain_head_frames;
+}
+
+// Finds where sound starts in a run of frames fed in scan order (forwards or backwards).
+typedef struct {
+    float threshold;
+    int64_t hold;         // Frames a stretch of sound must last to count; shorter clicks are treated as silence.
+    int64_t gap;
+    int64_t run_start;    // Scan index where the current stretch began, or -1.
+    int64_t last_loud;
+    int64_t first_sound;  // Scan index of the first frame of the first stretch that lasted, or -1.
+    int64_t last_sound;   // Scan index of the last loud frame of a stretch that lasted, or -1.
+    int64_t count;        // Frames fed so far.
+} SF_SilenceScan;
+
+static void silence_scan_init(SF_SilenceScan* scan, float threshold_db, int32_t hold_ms, int sample_rate) {
+    scan->threshold = powf(10.0f, threshold_db / 20.0f);
+    scan->hold = (int64_t)sample_rate * hold_ms / 1000;
+    scan->gap = (int64_t)sample_rate * SILENCE_GAP_MS / 1000;
+    scan->run_start = scan->last_loud = -1;
+    scan->first_sound = scan->last_sound = -1;
+    scan->count = 0;
+}
+
+static float frame_peak(const uint8_t* frame, enum AVSampleFormat format, int channels) {
+    float peak = 0.0f;
+    for (int c = 0; c < channels; c++) {
+        float value;
+        switch (format) {
+            case AV_SAMPLE_FMT_U8:  value = (frame[c] - 128) / 128.0f; break;
+            case AV_SAMPLE_FMT_S16: value = ((const int16_t*)frame)[c] / 32768.0f; break;
+            case AV_SAMPLE_FMT_S32: value = ((const int32_t*)frame)[c] / 2147483648.0f; break;
+            default:                value = ((const float*)frame)[c]; break;
+        }
+        peak = FFMAX(peak, fabsf(value));
+    }
+    return peak;
+}
+
+static void silence_scan_feed(SF_SilenceScan* scan, const SF_Decoder* decoder, const uint8_t* data, int64_t frames) {
+    int frame_bytes = decoder->target_channels * decoder->target_bytes_per_sample;
+    for (int64_t k = 0; k < frames; k++) {
+        if (frame_peak(data + k * frame_bytes, decoder->target_av_format, decoder->target_channels) <= scan->threshold) continue;
+
+        int64_t i = scan->count + k;
+        if (scan->run_start < 0 || i - scan->last_loud > scan->gap) scan->run_start = i;
+        scan->last_loud = i;
+        if (i - scan->run_start >= scan->hold) {
+            if (scan->first_sound < 0) scan->first_sound = scan->run_start;
+            scan->last_sound = i;
+        }
+    }
+    scan->count += frames;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_analyze_silence(SF_Decoder* decoder, float threshold_db, int32_t hold_ms,
+                                                   int64_t* out_first_frame, int64_t* out_last_frame) {
+    if (!decoder || !decoder->format_ctx || decoder->stream_index < 0 || decoder->planar || hold_ms < 0 ||
+        !out_first_frame || !out_last_frame) {
+        return SF_RESULT_ERROR_INVALID_ARGS;
+    }
+    *out_first_frame = *out_last_frame = -1;
+
+    int frame_bytes = decoder->target_channels * decoder->target_bytes_per_sample;
+    uint8_t* block = (uint8_t*)av_malloc(SILENCE_SCAN_FRAMES * frame_bytes);
+    if (!block) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+
+    // The analysis covers the whole stream, whatever range or direction the caller reads in.
+    int64_t saved_position = decoder->position;
+    int saved_reverse = decoder->reverse;
+    int saved_range_set = decoder->range_set;
+    int saved_range_loop = decoder->range_loop;
+    int64_t saved_range_end = decoder->range_end;
+    decoder->reverse = decoder->range_set = decoder->range_loop = 0;
+    decoder->range_end = 0;
+
+    // Leading edge: decode forwards until the first stretch of sound.
+    SF_SilenceScan scan;
+    silence_scan_init(&scan, threshold_db, hold_ms, decoder->codec_ctx->sample_rate);
+    int64_t got = 0;
+    SF_Result result = decoder_seek_exact(decoder, decoder->base_start);
+    while (result == SF_RESULT_SUCCESS && scan.first_sound < 0) {
+        result = decoder_read_frames(decoder, block, SILENCE_SCAN_FRAMES, &got);
+        if (got == 0) break;
+        silence_scan_feed(&scan, decoder, block, got);
+    }
+    *out_first_frame = scan.first_sound;
+
+    // Trailing edge: decode backwards from the end, so only the trailing silence is decoded.
+    int64_t end = decoder_end_index(decoder);
+    if (result == SF_RESULT_SUCCESS && scan.first_sound >= 0 && end > 0) {
+        SF_SilenceScan tail;
+        silence_scan_init(&tail, threshold_db, hold_ms, decoder->codec_ctx->sample_rate);
+        int64_t top = -1;  // Index of the stream's real last frame, known after the first backward read.
+
+        result = decoder_alloc_reverse_block(decoder);
+        decoder->position = end;
+        while (result == SF_RESULT_SUCCESS && tail.first_sound < 0) {
+            result = decoder_read_reverse(decoder, block, SILENCE_SCAN_FRAMES, &got);
+            if (got == 0) break;
+            if (top < 0) top = decoder->position + got - 1;
+            silence_scan_feed(&tail, decoder, block, got);
+        }
+        *out_last_frame = tail.first_sound >= 0 ? top - tail.first_sound - decoder->base_start : FFMAX(top - decoder->base_start, scan.first_sound);
+    } else if (result == SF_RESULT_SUCCESS && scan.first_sound >= 0) {
+        // Unknown length: there is no end to work back from, so decode on and keep the last stretch of sound.
+        while ((result = decoder_read_frames(decoder, block, SILENCE_SCAN_FRAMES, &got)) == SF_RESULT_SUCCESS && got > 0) {
+            silence_scan_feed(&scan, decoder, block, got);
+        }
+        *out_last_frame = scan.last_sound;
+    }
+
+    av_free(block);
+    decoder->reverse = saved_reverse;
+    decoder->range_set = saved_range_set;
+    decoder->range_loop = saved_range_loop;
+    decoder->range_end = saved_range_end;
+    SF_Result restored = sf_decoder_seek_to_pcm_frame(decoder, FFMAX(0, saved_position - decoder->base_start));
+    return result != SF_RESULT_SUCCESS ? result : restored;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_trim_silence(SF_Decoder* decoder, float threshold_db, int32_t hold_ms,
+                                                int64_t* out_first_frame, int64_t* out_last_frame) {
+    int64_t first = -1, last = -1;
+    SF_Result result = sf_decoder_analyze_silence(decoder, threshold_db, hold_ms, &first, &last);
+    if (out_first_frame) *out_first_frame = first;
+    if (out_last_frame) *out_last_frame = last;
+    if (result != SF_RESULT_SUCCESS || first < 0) return result;
+    return sf_decoder_set_range(decoder, first, last + 1, 0);
+}
+
+// Frees everything the decoder owns and returns it to its freshly created state.
+static void decoder_release(SF_Decoder* decoder) {
+    avcodec_free_context(&decoder->codec_ctx);
+
+    // Custom IO context needs special handling for freeing
+    if (decoder->format_ctx) {
+        if (decoder->format_ctx->pb) {
+            av_freep(&decoder->format_ctx->pb->buffer);
+            avio_context_free(&decoder->format_ctx->pb);
+        }
+        avformat_close_input(&decoder->format_ctx);
+    }
+
+    av_packet_free(&decoder->packet);
+    av_frame_free(&decoder->frame);
+    swr_free(&decoder->swr_ctx);
+    jitter_free(decoder->jitter);
+    av_free(decoder->loop_head);
+    av_free(decoder->reverse_block);
+    av_free(decoder->chain_head);
+    cache_entry_release(decoder->cache_entry);
+    memset(decoder, 0, sizeof(SF_Decoder));
+}
+
+SF_FFMPEG_API void sf_decoder_free(SF_Decoder* decoder) {
+    if (!decoder) return;
+    decoder_release(decoder);
+    free(decoder);
+}
+
+// Decodes the whole stream into a new cache entry. Returns NULL when it does not fit the cache budget.
+static SF_CacheEntry* decoder_fill_cache_entry(SF_Decoder* decoder, uint64_t hash, const char* key, SFSampleFormat native_format) {
+    int frame_bytes = decoder->target_channels * decoder->target_bytes_per_sample;
+    cache_lock();
+    int64_t budget = g_cache.budget;
+    cache_unlock();
+
+    int64_t length = sf_decoder_get_length_in_pcm_frames(decoder);
+    if (length * frame_bytes > budget) return NULL;
+
+    SF_CacheEntry* entry = (SF_CacheEntry*)av_mallocz(sizeof(SF_CacheEntry));
+    if (!entry) return NULL;
+    entry->hash = hash;
+    entry->key = key ? av_strdup(key) : NULL;
+    entry->format = decoder->target_av_format;
+    entry->channels = decoder->target_channels;
+    entry->sample_rate = decoder->codec_ctx->sample_rate;
+    entry->native_format = native_format;
+    atomic_init(&entry->refs, 1);
+
+    // A known length is decoded in one go (the extra frame detects the end); otherwise the buffer grows by half.
+    int64_t capacity = 0;
+    int64_t chunk = FFMAX(4096, length + 1);
+    for (;;) {
+        int64_t needed = (entry->frames + chunk) * frame_bytes;
+        if (needed > budget) break;
+        if (needed > capacity) {
+            uint8_t* pcm = (uint8_t*)av_realloc(entry->pcm, needed);
+            if (!pcm) break;
+            entry->pcm = pcm;
+            capacity = needed;
+        }
+
+        int64_t got = 0;
+        if (decoder_read_frames(decoder, entry->pcm + entry->frames * frame_bytes, chunk, &got) != SF_RESULT_SUCCESS) break;
+        entry->frames += got;
+        if (got < chunk) {
+            entry->bytes = entry->frames * frame_bytes;
+            return entry;
+        }
+        chunk = 4096 + entry->frames / 2;
+    }
+
+    cache_entry_release(entry);
+    return NULL;
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_init_cached(SF_Decoder* decoder, const char* key, sf_read_callback onRead, sf_seek_callback onSeek,
+                                               void* pUserData, SFSampleFormat target_format, SFSampleFormat* out_native_format,
+                                               uint32_t* out_channels, uint32_t* out_samplerate) {
+    if (!decoder || !onRead || !out_native_format || !out_channels || !out_samplerate) return SF_RESULT_ERROR_INVALID_ARGS;
+    enum AVSampleFormat target_av_format = to_ffmpeg_sample_format(target_format);
+    if (target_av_format == AV_SAMPLE_FMT_NONE) return SF_RESULT_DECODER_ERROR_INVALID_TARGET_FORMAT;
+
+    // Without a key the asset cannot be told apart from another with the same bytes where it was sampled, and a wrong
+    // hit would play someone else's audio, so it is decoded without the cache.
+    if (!key) return sf_decoder_init(decoder, onRead, onSeek, pUserData, target_format, out_native_format, out_channels, out_samplerate);
+    uint64_t hash = cache_hash_bytes(CACHE_HASH_SEED, key, strlen(key));
+
+    SF_CacheEntry* entry = cache_lookup(hash, key, target_av_format);
+    if (entry) {
+        atomic_fetch_add(&g_cache.hits, 1);
+    } else {
+        atomic_fetch_add(&g_cache.misses, 1);
+        SF_Result result = sf_decoder_init(decoder, onRead, onSeek, pUserData, target_format, out_native_format, out_channels, out_samplerate);
+        if (result != SF_RESULT_SUCCESS) return result;
+
+        // Too large for the cache (or undecodable to the end): carry on as an ordinary decoder.
+        entry = decoder_fill_cache_entry(decoder, hash, key, *out_native_format);
+        if (!entry) return decoder_seek_exact(decoder, 0);
+        entry = cache_insert(entry);
+    }
+
+    // The decoder only reads the entry from here on; its FFmpeg state is not needed.
+    decoder_release(decoder);
+    decoder->cache_entry = entry;
+    decoder->target_av_format = entry->format;
+    decoder->target_channels = entry->channels;
+    decoder->target_bytes_per_sample = av_get_bytes_per_sample(entry->format);
+    decoder->skip_until = -1;
+    decoder->loop_head_pos = -1;
+
+    *out_native_format = entry->native_format;
+    *out_channels = (uint32_t)entry->channels;
+    *out_samplerate = (uint32_t)entry->sample_rate;
+    return SF_RESULT_SUCCESS;
+}
+
+
+// Encoder Implementation
+
+SF_FFMPEG_API SF_Encoder* sf_encoder_create() {
+    return (SF_Encoder*)calloc(1, sizeof(SF_Encoder));
+}
 
 static int encode_and_write(SF_Encoder* encoder, AVFrame* frame) {
     int ret = avcodec_send_frame(encoder->codec_ctx, frame);
@@ -371,6 +2098,16 @@ static int encode_and_write(SF_Encoder* encoder, AVFrame* frame) {
         } else if (ret < 0) {
             return ret; // Encoding error
         }
+
+        // Raw mode: hand the packet to the caller as-is, timestamps stay in samples at the codec rate.
+        if (encoder->raw_packets) {
+            AVPacket* queued = av_packet_alloc();
+            if (!queued) { av_packet_unref(encoder->packet); return AVERROR(ENOMEM); }
+            av_packet_move_ref(queued, encoder->packet);
+            if (av_fifo_write(encoder->raw_packets, &queued, 1) < 0) { av_packet_free(&queued); return AVERROR(ENOMEM); }
+            continue;
+        }
+
         av_packet_rescale_ts(encoder->packet, encoder->codec_ctx->time_base, encoder->stream->time_base);
         encoder->packet->stream_index = encoder->stream->index;
 
@@ -384,30 +2121,16 @@ static int encode_and_write(SF_Encoder* encoder, AVFrame* frame) {
     return 0;
 }
 
-SF_FFMPEG_API SF_Result sf_encoder_init(SF_Encoder* encoder, const char* format_name, sf_write_callback onWrite, void* pUserData, SFSampleFormat sampleFormat, uint32_t channels, uint32_t sampleRate) {
-    if (!encoder) return SF_RESULT_ERROR_INVALID_ARGS;
-    if (channels == 0 || sampleRate == 0) return SF_RESULT_ERROR_INVALID_ARGS;
-
-    // Set FFmpeg to only log errors
-    av_log_set_level(AV_LOG_ERROR);
-
-    encoder->onWrite = onWrite;
-    encoder->pUserData = pUserData;
+static void encoder_reset_state(SF_Encoder* encoder, SFSampleFormat sampleFormat, uint32_t sampleRate) {
     encoder->next_pts = 0;
+    encoder->finished = 0;
     encoder->input_format = sampleFormat;
     encoder->input_sample_rate = sampleRate;
+}
 
-    const AVOutputFormat* out_fmt = av_guess_format(format_name, NULL, NULL);
-    if (!out_fmt) return SF_RESULT_ENCODER_ERROR_FORMAT_NOT_FOUND;
-
-    avformat_alloc_output_context2(&encoder->format_ctx, out_fmt, NULL, NULL);
-    if (!encoder->format_ctx) return SF_RESULT_ENCODER_ERROR_FORMAT_NOT_FOUND;
-
-    const AVCodec* codec = avcodec_find_encoder(out_fmt->audio_codec);
-    if (!codec) return SF_RESULT_ENCODER_ERROR_CODEC_NOT_FOUND;
-
-    encoder->stream = avformat_new_stream(encoder->format_ctx, codec);
-    if (!encoder->stream) return SF_RESULT_ENCODER_ERROR_STREAM_ALLOC;
+// Allocates and opens the codec context at the target layout and rate.
+static SF_Result encoder_open_codec(SF_Encoder* encoder, const AVCodec* codec, uint32_t targetChannels, uint32_t targetSampleRate,
+                                    int codec_flags, AVDictionary** codec_options) {
     encoder->codec_ctx = avcodec_alloc_context3(codec);
     if (!encoder->codec_ctx) return SF_RESULT_ENCODER_ERROR_CODEC_CONTEXT_ALLOC;
 
@@ -415,7 +2138,7 @@ SF_FFMPEG_API SF_Result sf_encoder_init(SF_Encoder* encoder, const char* format_
     encoder->codec_ctx->strict_std_compliance = FF_COMPLIANCE_EXPERIMENTAL;
 
     AVChannelLayout ch_layout;
-    av_channel_layout_default(&ch_layout, channels);
+    av_channel_layout_default(&ch_layout, targetChannels);
     // Copy the layout to the context. 
     if (av_channel_layout_copy(&encoder->codec_ctx->ch_layout, &ch_layout) < 0) {
         av_channel_layout_uninit(&ch_layout);
@@ -423,8 +2146,8 @@ SF_FFMPEG_API SF_Result sf_encoder_init(SF_Encoder* encoder, const char* format_
     }
     av_channel_layout_uninit(&ch_layout);
 
-    encoder->codec_ctx->sample_rate = sampleRate;
-    encoder->codec_ctx->time_base = (AVRational){1, sampleRate};
+    encoder->codec_ctx->sample_rate = targetSampleRate;
+    encoder->codec_ctx->time_base = (AVRational){1, targetSampleRate};
 
     // Suppress deprecation warnings for sample_fmts for compatibility.
     #pragma GCC diagnostic push
@@ -439,25 +2162,25 @@ SF_FFMPEG_API SF_Result sf_encoder_init(SF_Encoder* encoder, const char* format_
     }
     #pragma GCC diagnostic pop
 
-    if (encoder->format_ctx->oformat->flags & AVFMT_GLOBALHEADER)
-        encoder->codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
-
-    if (avcodec_open2(encoder->codec_ctx, codec, NULL) < 0) return SF_RESULT_ENCODER_ERROR_CODEC_OPEN_FAILED;
-    if (avcodec_parameters_from_context(encoder->stream->codecpar, encoder->codec_ctx) < 0) return SF_RESULT_ENCODER_ERROR_CONTEXT_PARAMS;
-
-    encoder->io_buffer = (uint8_t*)av_malloc(IO_BUFFER_SIZE);
-    encoder->avio_ctx = avio_alloc_context(encoder->io_buffer, IO_BUFFER_SIZE, 1, encoder, NULL, write_packet_callback, NULL);
-    encoder->format_ctx->pb = encoder->avio_ctx;
+    encoder->codec_ctx->flags |= codec_flags;
 
-    if (avformat_write_header(encoder->format_ctx, NULL) < 0) return SF_RESULT_ENCODER_ERROR_WRITE_HEADER;
+    if (avcodec_open2(encoder->codec_ctx, codec, codec_options) < 0) return SF_RESULT_ENCODER_ERROR_CODEC_OPEN_FAILED;
+    return SF_RESULT_SUCCESS;
+}
 
+// Sets up the input conversion and the sample FIFO that feeds the codec fixed-size frames.
+static SF_Result encoder_alloc_conversion(SF_Encoder* encoder, SFSampleFormat sampleFormat, uint32_t channels, uint32_t sampleRate) {
     // Setup resampler to convert from the provided input format to the encoder's required format
     enum AVSampleFormat input_av_format = to_ffmpeg_sample_format(sampleFormat);
     if(input_av_format == AV_SAMPLE_FMT_NONE) return SF_RESULT_ENCODER_ERROR_INVALID_INPUT_FORMAT;
 
+    // The resampler also performs the rate and channel conversion when the target differs from the input.
+    AVChannelLayout input_ch_layout;
+    av_channel_layout_default(&input_ch_layout, channels);
     swr_alloc_set_opts2(&encoder->swr_ctx,
                         &encoder->codec_ctx->ch_layout, encoder->codec_ctx->sample_fmt, encoder->codec_ctx->sample_rate,
-                        &encoder->codec_ctx->ch_layout, input_av_format, sampleRate, 0, NULL);
+                        &input_ch_layout, input_av_format, sampleRate, 0, NULL);
+    av_channel_layout_uninit(&input_ch_layout);
     if (!encoder->swr_ctx || swr_init(encoder->swr_ctx) < 0) return SF_RESULT_ENCODER_ERROR_RESAMPLER_INIT_FAILED;
 
     encoder->packet = av_packet_alloc();
@@ -471,8 +2194,140 @@ SF_FFMPEG_API SF_Result sf_encoder_init(SF_Encoder* encoder, const char* format_
     return SF_RESULT_SUCCESS;
 }
 
+// Attaches the user's callbacks to the muxer as custom I/O and writes the container header.
+static SF_Result encoder_write_header(SF_Encoder* encoder, const char* muxer_options) {
+    // The output may not start at the beginning of the user stream; muxer seeks are offset from where it does.
+    const int64_t base_pos = encoder->onSeek ? encoder->onSeek(encoder->pUserData, 0, SEEK_CUR) : 0;
+    encoder->io_base_pos = FFMAX(0, base_pos);
+
+    // Without a seek callback the output is non-seekable and muxers fall back to streaming-friendly headers.
+    encoder->io_buffer = (uint8_t*)av_malloc(IO_BUFFER_SIZE);
+    if (!encoder->io_buffer) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+    encoder->avio_ctx = avio_alloc_context(encoder->io_buffer, IO_BUFFER_SIZE, 1, encoder, NULL, write_packet_callback,
+                                           encoder->onSeek ? encoder_write_seek_callback : NULL);
+    if (!encoder->avio_ctx) { av_freep(&encoder->io_buffer); return SF_RESULT_ERROR_ALLOCATION_FAILED; }
+    encoder->format_ctx->pb = encoder->avio_ctx;
+    encoder->format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    encoder->format_ctx->opaque = encoder;
+    encoder->format_ctx->io_open = encoder_io_open;
+    encoder->format_ctx->io_close2 = encoder_io_close;
+
+    // Muxer private options, e.g. "movflags=+faststart" or "movflags=+frag_keyframe+empty_moov".
+    AVDictionary* options = NULL;
+    if (muxer_options && muxer_options[0] != '\0' && av_dict_parse_string(&options, muxer_options, "=", ":", 0) < 0) {
+        av_dict_free(&options);
+        return SF_RESULT_ERROR_INVALID_ARGS;
+    }
+    int header_ret = avformat_write_header(encoder->format_ctx, &options);
+    // The muxer leaves what it did not recognise in the dictionary; a misspelt option must not pass silently.
+    int unused = av_dict_count(options);
+    av_dict_free(&options);
+    if (header_ret < 0) return SF_RESULT_ENCODER_ERROR_WRITE_HEADER;
+    if (unused > 0) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    return SF_RESULT_SUCCESS;
+}
+
+SF_FFMPEG_API SF_Result sf_encoder_init(SF_Encoder* encoder, const char* format_name,
+                                        sf_write_callback onWrite, sf_read_callback onRead, sf_seek_callback onSeek, void* pUserData,
+                                        SFSampleFormat sampleFormat, uint32_t channels, uint32_t sampleRate,
+                                        uint32_t targetChannels, uint32_t targetSampleRate, const char* muxer_options) {
+    if (!encoder) return SF_RESULT_ERROR_INVALID_ARGS;
+    if (channels == 0 || sampleRate == 0) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    // Set FFmpeg to only log errors
+    av_log_set_level(AV_LOG_ERROR);
+
+    // A target of 0 keeps the corresponding input property.
+    if (targetChannels == 0) targetChannels = channels;
+    if (targetSampleRate == 0) targetSampleRate = sampleRate;
+
+    encoder->onWrite = onWrite;
+    encoder->onRead = onRead;
+    encoder->onSeek = onSeek;
+    encoder->pUserData = pUserData;
+    encoder->io_stream_pos = encoder->io_write_pos = encoder->io_read_pos = 0;
+    encoder->io_stream_writing = -1;
+    encoder_reset_state(encoder, sampleFormat, sampleRate);
+
+    const AVOutputFormat* out_fmt = av_guess_format(format_name, NULL, NULL);
+    if (!out_fmt) return SF_RESULT_ENCODER_ERROR_FORMAT_NOT_FOUND;
+
+    avformat_alloc_output_context2(&encoder->format_ctx, out_fmt, NULL, NULL);
+    if (!encoder->format_ctx) return SF_RESULT_ENCODER_ERROR_FORMAT_NOT_FOUND;
+
+    const AVCodec* codec = avcodec_find_encoder(out_fmt->audio_codec);
+    if (!codec) return SF_RESULT_ENCODER_ERROR_CODEC_NOT_FOUND;
+
+    encoder->stream = avformat_new_stream(encoder->format_ctx, codec);
+    if (!encoder->stream) return SF_RESULT_ENCODER_ERROR_STREAM_ALLOC;
+
+    int codec_flags = (encoder->format_ctx->oformat->flags & AVFMT_GLOBALHEADER) ? AV_CODEC_FLAG_GLOBAL_HEADER : 0;
+    SF_Result result = encoder_open_codec(encoder, codec, targetChannels, targetSampleRate, codec_flags, NULL);
+    if (result != SF_RESULT_SUCCESS) return result;
+    if (avcodec_parameters_from_context(encoder->stream->codecpar, encoder->codec_ctx) < 0) return SF_RESULT_ENCODER_ERROR_CONTEXT_PARAMS;
+
+    result = encoder_write_header(encoder, muxer_options);
+    if (result != SF_RESULT_SUCCESS) return result;
+
+    return encoder_alloc_conversion(encoder, sampleFormat, channels, sampleRate);
+}
+
+// Adds the codec's own latency option to options, unless the caller set it. The audio encoders ignore
+// AV_CODEC_FLAG_LOW_DELAY, so it is mapped per codec. Returns 0 when the codec has no such control.
+static int encoder_set_low_delay(const AVCodec* codec, AVDictionary** options) {
+    const AVClass* priv_class = codec->priv_class;
+    // Native opus: bounds the look-ahead, and with it the frame duration, in milliseconds.
+    if (priv_class && av_opt_find(&priv_class, "opus_delay", NULL, 0, AV_OPT_SEARCH_FAKE_OBJ)) {
+        return av_dict_set(options, "opus_delay", "10", AV_DICT_DONT_OVERWRITE) >= 0;
+    }
+    return 0;
+}
+
+SF_FFMPEG_API SF_Result sf_encoder_init_raw(SF_Encoder* encoder, const char* codec_name,
+                                            SFSampleFormat sampleFormat, uint32_t channels, uint32_t sampleRate,
+                                            uint32_t targetChannels, uint32_t targetSampleRate,
+                                            uint32_t flags, const char* codec_options) {
+    if (!encoder || !codec_name) return SF_RESULT_ERROR_INVALID_ARGS;
+    if (channels == 0 || sampleRate == 0) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    // Set FFmpeg to only log errors
+    av_log_set_level(AV_LOG_ERROR);
+
+    if (targetChannels == 0) targetChannels = channels;
+    if (targetSampleRate == 0) targetSampleRate = sampleRate;
+    encoder_reset_state(encoder, sampleFormat, sampleRate);
+
+    const AVCodec* codec = avcodec_find_encoder_by_name(codec_name);
+    if (!codec) return SF_RESULT_ENCODER_ERROR_CODEC_NOT_FOUND;
+
+    // Out-of-band extradata (AudioSpecificConfig, OpusHead) is what packet transports such as RTP expect.
+    int codec_flags = AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    // Codec options, e.g. "b=24000" or, for the native opus encoder, "opus_delay=10" for small packets.
+    AVDictionary* options = NULL;
+    if (codec_options && codec_options[0] != '\0' && av_dict_parse_string(&options, codec_options, "=", ":", 0) < 0) {
+        av_dict_free(&options);
+        return SF_RESULT_ERROR_INVALID_ARGS;
+    }
+    if ((flags & SF_ENCODER_FLAG_LOW_DELAY) && !encoder_set_low_delay(codec, &options)) {
+        av_dict_free(&options);
+        return SF_RESULT_ERROR_INVALID_ARGS;
+    }
+    SF_Result result = encoder_open_codec(encoder, codec, targetChannels, targetSampleRate, codec_flags, &options);
+    // Whatever the codec did not consume is misspelt or belongs to another encoder.
+    if (result == SF_RESULT_SUCCESS && av_dict_count(options) > 0) result = SF_RESULT_ERROR_INVALID_ARGS;
+    av_dict_free(&options);
+    if (result != SF_RESULT_SUCCESS) return result;
+
+    encoder->raw_packets = av_fifo_alloc2(8, sizeof(AVPacket*), AV_FIFO_FLAG_AUTO_GROW);
+    if (!encoder->raw_packets) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+
+    return encoder_alloc_conversion(encoder, sampleFormat, channels, sampleRate);
+}
+
 SF_FFMPEG_API SF_Result sf_encoder_write_pcm_frames(SF_Encoder* encoder, void* pFramesIn, int64_t frameCount, int64_t* out_frames_written) {
-    if (!encoder || !pFramesIn || !out_frames_written) return SF_RESULT_ERROR_INVALID_ARGS;
+    if (!encoder || !pFramesIn || !out_frames_written || !encoder->fifo || encoder->finished) return SF_RESULT_ERROR_INVALID_ARGS;
     if (frameCount <= 0) {
         *out_frames_written = 0;
         return SF_RESULT_SUCCESS;
@@ -480,6 +2335,9 @@ SF_FFMPEG_API SF_Result sf_encoder_write_pcm_frames(SF_Encoder* encoder, void* p
 
     *out_frames_written = 0;
 
+    // Raw mode: the caller is not receiving packets. Take nothing until it catches up rather than queue without bound.
+    if (encoder->raw_packets && av_fifo_can_read(encoder->raw_packets) >= RAW_PACKET_QUEUE_MAX) return SF_RESULT_SUCCESS;
+
     // 1. Resample Input Data
     // Use input_sample_rate to calculate correct delay and output count logic
     int64_t delay = swr_get_delay(encoder->swr_ctx, encoder->input_sample_rate);
@@ -579,34 +2437,112 @@ SF_FFMPEG_API SF_Result sf_encoder_write_pcm_frames(SF_Encoder* encoder, void* p
     return SF_RESULT_SUCCESS;
 }
 
-SF_FFMPEG_API void sf_encoder_free(SF_Encoder* encoder) {
-    if (!encoder) return;
+// Drains the resampler and sample FIFO, flushes the codec and, when muxing, writes the trailer.
+static int encoder_finish(SF_Encoder* encoder) {
+    if (!encoder->fifo || encoder->finished) return 0;
+    encoder->finished = 1;
+
+    // Drain the samples still held in the resampler's delay line (non-zero when converting rates).
+    int pending = encoder->swr_ctx ? swr_get_out_samples(encoder->swr_ctx, 0) : 0;
+    if (pending > 0) {
+        av_frame_unref(encoder->temp_frame);
+        encoder->temp_frame->format = encoder->codec_ctx->sample_fmt;
+        av_channel_layout_copy(&encoder->temp_frame->ch_layout, &encoder->codec_ctx->ch_layout);
+        encoder->temp_frame->sample_rate = encoder->codec_ctx->sample_rate;
+        encoder->temp_frame->nb_samples = pending;
+
+        if (av_frame_get_buffer(encoder->temp_frame, 0) >= 0) {
+            int flushed = swr_convert(encoder->swr_ctx, encoder->temp_frame->data, pending, NULL, 0);
+            if (flushed > 0 && av_audio_fifo_realloc(encoder->fifo, av_audio_fifo_size(encoder->fifo) + flushed) >= 0) {
+                av_audio_fifo_write(encoder->fifo, (void**)encoder->temp_frame->data, flushed);
+            }
+        }
+        av_frame_unref(encoder->temp_frame);
+    }
 
     // Flush any remaining samples in FIFO
-    if (encoder->fifo) {
-        int remaining_samples = av_audio_fifo_size(encoder->fifo);
-        if (remaining_samples > 0) {
-            av_frame_unref(encoder->frame);
-            encoder->frame->format = encoder->codec_ctx->sample_fmt;
-            av_channel_layout_copy(&encoder->frame->ch_layout, &encoder->codec_ctx->ch_layout);
-            encoder->frame->sample_rate = encoder->codec_ctx->sample_rate;
-            encoder->frame->nb_samples = remaining_samples;
-            
-            if (av_frame_get_buffer(encoder->frame, 0) >= 0) {
-                if (av_audio_fifo_read(encoder->fifo, (void**)encoder->frame->data, remaining_samples) == remaining_samples) {
-                    encoder->frame->pts = encoder->next_pts;
-                    encoder->next_pts += remaining_samples;
-                    encode_and_write(encoder, encoder->frame);
-                }
+    int ret = 0;
+    int remaining_samples = av_audio_fifo_size(encoder->fifo);
+    if (remaining_samples > 0) {
+        av_frame_unref(encoder->frame);
+        encoder->frame->format = encoder->codec_ctx->sample_fmt;
+        av_channel_layout_copy(&encoder->frame->ch_layout, &encoder->codec_ctx->ch_layout);
+        encoder->frame->sample_rate = encoder->codec_ctx->sample_rate;
+        encoder->frame->nb_samples = remaining_samples;
+        
+        if (av_frame_get_buffer(encoder->frame, 0) >= 0) {
+            if (av_audio_fifo_read(encoder->fifo, (void**)encoder->frame->data, remaining_samples) == remaining_samples) {
+                encoder->frame->pts = encoder->next_pts;
+                encoder->next_pts += remaining_samples;
+                ret = encode_and_write(encoder, encoder->frame);
             }
         }
-        av_audio_fifo_free(encoder->fifo);
+    }
+
+    // Flush the encoder by sending a NULL frame
+    int flush_ret = encode_and_write(encoder, NULL);
+    if (ret >= 0) ret = flush_ret;
+
+    // Write the trailer (only valid if header was successfully written, implied by fifo existence)
+    if (!encoder->raw_packets) {
+        int trailer_ret = av_write_trailer(encoder->format_ctx);
+        if (ret >= 0) ret = trailer_ret;
+        avio_flush(encoder->format_ctx->pb);
+    }
+    return ret;
+}
+
+SF_FFMPEG_API SF_Result sf_encoder_flush(SF_Encoder* encoder) {
+    if (!encoder || !encoder->fifo) return SF_RESULT_ERROR_INVALID_ARGS;
+    int ret = encoder_finish(encoder);
+    if (ret == AVERROR(EIO)) return SF_RESULT_ENCODER_ERROR_WRITE_FAILED;
+    return ret < 0 ? SF_RESULT_ENCODER_ERROR_ENCODING_FAILED : SF_RESULT_SUCCESS;
+}
+
+SF_FFMPEG_API SF_Result sf_encoder_receive_packet(SF_Encoder* encoder, void* pPacketOut, int32_t capacity,
+                                                  int32_t* out_size, int64_t* out_pts, int64_t* out_duration) {
+    if (!encoder || !encoder->raw_packets || !out_size) return SF_RESULT_ERROR_INVALID_ARGS;
+    *out_size = 0;
+
+    AVPacket* pkt = NULL;
+    if (av_fifo_peek(encoder->raw_packets, &pkt, 1, 0) < 0) return SF_RESULT_SUCCESS;  // No packet pending.
+
+    // Leave the packet queued so the caller can retry with a larger buffer.
+    *out_size = pkt->size;
+    if (!pPacketOut || capacity < pkt->size) return SF_RESULT_ENCODER_ERROR_BUFFER_TOO_SMALL;
+
+    memcpy(pPacketOut, pkt->data, pkt->size);
+    if (out_pts) *out_pts = pkt->pts;
+    if (out_duration) *out_duration = pkt->duration;
+
+    av_fifo_read(encoder->raw_packets, &pkt, 1);
+    av_packet_free(&pkt);
+    return SF_RESULT_SUCCESS;
+}
+
+SF_FFMPEG_API int32_t sf_encoder_get_extradata(SF_Encoder* encoder, void* pOut, int32_t capacity) {
+    if (!encoder || !encoder->codec_ctx) return 0;
+    int32_t size = encoder->codec_ctx->extradata_size;
+    if (pOut && capacity >= size && size > 0) memcpy(pOut, encoder->codec_ctx->extradata, size);
+    return size;
+}
 
-        // Flush the encoder by sending a NULL frame
-        encode_and_write(encoder, NULL);
+SF_FFMPEG_API int32_t sf_encoder_get_frame_size(SF_Encoder* encoder) {
+    if (!encoder || !encoder->codec_ctx) return 0;
+    return encoder->codec_ctx->frame_size;
+}
+
+// Finishes and frees everything the encoder owns and returns it to its freshly created state.
+static void encoder_release(SF_Encoder* encoder) {
+    if (encoder->fifo) {
+        encoder_finish(encoder);
+        av_audio_fifo_free(encoder->fifo);
+    }
 
-        // Write the trailer (only valid if header was successfully written, implied by fifo existence)
-        av_write_trailer(encoder->format_ctx);
+    if (encoder->raw_packets) {
+        AVPacket* pkt;
+        while (av_fifo_read(encoder->raw_packets, &pkt, 1) >= 0) av_packet_free(&pkt);
+        av_fifo_freep2(&encoder->raw_packets);
     }
 
     // Free resources. 
@@ -630,9 +2566,691 @@ SF_FFMPEG_API void sf_encoder_free(SF_Encoder* encoder) {
     if (encoder->temp_frame) av_frame_free(&encoder->temp_frame);
     if (encoder->swr_ctx) swr_free(&encoder->swr_ctx);
 
+    memset(encoder, 0, sizeof(SF_Encoder));
+}
+
+SF_FFMPEG_API void sf_encoder_free(SF_Encoder* encoder) {
+    if (!encoder) return;
+    encoder_release(encoder);
     free(encoder);
 }
 
+// Remux Implementation
+
+// Concatenated inputs must produce a stream the muxer accepts without a new header.
+static int remux_params_match(const AVCodecParameters* a, const AVCodecParameters* b) {
+    if (a->codec_id != b->codec_id || a->sample_rate != b->sample_rate ||
+        a->ch_layout.nb_channels != b->ch_layout.nb_channels || a->extradata_size != b->extradata_size) {
+        return 0;
+    }
+    return a->extradata_size == 0 || memcmp(a->extradata, b->extradata, a->extradata_size) == 0;
+}
+
+// Stream-copied ADTS AAC carries its configuration in per-packet headers and has no extradata. MP4-family and
+// Matroska outputs need an AudioSpecificConfig instead, which aac_adtstoasc produces.
+static int remux_needs_adtstoasc(const AVCodecParameters* params, const AVOutputFormat* out_fmt) {
+    return params->codec_id == AV_CODEC_ID_AAC && params->extradata_size == 0 &&
+           av_match_name(out_fmt->name, "mp4,mov,ipod,ismv,3gp,3g2,f4v,matroska");
+}
+
+static SF_Result remux_open_adtstoasc(const AVCodecParameters* params, AVRational time_base, AVBSFContext** out_bsf) {
+    const AVBitStreamFilter* filter = av_bsf_get_by_name("aac_adtstoasc");
+    if (!filter) return SF_RESULT_REMUX_ERROR_INCOMPATIBLE_INPUT;
+    if (av_bsf_alloc(filter, out_bsf) < 0) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+    if (avcodec_parameters_copy((*out_bsf)->par_in, params) < 0) return SF_RESULT_ENCODER_ERROR_CONTEXT_PARAMS;
+    (*out_bsf)->time_base_in = time_base;
+    return av_bsf_init(*out_bsf) < 0 ? SF_RESULT_ENCODER_ERROR_CONTEXT_PARAMS : SF_RESULT_SUCCESS;
+}
+
+// Writes a packet already on the output timeline, through the bitstream filter when there is one. A NULL packet
+// drains the filter.
+static int remux_write_packet(SF_Encoder* output, AVBSFContext* bsf, AVPacket* pkt) {
+    if (!bsf) {
+        int ret = av_interleaved_write_frame(output->format_ctx, pkt);
+        av_packet_unref(pkt);
+        return ret;
+    }
+
+    int ret = av_bsf_send_packet(bsf, pkt);
+    if (ret < 0) {
+        if (pkt) av_packet_unref(pkt);
+        return ret;
+    }
+    AVPacket* filtered = output->packet;
+    while ((ret = av_bsf_receive_packet(bsf, filtered)) >= 0) {
+        filtered->stream_index = output->stream->index;
+        ret = av_interleaved_write_frame(output->format_ctx, filtered);
+        av_packet_unref(filtered);
+        if (ret < 0) return ret;
+    }
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+
+// Moves a packet onto the output timeline: the first kept packet lands on offset. Tracks where the output ends.
+static void remux_rebase_packet(AVPacket* pkt, AVStream* in_stream, AVStream* out_stream, int64_t* origin, int64_t offset, int64_t* end) {
+    if (*origin == AV_NOPTS_VALUE) *origin = pkt->dts;
+    pkt->pts -= *origin;
+    pkt->dts -= *origin;
+    av_packet_rescale_ts(pkt, in_stream->time_base, out_stream->time_base);
+    pkt->pts += offset;
+    pkt->dts += offset;
+    pkt->stream_index = out_stream->index;
+    pkt->pos = -1;
+    if (pkt->dts + pkt->duration > *end) *end = pkt->dts + pkt->duration;
+}
+
+// Copies the packets of one input inside [startFrame, endFrame) to the output stream. Timestamps are shifted so
+// the first kept packet lands on *offset, which is advanced to the end of the last packet written.
+static SF_Result remux_copy_packets(SF_Decoder* input, SF_Encoder* output, AVBSFContext* bsf, const SF_RemuxInput* range, int64_t* offset) {
+    AVStream* in_stream = input->format_ctx->streams[input->stream_index];
+    AVStream* out_stream = output->stream;
+    AVRational frame_tb = (AVRational){1, in_stream->codecpar->sample_rate};
+
+    int64_t start_ts = range->startFrame > 0 ? av_rescale_q(range->startFrame, frame_tb, in_stream->time_base) : AV_NOPTS_VALUE;
+    int64_t end_ts = range->endFrame > 0 ? av_rescale_q(range->endFrame, frame_tb, in_stream->time_base) : AV_NOPTS_VALUE;
+    if (start_ts != AV_NOPTS_VALUE && av_seek_frame(input->format_ctx, input->stream_index, start_ts, AVSEEK_FLAG_BACKWARD) < 0) {
+        return SF_RESULT_DECODER_ERROR_SEEK_FAILED;
+    }
+
+    AVPacket* pkt = input->packet;
+    AVPacket* held = av_packet_alloc();  // A packet before start_ts of unknown duration, until the next shows where it ends.
+    if (!held) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+    int64_t origin = AV_NOPTS_VALUE;   // DTS of the first kept packet, in the input time base.
+    int64_t next_dts = 0;              // Expected DTS of the next packet, for inputs that omit timestamps.
+    int64_t end = *offset;
+    int write_ret = 0;
+    int ret;
+
+    while ((ret = av_read_frame(input->format_ctx, pkt)) >= 0) {
+        if (pkt->stream_index != input->stream_index) { av_packet_unref(pkt); continue; }
+
+        if (pkt->dts == AV_NOPTS_VALUE) pkt->dts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : next_dts;
+        if (pkt->pts == AV_NOPTS_VALUE) pkt->pts = pkt->dts;
+        next_dts = pkt->dts + pkt->duration;
+
+        // The cut is made at packet boundaries: the packet spanning each edge is kept whole. A held packet spans
+        // the start edge exactly when the packet after it begins past start_ts.
+        if (held->data) {
+            if (pkt->pts > start_ts) {
+                remux_rebase_packet(held, in_stream, out_stream, &origin, *offset, &end);
+                if ((write_ret = remux_write_packet(output, bsf, held)) < 0) break;
+            } else {
+                av_packet_unref(held);
+            }
+        }
+        if (start_ts != AV_NOPTS_VALUE && pkt->pts < start_ts) {
+            if (pkt->duration <= 0) { av_packet_move_ref(held, pkt); continue; }
+            if (pkt->pts + pkt->duration <= start_ts) { av_packet_unref(pkt); continue; }
+        }
+        if (end_ts != AV_NOPTS_VALUE && pkt->pts >= end_ts) { av_packet_unref(pkt); break; }
+
+        remux_rebase_packet(pkt, in_stream, out_stream, &origin, *offset, &end);
+        if ((write_ret = remux_write_packet(output, bsf, pkt)) < 0) break;
+    }
+    av_packet_unref(pkt);
+    const int read_failed = write_ret >= 0 && ret < 0 && ret != AVERROR_EOF;
+
+    // A packet still held at the end of the input may reach start_ts; keep it.
+    if (write_ret >= 0 && !read_failed && held->data) {
+        remux_rebase_packet(held, in_stream, out_stream, &origin, *offset, &end);
+        write_ret = remux_write_packet(output, bsf, held);
+    }
+    av_packet_free(&held);
+    if (write_ret >= 0 && !read_failed && bsf) write_ret = remux_write_packet(output, bsf, NULL);
+
+    if (write_ret < 0) return write_ret == AVERROR(EIO) ? SF_RESULT_ENCODER_ERROR_WRITE_FAILED : SF_RESULT_ENCODER_ERROR_ENCODING_FAILED;
+    if (read_failed) return SF_RESULT_DECODER_ERROR_DECODING_FAILED;
+
+    *offset = end;
+    return SF_RESULT_SUCCESS;
+}
+
+SF_FFMPEG_API SF_Result sf_remux(const SF_RemuxInput* inputs, int32_t inputCount, const char* format_name,
+                                 sf_write_callback onWrite, sf_read_callback onRead, sf_seek_callback onSeek, void* pUserData,
+                                 const char* muxer_options) {
+    if (!inputs || inputCount <= 0 || !format_name || !onWrite) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    // Set FFmpeg to only log errors
+    av_log_set_level(AV_LOG_ERROR);
+
+    // The output reuses the encoder's muxer and custom I/O plumbing; it simply never opens a codec.
+    SF_Encoder* output = sf_encoder_create();
+    if (!output) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+    output->onWrite = onWrite;
+    output->onRead = onRead;
+    output->onSeek = onSeek;
+    output->pUserData = pUserData;
+
+    SF_Result result = SF_RESULT_SUCCESS;
+    AVCodecParameters* first_params = NULL;
+    int64_t offset = 0;
+
+    for (int32_t i = 0; i < inputCount && result == SF_RESULT_SUCCESS; i++) {
+        SF_Decoder* input = sf_decoder_create();
+        if (!input) { result = SF_RESULT_ERROR_ALLOCATION_FAILED; break; }
+
+        result = decoder_open_input(input, inputs[i].onRead, inputs[i].onSeek, inputs[i].pUserData, NULL);
+        if (result == SF_RESULT_SUCCESS) {
+            input->packet = av_packet_alloc();
+            if (!input->packet) result = SF_RESULT_DECODER_ERROR_PACKET_FRAME_ALLOC;
+        }
+
+        AVCodecParameters* params = result == SF_RESULT_SUCCESS ? input->format_ctx->streams[input->stream_index]->codecpar : NULL;
+        if (result == SF_RESULT_SUCCESS && i == 0) {
+            // The first input defines the output stream.
+            const AVOutputFormat* out_fmt = av_guess_format(format_name, NULL, NULL);
+            if (!out_fmt || avformat_alloc_output_context2(&output->format_ctx, out_fmt, NULL, NULL) < 0) {
+                result = SF_RESULT_ENCODER_ERROR_FORMAT_NOT_FOUND;
+            } else if (avformat_query_codec(out_fmt, params->codec_id, FF_COMPLIANCE_NORMAL) == 0) {
+                result = SF_RESULT_REMUX_ERROR_INCOMPATIBLE_INPUT;
+            } else if (!(output->stream = avformat_new_stream(output->format_ctx, NULL))) {
+                result = SF_RESULT_ENCODER_ERROR_STREAM_ALLOC;
+            } else if (avcodec_parameters_copy(output->stream->codecpar, params) < 0 ||
+                       !(first_params = avcodec_parameters_alloc()) || avcodec_parameters_copy(first_params, params) < 0) {
+                result = SF_RESULT_ENCODER_ERROR_CONTEXT_PARAMS;
+            } else {
+                // Let the muxer pick the codec tag for its own container.
+                output->stream->codecpar->codec_tag = 0;
+                output->stream->time_base = input->format_ctx->streams[input->stream_index]->time_base;
+                result = encoder_write_header(output, muxer_options);
+            }
+        } else if (result == SF_RESULT_SUCCESS && !remux_params_match(first_params, params)) {
+            result = SF_RESULT_REMUX_ERROR_INCOMPATIBLE_INPUT;
+        }
+
+        AVBSFContext* bsf = NULL;
+        if (result == SF_RESULT_SUCCESS && remux_needs_adtstoasc(params, output->format_ctx->oformat)) {
+            // The filter's output is received into the otherwise unused encoder packet.
+            if (!output->packet && !(output->packet = av_packet_alloc())) result = SF_RESULT_ERROR_ALLOCATION_FAILED;
+            else result = remux_open_adtstoasc(params, output->stream->time_base, &bsf);
+        }
+
+        if (result == SF_RESULT_SUCCESS) result = remux_copy_packets(input, output, bsf, &inputs[i], &offset);
+        av_bsf_free(&bsf);
+        sf_decoder_free(input);
+    }
+
+    if (result == SF_RESULT_SUCCESS) {
+        if (av_write_trailer(output->format_ctx) < 0) result = SF_RESULT_ENCODER_ERROR_WRITE_FAILED;
+        avio_flush(output->format_ctx->pb);
+    }
+
+    avcodec_parameters_free(&first_params);
+    sf_encoder_free(output);
+    return result;
+}
+
+// Transcode Implementation
+
+#define TRANSCODE_BLOCK_FRAMES 4096
+
+// Runs one transcode on caller-owned decoder and encoder handles, which the caller releases afterwards. The batch
+// workers keep the handles and the block buffer across jobs.
+static SF_Result transcode_run(SF_Decoder* decoder, SF_Encoder* encoder, float** block, unsigned int* block_size,
+                               sf_read_callback onRead, sf_seek_callback onSeek, void* pInputUserData,
+                               const char* format_name, sf_write_callback onWrite, sf_read_callback onOutputRead,
+                               sf_seek_callback onOutputSeek, void* pOutputUserData,
+                               uint32_t targetChannels, uint32_t targetSampleRate, float gain,
+                               const char* muxer_options, sf_progress_callback onProgress, void* pProgressUserData) {
+    // Both ends meet at interleaved float: the gain stage works on it directly and the encoder's
+    // resampler performs the single conversion to the codec's format, rate and layout.
+    SFSampleFormat native_format;
+    uint32_t channels = 0, sample_rate = 0;
+    SF_Result result = sf_decoder_init(decoder, onRead, onSeek, pInputUserData, SF_SAMPLE_FORMAT_F32, &native_format, &channels, &sample_rate);
+    if (result != SF_RESULT_SUCCESS) return result;
+
+    result = sf_encoder_init(encoder, format_name, onWrite, onOutputRead, onOutputSeek, pOutputUserData,
+                             SF_SAMPLE_FORMAT_F32, channels, sample_rate, targetChannels, targetSampleRate, muxer_options);
+    if (result != SF_RESULT_SUCCESS) return result;
+
+    av_fast_malloc(block, block_size, sizeof(float) * TRANSCODE_BLOCK_FRAMES * channels);
+    if (!*block) return SF_RESULT_ERROR_ALLOCATION_FAILED;
+
+    int64_t total_frames = sf_decoder_get_length_in_pcm_frames(decoder);
+    int64_t frames_done = 0;
+
+    for (;;) {
+        int64_t frames_read = 0, frames_written = 0;
+        result = sf_decoder_read_pcm_frames(decoder, *block, TRANSCODE_BLOCK_FRAMES, &frames_read);
+        if (result != SF_RESULT_SUCCESS || frames_read == 0) break;
+
+        if (gain != 1.0f) {
+            float* samples = *block;
+            int64_t count = frames_read * channels;
+            for (int64_t i = 0; i < count; i++) samples[i] *= gain;
+        }
+
+        result = sf_encoder_write_pcm_frames(encoder, *block, frames_read, &frames_written);
+        if (result != SF_RESULT_SUCCESS) break;
+        frames_done += frames_read;
+
+        if (onProgress && onProgress(pProgressUserData, frames_done, total_frames) != 0) {
+            result = SF_RESULT_TRANSCODE_CANCELLED;
+            break;
+        }
+    }
+
+    if (result == SF_RESULT_SUCCESS) result = sf_encoder_flush(encoder);
+    return result;
+}
+
+SF_FFMPEG_API SF_Result sf_transcode(sf_read_callback onRead, sf_seek_callback onSeek, void* pInputUserData,
+                                     const char* format_name, sf_write_callback onWrite, sf_read_callback onOutputRead,
+                                     sf_seek_callback onOutputSeek, void* pOutputUserData,
+                                     uint32_t targetChannels, uint32_t targetSampleRate, float gain,
+                                     const char* muxer_options, sf_progress_callback onProgress, void* pProgressUserData) {
+    if (!onRead || !onSeek || !format_name || !onWrite) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    SF_Decoder* decoder = sf_decoder_create();
+    SF_Encoder* encoder = sf_encoder_create();
+    float* block = NULL;
+    unsigned int block_size = 0;
+
+    SF_Result result = SF_RESULT_ERROR_ALLOCATION_FAILED;
+    if (decoder && encoder) {
+        result = transcode_run(decoder, encoder, &block, &block_size, onRead, onSeek, pInputUserData,
+                               format_name, onWrite, onOutputRead, onOutputSeek, pOutputUserData,
+                               targetChannels, targetSampleRate, gain, muxer_options, onProgress, pProgressUserData);
+    }
+
+    av_free(block);
+    sf_decoder_free(decoder);
+    sf_encoder_free(encoder);
+    return result;
+}
+
+// Batch Implementation
+
+typedef struct {
+    const SF_TranscodeJob* jobs;
+    int32_t job_count;
+    atomic_int next_job;
+    sf_job_progress_callback onProgress;
+    sf_job_complete_callback onComplete;
+    void* pUserData;
+    SF_Result* results;
+} SF_Batch;
+
+typedef struct {
+    SF_Batch* batch;
+    int32_t job_index;
+} SF_BatchWorker;
+
+static FILE* batch_fopen(const char* path, const wchar_t* wmode, const char* mode) {
+#ifdef _WIN32
+    // Paths are UTF-8; the narrow CRT functions would interpret them in the ANSI code page.
+    (void)mode;
+    int length = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+    if (length <= 0) return NULL;
+    wchar_t* wpath = (wchar_t*)av_malloc(length * sizeof(wchar_t));
+    if (!wpath) return NULL;
+    MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, length);
+    FILE* file = _wfopen(wpath, wmode);
+    av_free(wpath);
+    return file;
+#else
+    (void)wmode;
+    return fopen(path, mode);
+#endif
+}
+
+static size_t batch_file_read(void* pUserData, void* pBuffer, size_t bytesToRead) {
+    return fread(pBuffer, 1, bytesToRead, (FILE*)pUserData);
+}
+
+static size_t batch_file_write(void* pUserData, void* pBuffer, size_t bytesToWrite) {
+    return fwrite(pBuffer, 1, bytesToWrite, (FILE*)pUserData);
+}
+
+static int64_t batch_file_seek(void* pUserData, int64_t offset, int whence) {
+    FILE* file = (FILE*)pUserData;
+#ifdef _WIN32
+    if (_fseeki64(file, offset, whence) != 0) return -1;
+    return _ftelli64(file);
+#else
+    if (fseeko(file, (off_t)offset, whence) != 0) return -1;
+    return (int64_t)ftello(file);
+#endif
+}
+
+static int batch_progress(void* pUserData, int64_t framesDone, int64_t totalFrames) {
+    SF_BatchWorker* worker = (SF_BatchWorker*)pUserData;
+    return worker->batch->onProgress(worker->batch->pUserData, worker->job_index, framesDone, totalFrames);
+}
+
+static SF_Result batch_run_job(SF_BatchWorker* worker, SF_Decoder* decoder, SF_Encoder* encoder,
+                               float** block, unsigned int* block_size, const SF_TranscodeJob* job) {
+    FILE* input = batch_fopen(job->inputPath, L"rb", "rb");
+    if (!input) return SF_RESULT_TRANSCODE_ERROR_OPEN_FILE;
+    // Opened for update so muxers that read back their output (faststart) work as with seekable streams.
+    FILE* output = batch_fopen(job->outputPath, L"w+b", "w+b");
+    if (!output) { fclose(input); return SF_RESULT_TRANSCODE_ERROR_OPEN_FILE; }
+
+    SF_Result result = transcode_run(decoder, encoder, block, block_size,
+                                     batch_file_read, batch_file_seek, input,
+                                     job->formatName, batch_file_write, batch_file_read, batch_file_seek, output,
+                                     job->targetChannels, job->targetSampleRate, job->gain, job->muxerOptions,
+                                     worker->batch->onProgress ? batch_progress : NULL, worker);
+
+    // Releasing the encoder may still write (trailer after a failure), so it goes before the file is closed.
+    decoder_release(decoder);
+    encoder_release(encoder);
+    fclose(input);
+    if (fclose(output) != 0 && result == SF_RESULT_SUCCESS) result = SF_RESULT_ENCODER_ERROR_WRITE_FAILED;
+    return result;
+}
+
+// Each worker claims whole jobs from a shared cursor. Its decoder and encoder are released after every job, but the
+// handles and the block buffer are kept for the next one, so memory stays bounded by the worker count.
+static void batch_worker_loop(SF_Batch* batch) {
+    SF_Decoder* decoder = sf_decoder_create();
+    SF_Encoder* encoder = sf_encoder_create();
+    float* block = NULL;
+    unsigned int block_size = 0;
+    SF_BatchWorker worker = { batch, -1 };
+
+    int index;
+    while ((index = atomic_fetch_add(&batch->next_job, 1)) < batch->job_count) {
+        worker.job_index = index;
+        SF_Result result = (decoder && encoder)
+            ? batch_run_job(&worker, decoder, encoder, &block, &block_size, &batch->jobs[index])
+            : SF_RESULT_ERROR_ALLOCATION_FAILED;
+
+        batch->results[index] = result;
+        if (batch->onComplete) batch->onComplete(batch->pUserData, index, result);
+    }
+
+    av_free(block);
+    sf_decoder_free(decoder);
+    sf_encoder_free(encoder);
+}
+
+#ifdef _WIN32
+typedef HANDLE batch_thread;
+static DWORD WINAPI batch_thread_main(LPVOID arg) { batch_worker_loop((SF_Batch*)arg); return 0; }
+static int batch_thread_start(batch_thread* thread, SF_Batch* batch) {
+    *thread = CreateThread(NULL, 0, batch_thread_main, batch, 0, NULL);
+    return *thread ? 0 : -1;
+}
+static void batch_thread_join(batch_thread thread) { WaitForSingleObject(thread, INFINITE); CloseHandle(thread); }
+#else
+typedef pthread_t batch_thread;
+static void* batch_thread_main(void* arg) { batch_worker_loop((SF_Batch*)arg); return NULL; }
+static int batch_thread_start(batch_thread* thread, SF_Batch* batch) { return pthread_create(thread, NULL, batch_thread_main, batch); }
+static void batch_thread_join(batch_thread thread) { pthread_join(thread, NULL); }
+#endif
+
+SF_FFMPEG_API SF_Result sf_transcode_batch(const SF_TranscodeJob* jobs, int32_t jobCount, int32_t workerCount,
+                                           sf_job_progress_callback onProgress, sf_job_complete_callback onComplete,
+                                           void* pUserData, SF_Result* out_results) {
+    if (!jobs || jobCount <= 0) return SF_RESULT_ERROR_INVALID_ARGS;
+    for (int32_t i = 0; i < jobCount; i++) {
+        if (!jobs[i].inputPath || !jobs[i].outputPath || !jobs[i].formatName) return SF_RESULT_ERROR_INVALID_ARGS;
+    }
+
+    // Set once up front; the per-job init calls then write the same value from every worker.
+    av_log_set_level(AV_LOG_ERROR);
+
+    if (workerCount <= 0) workerCount = av_cpu_count();
+    workerCount = FFMAX(1, FFMIN(workerCount, jobCount));
+
+    SF_Batch batch = { .jobs = jobs, .job_count = jobCount, .onProgress = onProgress, .onComplete = onComplete, .pUserData = pUserData };
+    atomic_init(&batch.next_job, 0);
+    batch.results = out_results ? out_results : (SF_Result*)av_calloc(jobCount, sizeof(SF_Result));
+    batch_thread* threads = (batch_thread*)av_calloc(workerCount, sizeof(batch_thread));
+    if (!batch.results || !threads) {
+        if (!out_results) av_free(batch.results);
+        av_free(threads);
+        return SF_RESULT_ERROR_ALLOCATION_FAILED;
+    }
+
+    // The calling thread is one of the workers. If a thread fails to start, the others absorb its share.
+    int started = 0;
+    for (int i = 1; i < workerCount; i++) {
+        if (batch_thread_start(&threads[started], &batch) != 0) break;
+        started++;
+    }
+    batch_worker_loop(&batch);
+    for (int i = 0; i < started; i++) batch_thread_join(threads[i]);
+
+    SF_Result result = SF_RESULT_SUCCESS;
+    for (int32_t i = 0; i < jobCount; i++) {
+        if (batch.results[i] != SF_RESULT_SUCCESS) { result = SF_RESULT_TRANSCODE_JOB_FAILED; break; }
+    }
+
+    if (!out_results) av_free(batch.results);
+    av_free(threads);
+    return result;
+}
+
+// Probe Cache
+//
+// The cache file is a header followed by SF_ProbeRecord entries, appended as files are probed. Opening it only reads
+// the fixed part of each record to index it by key hash, so startup cost and memory grow with the record count, not
+// the file size; a hit reads its one record back from the file. Reads go through stdio rather than a mapping, so
+// another process truncating or rewriting the file cannot fault this one. Each record is checksummed when read, and
+// a torn append (a crash, or another process writing at the same time) ends the valid part of the file, which is
+// cut there.
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t avformat_version;   // Codec ids and parameters are only trusted from the FFmpeg build that wrote them.
+    uint32_t avcodec_version;
+} SF_ProbeFileHeader;
+
+typedef struct {
+    uint64_t key_hash;           // 0 marks a free slot.
+    uint64_t head_hash;
+    int64_t offset;              // Of the record in the file.
+    uint32_t size;
+} SF_ProbeSlot;
+
+// stdio buffer of the cache file. Indexing seeks from record to record, so a large buffer would read mostly
+// seek-index entries that are then thrown away.
+#define PROBE_FILE_BUFFER 512
+
+static struct {
+    FILE* file;
+    SF_ProbeSlot* slots;         // Open addressing, power-of-two capacity.
+    int capacity;
+    int count;
+} g_probe;
+
+#ifdef _WIN32
+static SRWLOCK g_probe_lock = SRWLOCK_INIT;
+static void probe_lock(void) { AcquireSRWLockExclusive(&g_probe_lock); }
+static void probe_unlock(void) { ReleaseSRWLockExclusive(&g_probe_lock); }
+#else
+static pthread_mutex_t g_probe_lock = PTHREAD_MUTEX_INITIALIZER;
+static void probe_lock(void) { pthread_mutex_lock(&g_probe_lock); }
+static void probe_unlock(void) { pthread_mutex_unlock(&g_probe_lock); }
+#endif
+
+static uint32_t probe_record_checksum(const SF_ProbeRecord* record) {
+    const uint8_t* bytes = (const uint8_t*)record;
+    size_t skip = offsetof(SF_ProbeRecord, checksum) + sizeof(record->checksum);
+    uint64_t hash = cache_hash_bytes(CACHE_HASH_SEED, bytes + skip, record->size - skip);
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+// Checks the fixed part of a record: its size must hold the trailing data it declares.
+static int probe_record_is_sane(const SF_ProbeRecord* record) {
+    if (record->size < sizeof(SF_ProbeRecord) || (record->size & 7)) return 0;
+    if (record->index_count < 0 || record->extradata_size < 0) return 0;
+    return sizeof(SF_ProbeRecord) + (uint64_t)record->index_count * sizeof(SF_ProbeIndexEntry) +
+           (uint64_t)record->extradata_size <= record->size;
+}
+
+// Under probe_lock. Adds or replaces the slot for the key.
+static int probe_table_put(uint64_t key_hash, uint64_t head_hash, int64_t offset, uint32_t size) {
+    if ((g_probe.count + 1) * 4 > g_probe.capacity * 3) {
+        int capacity = g_probe.capacity ? g_probe.capacity * 2 : 1024;
+        SF_ProbeSlot* slots = (SF_ProbeSlot*)av_calloc(capacity, sizeof(SF_ProbeSlot));
+        if (!slots) return 0;
+        for (int i = 0; i < g_probe.capacity; i++) {
+            if (!g_probe.slots[i].key_hash) continue;
+            int j = (int)(g_probe.slots[i].key_hash & (uint64_t)(capacity - 1));
+            while (slots[j].key_hash) j = (j + 1) & (capacity - 1);
+            slots[j] = g_probe.slots[i];
+        }
+        av_free(g_probe.slots);
+        g_probe.slots = slots;
+        g_probe.capacity = capacity;
+    }
+
+    if (!key_hash) key_hash = 1;
+    int i = (int)(key_hash & (uint64_t)(g_probe.capacity - 1));
+    while (g_probe.slots[i].key_hash && g_probe.slots[i].key_hash != key_hash) i = (i + 1) & (g_probe.capacity - 1);
+    if (!g_probe.slots[i].key_hash) g_probe.count++;
+
+    SF_ProbeSlot slot = { key_hash, head_hash, offset, size };
+    g_probe.slots[i] = slot;
+    return 1;
+}
+
+// Under probe_lock. Reads the record for the key back from the file, or returns NULL. A record that no longer
+// checks out (the file was rewritten under us) is a miss; probing again appends a fresh one that replaces it.
+static SF_ProbeRecord* probe_table_get(uint64_t key_hash, uint64_t head_hash) {
+    if (!g_probe.capacity || !g_probe.file) return NULL;
+    uint64_t slot_key = key_hash ? key_hash : 1;
+    int i = (int)(slot_key & (uint64_t)(g_probe.capacity - 1));
+    while (g_probe.slots[i].key_hash && g_probe.slots[i].key_hash != slot_key) i = (i + 1) & (g_probe.capacity - 1);
+    const SF_ProbeSlot* slot = &g_probe.slots[i];
+    if (!slot->key_hash || slot->head_hash != head_hash) return NULL;
+
+    SF_ProbeRecord* record = (SF_ProbeRecord*)av_malloc(slot->size);
+    if (!record) return NULL;
+    if (batch_file_seek(g_probe.file, slot->offset, SEEK_SET) != slot->offset ||
+        fread(record, slot->size, 1, g_probe.file) != 1 || record->size != slot->size || !probe_record_is_sane(record) ||
+        probe_record_checksum(record) != record->checksum || record->key_hash != key_hash || record->head_hash != head_hash) {
+        av_free(record);
+        return NULL;
+    }
+    return record;
+}
+
+static void probe_cache_close_locked(void) {
+    av_freep(&g_probe.slots);
+    g_probe.capacity = g_probe.count = 0;
+    if (g_probe.file) fclose(g_probe.file);
+    g_probe.file = NULL;
+}
+
+// Under probe_lock. Indexes the records of the file from their fixed parts, returning the offset after the last
+// one that fits, or 0 when the header is missing or from another FFmpeg build.
+static int64_t probe_cache_scan(int64_t file_size) {
+    SF_ProbeFileHeader expected = { { 'S', 'F', 'P', 'C' }, PROBE_FILE_VERSION, avformat_version(), avcodec_version() };
+    SF_ProbeFileHeader header;
+    if (file_size < (int64_t)sizeof(header) || batch_file_seek(g_probe.file, 0, SEEK_SET) != 0 ||
+        fread(&header, sizeof(header), 1, g_probe.file) != 1 || memcmp(&header, &expected, sizeof(header)) != 0) {
+        return 0;
+    }
+
+    int64_t end = sizeof(header);
+    SF_ProbeRecord record;
+    while (end + (int64_t)sizeof(record) <= file_size) {
+        if (batch_file_seek(g_probe.file, end, SEEK_SET) != end || fread(&record, sizeof(record), 1, g_probe.file) != 1) break;
+        if (!probe_record_is_sane(&record) || end + record.size > file_size) break;
+        if (!probe_table_put(record.key_hash, record.head_hash, end, record.size)) return -1;
+        end += record.size;
+    }
+    return end;
+}
+
+// Under probe_lock, with the file open. A new, foreign or outdated file starts over with a fresh header; a torn
+// tail is cut off, keeping the records before it.
+static int probe_cache_load(void) {
+    if (batch_file_seek(g_probe.file, 0, SEEK_END) < 0) return 0;
+    int64_t file_size = batch_file_seek(g_probe.file, 0, SEEK_CUR);
+
+    int64_t end = probe_cache_scan(file_size);
+    if (end < 0) return 0;
+    if (end > 0 && end == file_size) return 1;
+
+    fflush(g_probe.file);
+#ifdef _WIN32
+    if (_chsize_s(_fileno(g_probe.file), end) != 0) return 0;
+#else
+    if (ftruncate(fileno(g_probe.file), (off_t)end) != 0) return 0;
+#endif
+    if (end == 0) {
+        SF_ProbeFileHeader header = { { 'S', 'F', 'P', 'C' }, PROBE_FILE_VERSION, avformat_version(), avcodec_version() };
+        if (batch_file_seek(g_probe.file, 0, SEEK_SET) != 0) return 0;
+        if (fwrite(&header, sizeof(header), 1, g_probe.file) != 1 || fflush(g_probe.file) != 0) return 0;
+    }
+    return 1;
+}
+
+SF_FFMPEG_API SF_Result sf_probe_cache_open(const char* path) {
+    if (!path) return SF_RESULT_ERROR_INVALID_ARGS;
+
+    probe_lock();
+    probe_cache_close_locked();
+    g_probe.file = batch_fopen(path, L"r+b", "r+b");
+    if (!g_probe.file) g_probe.file = batch_fopen(path, L"w+b", "w+b");
+    if (g_probe.file) setvbuf(g_probe.file, NULL, _IOFBF, PROBE_FILE_BUFFER);
+
+    SF_Result result = SF_RESULT_SUCCESS;
+    if (!g_probe.file) {
+        result = SF_RESULT_PROBE_CACHE_ERROR_OPEN_FILE;
+    } else if (!probe_cache_load()) {
+        probe_cache_close_locked();
+        result = SF_RESULT_PROBE_CACHE_ERROR_OPEN_FILE;
+    }
+    probe_unlock();
+    return result;
+}
+
+SF_FFMPEG_API void sf_probe_cache_close(void) {
+    probe_lock();
+    probe_cache_close_locked();
+    probe_unlock();
+}
+
+SF_FFMPEG_API SF_Result sf_decoder_init_probe_cached(SF_Decoder* decoder, const char* key, sf_read_callback onRead,
+                                                     sf_seek_callback onSeek, void* pUserData, SFSampleFormat target_format,
+                                                     SFSampleFormat* out_native_format, uint32_t* out_channels,
+                                                     uint32_t* out_samplerate) {
+    probe_lock();
+    int open = g_probe.file != NULL;
+    probe_unlock();
+    if (!open || !key || !onRead || !onSeek) {
+        return sf_decoder_init(decoder, onRead, onSeek, pUserData, target_format, out_native_format, out_channels, out_samplerate);
+    }
+
+    // The head hash catches files rewritten in place; the stream is rewound for the demuxer afterwards.
+    uint8_t head[PROBE_HEAD_BYTES];
+    size_t head_size = 0, read;
+    while (head_size < sizeof(head) && (read = onRead(pUserData, head + head_size, sizeof(head) - head_size)) > 0) head_size += read;
+    if (onSeek(pUserData, 0, SEEK_SET) < 0) return SF_RESULT_DECODER_ERROR_SEEK_FAILED;
+    uint64_t key_hash = cache_hash_bytes(CACHE_HASH_SEED, key, strlen(key));
+    uint64_t head_hash = cache_hash_bytes(CACHE_HASH_SEED, head, head_size);
+
+    probe_lock();
+    SF_ProbeRecord* probe = probe_table_get(key_hash, head_hash);
+    probe_unlock();
+
+    SF_Result result = decoder_init(decoder, onRead, onSeek, pUserData, probe, target_format, out_native_format, out_channels, out_samplerate);
+    av_free(probe);
+    if (result != SF_RESULT_SUCCESS || probe) return result;
+
+    SF_ProbeRecord* record = probe_record_build(decoder->format_ctx, decoder->stream_index, key_hash, head_hash);
+    if (!record) return result;
+    record->checksum = probe_record_checksum(record);
+
+    probe_lock();
+    int64_t offset = g_probe.file ? batch_file_seek(g_probe.file, 0, SEEK_END) : -1;
+    // A failed append is harmless: the next load stops at the partial record and cuts it off.
+    if (offset >= 0 && fwrite(record, record->size, 1, g_probe.file) == 1 && fflush(g_probe.file) == 0) {
+        probe_table_put(key_hash, head_hash, offset, record->size);
+    }
+    probe_unlock();
+    av_free(record);
+    return result;
+}
+
+
 // Helper Implementation
 
 SF_FFMPEG_API const char* sf_result_to_string(SF_Result result) {
@@ -651,6 +3269,7 @@ SF_FFMPEG_API const char* sf_result_to_string(SF_Result result) {
         case SF_RESULT_DECODER_ERROR_PACKET_FRAME_ALLOC: return "Failed to allocate packet or frame";
         case SF_RESULT_DECODER_ERROR_SEEK_FAILED: return "Seek operation failed";
         case SF_RESULT_DECODER_ERROR_DECODING_FAILED: return "An unrecoverable error occurred during the decoding process";
+        case SF_RESULT_DECODER_ERROR_CHAIN_FORMAT_MISMATCH: return "The chained decoder's output format does not match";
         case SF_RESULT_ENCODER_ERROR_FORMAT_NOT_FOUND: return "Output format not found";
         case SF_RESULT_ENCODER_ERROR_CODEC_NOT_FOUND: return "Audio codec for the format not found or not enabled";
         case SF_RESULT_ENCODER_ERROR_STREAM_ALLOC: return "Failed to allocate new audio stream";
@@ -663,6 +3282,12 @@ SF_FFMPEG_API const char* sf_result_to_string(SF_Result result) {
         case SF_RESULT_ENCODER_ERROR_PACKET_FRAME_ALLOC: return "Failed to allocate packet or frame for encoding";
         case SF_RESULT_ENCODER_ERROR_ENCODING_FAILED: return "An unrecoverable error occurred during the encoding process";
         case SF_RESULT_ENCODER_ERROR_WRITE_FAILED: return "An I/O error occurred while writing the encoded data";
+        case SF_RESULT_ENCODER_ERROR_BUFFER_TOO_SMALL: return "The output buffer is too small for the encoded packet";
+        case SF_RESULT_TRANSCODE_CANCELLED: return "The transcode was cancelled by the progress callback";
+        case SF_RESULT_TRANSCODE_JOB_FAILED: return "One or more transcode jobs failed";
+        case SF_RESULT_TRANSCODE_ERROR_OPEN_FILE: return "Failed to open an input or output file";
+        case SF_RESULT_REMUX_ERROR_INCOMPATIBLE_INPUT: return "Input codec parameters are not supported by the output format or differ between inputs";
+        case SF_RESULT_PROBE_CACHE_ERROR_OPEN_FILE: return "Failed to open or create the probe cache file";
         default: return "Unknown error";
     }
 }
\ No newline at end of file
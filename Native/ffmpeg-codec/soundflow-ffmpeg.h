@@ -46,6 +46,7 @@ typedef enum {
     SF_RESULT_DECODER_ERROR_PACKET_FRAME_ALLOC = -18,
     SF_RESULT_DECODER_ERROR_SEEK_FAILED = -19,
     SF_RESULT_DECODER_ERROR_DECODING_FAILED = -20,
+    SF_RESULT_DECODER_ERROR_CHAIN_FORMAT_MISMATCH = -21,
 
     // Encoder-specific Errors
     SF_RESULT_ENCODER_ERROR_FORMAT_NOT_FOUND = -30,
@@ -59,10 +60,40 @@ typedef enum {
     SF_RESULT_ENCODER_ERROR_RESAMPLER_INIT_FAILED = -38,
     SF_RESULT_ENCODER_ERROR_PACKET_FRAME_ALLOC = -39,
     SF_RESULT_ENCODER_ERROR_ENCODING_FAILED = -40,
-    SF_RESULT_ENCODER_ERROR_WRITE_FAILED = -41
+    SF_RESULT_ENCODER_ERROR_WRITE_FAILED = -41,
+    SF_RESULT_ENCODER_ERROR_BUFFER_TOO_SMALL = -42,
+
+    // Remux-specific Errors
+    SF_RESULT_REMUX_ERROR_INCOMPATIBLE_INPUT = -50,
+
+    // Transcode-specific Errors
+    SF_RESULT_TRANSCODE_CANCELLED = -60,
+    SF_RESULT_TRANSCODE_JOB_FAILED = -61,
+    SF_RESULT_TRANSCODE_ERROR_OPEN_FILE = -62,
+
+    // Probe cache-specific Errors
+    SF_RESULT_PROBE_CACHE_ERROR_OPEN_FILE = -70
 
 } SF_Result;
 
+typedef enum {
+    SF_ENCODER_FLAG_NONE = 0,
+    // Raw mode: switch the codec to its low-latency settings (opus_delay=10 for the native opus encoder).
+    // Codecs without such settings, e.g. aac, fail with SF_RESULT_ERROR_INVALID_ARGS.
+    SF_ENCODER_FLAG_LOW_DELAY = 1 << 0,
+} SFEncoderFlags;
+
+// How a decoder's length was determined, from least to most reliable.
+typedef enum {
+    SF_DURATION_UNKNOWN = 0,
+    // Guessed by the demuxer from the bitrate; off for VBR and concatenated streams.
+    SF_DURATION_ESTIMATE = 1,
+    // Read from the container or stream headers.
+    SF_DURATION_HEADER = 2,
+    // Counted packet by packet by sf_decoder_scan_length.
+    SF_DURATION_SCANNED = 3,
+} SFDurationSource;
+
 // Callbacks for custom I/O
 typedef size_t (*sf_read_callback)(void* pUserData, void* pBuffer,
                                    size_t bytesToRead);
@@ -70,6 +101,42 @@ typedef int64_t (*sf_seek_callback)(void* pUserData, int64_t offset,
                                     int whence);
 typedef size_t (*sf_write_callback)(void* pUserData, void* pBuffer,
                                     size_t bytesToWrite);
+// Reports progress in input PCM frames; totalFrames is 0 when the length is unknown.
+// Return non-zero to cancel the operation.
+typedef int (*sf_progress_callback)(void* pUserData, int64_t framesDone, int64_t totalFrames);
+// Per-job variants used by sf_transcode_batch. They are called from the worker threads.
+typedef int (*sf_job_progress_callback)(void* pUserData, int32_t jobIndex, int64_t framesDone, int64_t totalFrames);
+typedef void (*sf_job_complete_callback)(void* pUserData, int32_t jobIndex, SF_Result result);
+
+// One input of sf_remux. Frames are PCM frames at the input's sample rate.
+typedef struct {
+    sf_read_callback onRead;
+    sf_seek_callback onSeek;
+    void* pUserData;
+    int64_t startFrame;  // 0 to start at the beginning.
+    int64_t endFrame;    // 0 to copy to the end.
+} SF_RemuxInput;
+
+// One job of sf_transcode_batch. Paths are UTF-8. The other fields behave as the sf_transcode parameters.
+typedef struct {
+    const char* inputPath;
+    const char* outputPath;
+    const char* formatName;
+    uint32_t targetChannels;
+    uint32_t targetSampleRate;
+    float gain;
+    const char* muxerOptions;
+} SF_TranscodeJob;
+
+// Counters of the process-wide decoded PCM cache (sf_decoder_init_cached).
+typedef struct {
+    int64_t hits;
+    int64_t misses;
+    int64_t evictions;
+    int64_t entries;
+    int64_t bytes;   // PCM held by cached entries.
+    int64_t budget;
+} SF_CacheStats;
 
 // Decoder Functions
 SF_FFMPEG_API SF_Decoder* sf_decoder_create();
@@ -80,27 +147,190 @@ SF_FFMPEG_API SF_Result sf_decoder_init(
     SFSampleFormat* out_native_format,  // The original format of the file
     uint32_t* out_channels, uint32_t* out_samplerate);
 SF_FFMPEG_API int64_t sf_decoder_get_length_in_pcm_frames(SF_Decoder* decoder);
+// Same as sf_decoder_get_length_in_pcm_frames, also reporting how the length was determined. out_source may be NULL.
+SF_FFMPEG_API int64_t sf_decoder_get_length_info(SF_Decoder* decoder, SFDurationSource* out_source);
+// Counts the stream's frames by walking its packets without decoding them, which runs at I/O speed, and caches the
+// result: later calls return immediately and the length functions report it as SF_DURATION_SCANNED. The read
+// position is preserved. Requires a seekable input.
+SF_FFMPEG_API SF_Result sf_decoder_scan_length(SF_Decoder* decoder, int64_t* out_frames);
 SF_FFMPEG_API SF_Result sf_decoder_read_pcm_frames(SF_Decoder* decoder,
                                                    void* pFramesOut,
                                                    int64_t frameCount,
                                                    int64_t* out_frames_read);
+// Planar mode: the resampler writes each channel to its own buffer, so non-interleaved consumers skip an
+// interleave/deinterleave round trip. Reads then go through sf_decoder_read_pcm_frames_planar and
+// sf_decoder_read_pcm_frames is rejected. Planar mode excludes looped ranges, reverse mode, chaining and silence
+// analysis. Switching modes mid-stream re-decodes from the current position.
+SF_FFMPEG_API SF_Result sf_decoder_set_planar(SF_Decoder* decoder, int32_t planar);
+// pChannelsOut holds one buffer per channel, each with room for frameCount samples of the target format.
+SF_FFMPEG_API SF_Result sf_decoder_read_pcm_frames_planar(SF_Decoder* decoder, void** pChannelsOut, int64_t frameCount,
+                                                         int64_t* out_frames_read);
+// Seeks so that the next frame read is exactly frameIndex.
 SF_FFMPEG_API SF_Result sf_decoder_seek_to_pcm_frame(SF_Decoder* decoder,
                                                      int64_t frameIndex);
+// Restricts reads to [start_frame, end_frame) and seeks to start_frame. end_frame 0 plays to the end of the stream.
+// Reads stop exactly at end_frame. With loop set they wrap to start_frame instead: the first 500 ms of the range
+// are pre-decoded here, so each wrap is spliced from memory and the seek to the continuation point is deferred
+// until that head has been played. Pass 0, 0, 0 to clear the range.
+SF_FFMPEG_API SF_Result sf_decoder_set_range(SF_Decoder* decoder, int64_t start_frame, int64_t end_frame, int32_t loop);
+// Reverse mode: reads return frames backwards, the next one being the frame before the current position, and stop
+// at the start of the stream or range (a looped range wraps to its end). The stream is decoded in one-second blocks
+// from seek points and each block is reversed in memory, so memory use is bounded and playback starts immediately.
+// Seeking sets the position reads continue backwards from. Leaving reverse mode resumes forward decoding there.
+SF_FFMPEG_API SF_Result sf_decoder_set_reverse(SF_Decoder* decoder, int32_t reverse);
+// Gapless mode strips exactly the encoder delay and padding. The delay comes from the skip count the demuxer reports
+// (LAME/Xing headers, Opus pre-skip, MP4 edit lists), else from iTunSMPB metadata, else from the codec parameters;
+// the padding from the same sources or the codec's end-of-stream markers. Frame indices, lengths and ranges then
+// count from the first real frame. Switching reopens the codec, clears any range and seeks to the start.
+SF_FFMPEG_API SF_Result sf_decoder_set_gapless(SF_Decoder* decoder, int32_t gapless);
+// Chains next after decoder: once decoder's stream ends, the same read call continues with next's frames. The first
+// 500 ms of next are decoded here, so call this while the current track is still playing and the transition will not
+// wait on next's demuxer or codec. Both must produce the same sample format, channel count and sample rate. Once
+// handed over, decoder stands in for next (reads, seeks and further chaining go to it). Pass NULL to unchain.
+// next must outlive decoder, or be unchained first.
+SF_FFMPEG_API SF_Result sf_decoder_chain(SF_Decoder* decoder, SF_Decoder* next);
+// Returns 1 once decoder has handed over completely to its chained decoder, which can from then on be read directly.
+SF_FFMPEG_API int32_t sf_decoder_chain_finished(SF_Decoder* decoder);
+// Finds the first and last non-silent frames. A frame is silent when every channel is at or below threshold_db (dBFS);
+// sound has to last hold_ms before it counts, so isolated clicks and noise spikes are ignored. Only the silent edges
+// are decoded: forwards from the start until sound begins, then backwards from the end (forwards to the end when the
+// length is unknown). Both outputs are -1 for an entirely silent stream. The read position, range and direction are
+// left as they were.
+SF_FFMPEG_API SF_Result sf_decoder_analyze_silence(SF_Decoder* decoder, float threshold_db, int32_t hold_ms,
+                                                   int64_t* out_first_frame, int64_t* out_last_frame);
+// Runs sf_decoder_analyze_silence and restricts reads to the non-silent part with sf_decoder_set_range, so the
+// silence never reaches the caller. An entirely silent stream is left untouched. The outputs may be NULL.
+SF_FFMPEG_API SF_Result sf_decoder_trim_silence(SF_Decoder* decoder, float threshold_db, int32_t hold_ms,
+                                                int64_t* out_first_frame, int64_t* out_last_frame);
+// Like sf_decoder_init, but backed by a process-wide cache of fully decoded assets, for short sounds opened over and
+// over. key identifies the asset, e.g. its path, size and modification time; with key NULL this is plain
+// sf_decoder_init, as there is nothing reliable to tell the asset apart from others by. On a hit nothing is probed or decoded: reads are served from the shared PCM. On a miss the stream is decoded
+// once, published, and served the same way. An asset larger than the cache budget is decoded as usual. Cache-backed
+// decoders support reading, seeking, length queries and chaining; the other decoder modes return
+// SF_RESULT_ERROR_INVALID_ARGS. Lookups take no lock.
+SF_FFMPEG_API SF_Result sf_decoder_init_cached(SF_Decoder* decoder, const char* key, sf_read_callback onRead, sf_seek_callback onSeek,
+                                               void* pUserData, SFSampleFormat target_format, SFSampleFormat* out_native_format,
+                                               uint32_t* out_channels, uint32_t* out_samplerate);
+// Sets the cache's memory budget in bytes (64 MiB by default), evicting least recently used entries to fit.
+// 0 disables caching. Decoders still reading an evicted entry keep it alive until they are freed.
+SF_FFMPEG_API void sf_cache_set_budget(int64_t bytes);
+SF_FFMPEG_API void sf_cache_clear(void);
+SF_FFMPEG_API void sf_cache_get_stats(SF_CacheStats* out_stats);
+// Raw packet mode: no demuxer and no AVIO. codec_name is a decoder name, e.g. "opus", "aac", "mp3".
+// pExtraData is the codec's out-of-band configuration (see sf_encoder_get_extradata) and may be NULL.
+// channels/sampleRate describe the stream and may be 0 when the extradata carries them.
+// jitterDepth is the minimum number of packets buffered before playout (0 for the default); the
+// buffer deepens on its own when packets arrive late or run out.
+SF_FFMPEG_API SF_Result sf_decoder_init_raw(SF_Decoder* decoder, const char* codec_name,
+                                            const void* pExtraData, int32_t extraDataSize,
+                                            uint32_t channels, uint32_t sampleRate, int32_t jitterDepth,
+                                            SFSampleFormat target_format, SFSampleFormat* out_native_format,
+                                            uint32_t* out_channels, uint32_t* out_samplerate);
+// Raw mode only. Queues a packet in the jitter buffer, which reorders packets by pts before decoding.
+// pts is in samples at the codec sample rate; pass -1 to play the packet in arrival order.
+// Packets arriving after their slot was played are dropped and counted as late.
+// sf_decoder_read_pcm_frames then returns decoded audio, concealing packets that never arrived by
+// fading out a repeat of the last decoded frame. It returns fewer frames than requested while the
+// jitter buffer is (re)filling, so it should be called once per device period.
+SF_FFMPEG_API SF_Result sf_decoder_send_packet(SF_Decoder* decoder, const void* pData, int32_t size, int64_t pts);
+// Raw mode only. Any output pointer may be NULL.
+SF_FFMPEG_API SF_Result sf_decoder_get_jitter_stats(SF_Decoder* decoder, int32_t* out_buffered_packets,
+                                                    int32_t* out_target_depth, int64_t* out_concealed_frames,
+                                                    int64_t* out_late_packets);
 SF_FFMPEG_API void sf_decoder_free(SF_Decoder* decoder);
 
 // Encoder Functions
 SF_FFMPEG_API SF_Encoder* sf_encoder_create();
 // format_name is e.g. "mp3", "flac", "wav", "opus"
+// onSeek is optional; when set, muxers can seek back to finalise headers (WAV sizes, FLAC STREAMINFO, MP4 moov).
+// onRead is optional and only needed by muxers that read back their output (movflags=+faststart).
+// targetChannels/targetSampleRate select the encoded layout and rate; pass 0 to keep the input value.
+// libswresample converts from the input to the target inside the encoder.
+// muxer_options is an optional "key=value:key=value" list of muxer options, e.g. "movflags=+faststart". A ':', '=',
+// '\' or quote inside a key or value is escaped with a backslash. An option the muxer does not recognise fails the
+// init with SF_RESULT_ERROR_INVALID_ARGS.
 SF_FFMPEG_API SF_Result sf_encoder_init(SF_Encoder* encoder, const char* format_name,
-                                        sf_write_callback onWrite, void* pUserData,
+                                        sf_write_callback onWrite, sf_read_callback onRead,
+                                        sf_seek_callback onSeek, void* pUserData,
                                         SFSampleFormat sampleFormat,
-                                        uint32_t channels, uint32_t sampleRate);
+                                        uint32_t channels, uint32_t sampleRate,
+                                        uint32_t targetChannels, uint32_t targetSampleRate,
+                                        const char* muxer_options);
+// Raw packet mode: no muxer and no AVIO. codec_name is an encoder name, e.g. "opus", "aac", "libmp3lame".
+// flags is a combination of SFEncoderFlags. codec_options is an optional "key=value:key=value" list of
+// codec options, e.g. "b=24000". The native opus encoder's packet duration is bounded by "opus_delay"
+// (milliseconds, 2.5 to 360). Options the codec does not recognise fail with SF_RESULT_ERROR_INVALID_ARGS.
+// Encoded packets are retrieved with sf_encoder_receive_packet. While 1024 of them are waiting,
+// sf_encoder_write_pcm_frames consumes nothing and reports 0 frames written.
+SF_FFMPEG_API SF_Result sf_encoder_init_raw(SF_Encoder* encoder, const char* codec_name,
+                                            SFSampleFormat sampleFormat,
+                                            uint32_t channels, uint32_t sampleRate,
+                                            uint32_t targetChannels, uint32_t targetSampleRate,
+                                            uint32_t flags, const char* codec_options);
 SF_FFMPEG_API SF_Result sf_encoder_write_pcm_frames(SF_Encoder* encoder,
                                                     void* pFramesIn,
                                                     int64_t frameCount,
                                                     int64_t* out_frames_written);
+// Encodes the buffered tail and flushes the codec (and writes the trailer when muxing).
+// No more frames can be written afterwards. Called implicitly by sf_encoder_free.
+SF_FFMPEG_API SF_Result sf_encoder_flush(SF_Encoder* encoder);
+// Raw mode only. Copies the next encoded packet into pPacketOut. *out_size is 0 when no packet is pending.
+// PTS and duration are in samples at the encoded sample rate. If capacity is too small,
+// SF_RESULT_ENCODER_ERROR_BUFFER_TOO_SMALL is returned with the required size and the packet stays queued.
+SF_FFMPEG_API SF_Result sf_encoder_receive_packet(SF_Encoder* encoder, void* pPacketOut, int32_t capacity,
+                                                  int32_t* out_size, int64_t* out_pts, int64_t* out_duration);
+// Returns the codec extradata size and copies it to pOut when capacity allows.
+SF_FFMPEG_API int32_t sf_encoder_get_extradata(SF_Encoder* encoder, void* pOut, int32_t capacity);
+// Returns the number of samples per encoded packet, or 0 for variable-size codecs.
+SF_FFMPEG_API int32_t sf_encoder_get_frame_size(SF_Encoder* encoder);
 SF_FFMPEG_API void sf_encoder_free(SF_Encoder* encoder);
 
+// Remux Functions
+// Copies the audio packets of each input, in order, into a single output container without re-encoding.
+// Each input is cut to its [startFrame, endFrame) range at packet boundaries, so the packets spanning the edges
+// are kept whole. All inputs must share the codec parameters of the first one (codec, rate, channels, extradata).
+// The output callbacks and muxer_options behave as in sf_encoder_init.
+SF_FFMPEG_API SF_Result sf_remux(const SF_RemuxInput* inputs, int32_t inputCount, const char* format_name,
+                                 sf_write_callback onWrite, sf_read_callback onRead, sf_seek_callback onSeek,
+                                 void* pUserData, const char* muxer_options);
+
+// Transcode Functions
+// Decodes the input and re-encodes it into format_name in one native loop, with no round trip through the caller.
+// targetChannels/targetSampleRate select the output layout and rate (0 keeps the input value) and gain is a
+// linear factor applied to every sample (1.0 for unity). The output callbacks and muxer_options behave as in
+// sf_encoder_init. onProgress is optional and called after each block; cancelling returns
+// SF_RESULT_TRANSCODE_CANCELLED with the output finalised up to that point.
+SF_FFMPEG_API SF_Result sf_transcode(sf_read_callback onRead, sf_seek_callback onSeek, void* pInputUserData,
+                                     const char* format_name, sf_write_callback onWrite,
+                                     sf_read_callback onOutputRead, sf_seek_callback onOutputSeek,
+                                     void* pOutputUserData, uint32_t targetChannels, uint32_t targetSampleRate,
+                                     float gain, const char* muxer_options,
+                                     sf_progress_callback onProgress, void* pProgressUserData);
+
+// Runs every job on a pool of workerCount threads (0 for one per CPU core), the calling thread included,
+// and returns when all have finished. Each worker keeps its decoder and encoder handles and its block buffer from job
+// to job, so memory is bounded by the worker count rather than the number of jobs; the FFmpeg contexts behind the
+// handles are opened and released per file.
+// out_results is optional and receives each job's result. Returns SF_RESULT_TRANSCODE_JOB_FAILED if any job failed.
+SF_FFMPEG_API SF_Result sf_transcode_batch(const SF_TranscodeJob* jobs, int32_t jobCount, int32_t workerCount,
+                                           sf_job_progress_callback onProgress, sf_job_complete_callback onComplete,
+                                           void* pUserData, SF_Result* out_results);
+
+// Probe Cache Functions
+// Opens (creating it if needed) a file that remembers, across runs, what probing found in each input: the demuxer,
+// codec parameters, extradata, duration and seek index. Process-wide; opening another file closes the current one.
+// A file written by a different FFmpeg build is started over. path is UTF-8.
+SF_FFMPEG_API SF_Result sf_probe_cache_open(const char* path);
+SF_FFMPEG_API void sf_probe_cache_close(void);
+// Like sf_decoder_init, but consults the probe cache. key identifies the file, e.g. its path, size and modification
+// time; the first 4 KiB of the stream are hashed into it as well (which requires onSeek to rewind). On a hit
+// the recorded demuxer is opened directly and stream probing is skipped; on a miss the input is probed as usual and
+// recorded. Without an open cache, a key or onSeek this is plain sf_decoder_init.
+SF_FFMPEG_API SF_Result sf_decoder_init_probe_cached(SF_Decoder* decoder, const char* key, sf_read_callback onRead,
+                                                     sf_seek_callback onSeek, void* pUserData, SFSampleFormat target_format,
+                                                     SFSampleFormat* out_native_format, uint32_t* out_channels,
+                                                     uint32_t* out_samplerate);
+
 // Helper Functions
 SF_FFMPEG_API const char* sf_result_to_string(SF_Result result);
 
@@ -0,0 +1,184 @@
+// Command-line front end for sf_transcode_batch, for batch conversion and standalone benchmarking.
+//
+// Usage: soundflow-transcode -f <format> [options] <input>...
+//   -f <format>   Output format, e.g. mp3, flac, opus.
+//   -o <dir>      Output directory (default: current directory).
+//   -e <ext>      Output file extension (default: the format name).
+//   -j <workers>  Worker threads (default: one per CPU core).
+//   -r <rate>     Output sample rate (default: keep).
+//   -c <channels> Output channel count (default: keep).
+//   -g <dB>       Gain in decibels (default: 0).
+//   -m <options>  Muxer options, e.g. movflags=+faststart.
+
+#include "soundflow-ffmpeg.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <shellapi.h>
+#define PATH_SEPARATOR '\\'
+#else
+#include <pthread.h>
+#include <time.h>
+#define PATH_SEPARATOR '/'
+#endif
+
+// Completion lines come from every worker thread; each is printed whole under this lock.
+#ifdef _WIN32
+static SRWLOCK g_output_lock = SRWLOCK_INIT;
+static void output_lock(void) { AcquireSRWLockExclusive(&g_output_lock); }
+static void output_unlock(void) { ReleaseSRWLockExclusive(&g_output_lock); }
+#else
+static pthread_mutex_t g_output_lock = PTHREAD_MUTEX_INITIALIZER;
+static void output_lock(void) { pthread_mutex_lock(&g_output_lock); }
+static void output_unlock(void) { pthread_mutex_unlock(&g_output_lock); }
+#endif
+
+static double now_seconds(void) {
+#ifdef _WIN32
+    return (double)GetTickCount64() / 1000.0;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+static void print_usage(void) {
+    fprintf(stderr,
+            "Usage: soundflow-transcode -f <format> [-o dir] [-e ext] [-j workers] [-r rate] [-c channels]\n"
+            "                           [-g gain_db] [-m muxer_options] <input>...\n");
+}
+
+// Builds "<dir>/<input name without extension>.<ext>".
+static char* make_output_path(const char* dir, const char* input, const char* ext) {
+    const char* name = input;
+    for (const char* p = input; *p; p++) {
+        if (*p == '/' || *p == '\\') name = p + 1;
+    }
+    const char* dot = strrchr(name, '.');
+    size_t name_length = dot && dot != name ? (size_t)(dot - name) : strlen(name);
+
+    size_t size = strlen(dir) + 1 + name_length + 1 + strlen(ext) + 1;
+    char* path = (char*)malloc(size);
+    if (!path) return NULL;
+    snprintf(path, size, "%s%c%.*s.%s", dir, PATH_SEPARATOR, (int)name_length, name, ext);
+    return path;
+}
+
+static void on_complete(void* pUserData, int32_t jobIndex, SF_Result result) {
+    const SF_TranscodeJob* jobs = (const SF_TranscodeJob*)pUserData;
+    output_lock();
+    if (result == SF_RESULT_SUCCESS) {
+        printf("ok    %s -> %s\n", jobs[jobIndex].inputPath, jobs[jobIndex].outputPath);
+    } else {
+        printf("FAIL  %s: %s\n", jobs[jobIndex].inputPath, sf_result_to_string(result));
+    }
+    fflush(stdout);
+    output_unlock();
+}
+
+#ifdef _WIN32
+// The narrow argv is in the ANSI code page, but the library takes UTF-8 paths, so the arguments are rebuilt
+// from the wide command line. Returns NULL on failure; the result is freed with free_utf8_argv.
+static char** make_utf8_argv(int* argc) {
+    wchar_t** wargv = CommandLineToArgvW(GetCommandLineW(), argc);
+    if (!wargv) return NULL;
+    char** argv = (char**)calloc((size_t)*argc + 1, sizeof(char*));
+    for (int i = 0; argv && i < *argc; i++) {
+        int size = WideCharToMultiByte(CP_UTF8, 0, wargv[i], -1, NULL, 0, NULL, NULL);
+        argv[i] = size > 0 ? (char*)malloc((size_t)size) : NULL;
+        if (!argv[i]) {
+            while (i > 0) free(argv[--i]);
+            free(argv);
+            argv = NULL;
+            break;
+        }
+        WideCharToMultiByte(CP_UTF8, 0, wargv[i], -1, argv[i], size, NULL, NULL);
+    }
+    LocalFree(wargv);
+    return argv;
+}
+
+static void free_utf8_argv(int argc, char** argv) {
+    for (int i = 0; i < argc; i++) free(argv[i]);
+    free(argv);
+}
+#endif
+
+static int run(int argc, char** argv) {
+    const char* format = NULL;
+    const char* dir = ".";
+    const char* ext = NULL;
+    const char* muxer_options = NULL;
+    int workers = 0;
+    uint32_t rate = 0, channels = 0;
+    float gain = 1.0f;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (i + 1 >= argc) { print_usage(); return 2; }
+        const char* value = argv[++i];
+        switch (argv[i - 1][1]) {
+            case 'f': format = value; break;
+            case 'o': dir = value; break;
+            case 'e': ext = value; break;
+            case 'j': workers = atoi(value); break;
+            case 'r': rate = (uint32_t)strtoul(value, NULL, 10); break;
+            case 'c': channels = (uint32_t)strtoul(value, NULL, 10); break;
+            case 'g': gain = powf(10.0f, (float)atof(value) / 20.0f); break;
+            case 'm': muxer_options = value; break;
+            default: print_usage(); return 2;
+        }
+    }
+
+    int job_count = argc - i;
+    if (!format || job_count <= 0) { print_usage(); return 2; }
+    if (!ext) ext = format;
+
+    SF_TranscodeJob* jobs = (SF_TranscodeJob*)calloc(job_count, sizeof(SF_TranscodeJob));
+    SF_Result* results = (SF_Result*)calloc(job_count, sizeof(SF_Result));
+    if (!jobs || !results) { fprintf(stderr, "Out of memory\n"); return 1; }
+
+    for (int j = 0; j < job_count; j++) {
+        jobs[j].inputPath = argv[i + j];
+        jobs[j].outputPath = make_output_path(dir, argv[i + j], ext);
+        jobs[j].formatName = format;
+        jobs[j].targetChannels = channels;
+        jobs[j].targetSampleRate = rate;
+        jobs[j].gain = gain;
+        jobs[j].muxerOptions = muxer_options;
+        if (!jobs[j].outputPath) { fprintf(stderr, "Out of memory\n"); return 1; }
+    }
+
+    double start = now_seconds();
+    SF_Result result = sf_transcode_batch(jobs, job_count, workers, NULL, on_complete, jobs, results);
+    double elapsed = now_seconds() - start;
+
+    int failed = 0;
+    for (int j = 0; j < job_count; j++) {
+        if (results[j] != SF_RESULT_SUCCESS) failed++;
+    }
+    printf("%d job(s), %d failed, %.2f s, %.2f jobs/s\n", job_count, failed, elapsed, elapsed > 0 ? job_count / elapsed : 0.0);
+
+    for (int j = 0; j < job_count; j++) free((void*)jobs[j].outputPath);
+    free(jobs);
+    free(results);
+    return result == SF_RESULT_SUCCESS ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    argv = make_utf8_argv(&argc);
+    if (!argv) { fprintf(stderr, "Failed to read the command line\n"); return 1; }
+    int code = run(argc, argv);
+    free_utf8_argv(argc, argv);
+    return code;
+#else
+    return run(argc, argv);
+#endif
+}
@@ -0,0 +1,133 @@
+// Probe cache persistence: a cache populated in one session must be reused, not started over, in the next.
+//
+// Usage: probe-cache-test <scratch directory>
+
+#include "../soundflow-ffmpeg.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SAMPLE_RATE 8000
+#define FRAME_COUNT 8000
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            g_failures++; \
+        } \
+    } while (0)
+
+static void put_u16(unsigned char* p, unsigned int v) { p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8); }
+static void put_u32(unsigned char* p, unsigned long v) { put_u16(p, (unsigned int)(v & 0xFFFF)); put_u16(p + 2, (unsigned int)(v >> 16)); }
+
+// Writes one second of a 16-bit mono ramp as a WAV file.
+static int write_wav(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return 0;
+
+    unsigned char header[44];
+    const unsigned long data_size = FRAME_COUNT * 2;
+    memcpy(header, "RIFF", 4);
+    put_u32(header + 4, 36 + data_size);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_u32(header + 16, 16);
+    put_u16(header + 20, 1);                // PCM
+    put_u16(header + 22, 1);                // Mono
+    put_u32(header + 24, SAMPLE_RATE);
+    put_u32(header + 28, SAMPLE_RATE * 2);
+    put_u16(header + 32, 2);
+    put_u16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    put_u32(header + 40, data_size);
+    int ok = fwrite(header, sizeof(header), 1, file) == 1;
+
+    for (int i = 0; ok && i < FRAME_COUNT; i++) {
+        unsigned char sample[2];
+        put_u16(sample, (unsigned int)(((i * 64) & 0xFFFF)));
+        ok = fwrite(sample, sizeof(sample), 1, file) == 1;
+    }
+    return fclose(file) == 0 && ok;
+}
+
+static long file_size(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+    long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    fclose(file);
+    return size;
+}
+
+static size_t on_read(void* pUserData, void* pBuffer, size_t bytesToRead) {
+    return fread(pBuffer, 1, bytesToRead, (FILE*)pUserData);
+}
+
+static int64_t on_seek(void* pUserData, int64_t offset, int whence) {
+    FILE* file = (FILE*)pUserData;
+    if (fseek(file, (long)offset, whence) != 0) return -1;
+    return ftell(file);
+}
+
+// Opens the input through the probe cache under key and checks the format it reports.
+static void open_cached(const char* input, const char* key) {
+    FILE* file = fopen(input, "rb");
+    CHECK(file != NULL);
+    if (!file) return;
+
+    SF_Decoder* decoder = sf_decoder_create();
+    SFSampleFormat format = SF_SAMPLE_FORMAT_UNKNOWN;
+    uint32_t channels = 0, sample_rate = 0;
+    SF_Result result = sf_decoder_init_probe_cached(decoder, key, on_read, on_seek, file, SF_SAMPLE_FORMAT_F32,
+                                                    &format, &channels, &sample_rate);
+    CHECK(result == SF_RESULT_SUCCESS);
+    CHECK(channels == 1);
+    CHECK(sample_rate == SAMPLE_RATE);
+    sf_decoder_free(decoder);
+    fclose(file);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: probe-cache-test <scratch directory>\n");
+        return 2;
+    }
+
+    char input[1024], cache[1024];
+    snprintf(input, sizeof(input), "%s/probe-cache-test.wav", argv[1]);
+    snprintf(cache, sizeof(cache), "%s/probe-cache-test.sfpc", argv[1]);
+    remove(cache);
+    if (!write_wav(input)) {
+        fprintf(stderr, "Failed to write %s\n", input);
+        return 1;
+    }
+
+    // First session: a new file gets its header, then a record per probed input.
+    CHECK(sf_probe_cache_open(cache) == SF_RESULT_SUCCESS);
+    const long empty_size = file_size(cache);
+    CHECK(empty_size > 0);
+    open_cached(input, "a");
+    const long populated_size = file_size(cache);
+    CHECK(populated_size > empty_size);
+    sf_probe_cache_close();
+
+    // Second session: the records survive the reopen, and a known key is a hit that appends nothing.
+    CHECK(sf_probe_cache_open(cache) == SF_RESULT_SUCCESS);
+    CHECK(file_size(cache) == populated_size);
+    open_cached(input, "a");
+    CHECK(file_size(cache) == populated_size);
+    open_cached(input, "b");
+    CHECK(file_size(cache) > populated_size);
+    sf_probe_cache_close();
+
+    remove(cache);
+    remove(input);
+    if (g_failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("probe cache test passed\n");
+    return 0;
+}
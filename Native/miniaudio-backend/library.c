@@ -1,11 +1,84 @@
-﻿#define MINIAUDIO_IMPLEMENTATION
+﻿#if defined(__linux__) && !defined(__ANDROID__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // For sched_setaffinity, used to pin device threads.
+#endif
+#define MINIAUDIO_IMPLEMENTATION
 
 #include "library.h"
+#include <stdatomic.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#elif !defined(_WIN32)
+#include <errno.h>
+#include <semaphore.h>
+#endif
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sched.h>
+#endif
+
 // Helper macro for memory allocation
 #define sf_create(t) (t*)ma_malloc(sizeof(t), NULL)
 
+// MSVC's C mode does not accept _Thread_local.
+#if defined(_MSC_VER)
+#define SF_THREAD_LOCAL __declspec(thread)
+#else
+#define SF_THREAD_LOCAL _Thread_local
+#endif
+
+// A callback arriving this many periods after the previous one means the backend waited on us and likely glitched.
+#define SF_PERF_LATE_CALLBACK_PERIODS 2
+
+#ifdef _WIN32
+typedef HANDLE sf_offline_thread;
+#else
+typedef pthread_t sf_offline_thread;
+#endif
+
+// An offline device: a null-backend device that is never started, whose callback is pumped by the facade.
+struct sf_offline_device {
+    ma_context context;                 // Private null-backend context the device is initialised on.
+    ma_encoder encoder;
+    ma_bool32 hasEncoder;
+    void* pOutput;                      // One period of playback output, NULL for capture devices.
+    void* pInput;                       // One period of silent capture input, NULL for playback devices.
+    ma_uint32 periodInFrames;
+    atomic_int running;
+    sf_offline_thread thread;
+    ma_bool32 threadStarted;
+};
+
+#ifdef _WIN32
+typedef HANDLE sf_autotune_thread;
+#else
+typedef pthread_t sf_autotune_thread;
+#endif
+
+// The period auto-tuner of a device. Keeps what is needed to reinitialise the device in place.
+struct sf_autotuner {
+    ma_context* pContext;
+    ma_device_config config;            // Copy of the init config, with device ids and names pointing at the copies below.
+    ma_device_id playbackId;
+    ma_device_id captureId;
+    char* pPulseStreamNamePlayback;
+    char* pPulseStreamNameCapture;
+    ma_mutex lock;                      // Serialises reinitialisation with start, stop and status reads.
+    ma_bool32 started;                  // Whether the owner has the device started.
+    atomic_int stopRequested;
+    sf_autotune_thread thread;
+    ma_bool32 threadStarted;
+    ma_uint64 lastGlitches;
+    ma_uint64 lastCallbacks;
+    struct sf_AutoTuneStatus status;
+};
+
 // Helper function to safely copy a UTF-8 string
 static void sf_safe_strcpy(char* dest, const char* src) {
     if (dest == NULL) {
@@ -21,6 +94,20 @@ static void sf_safe_strcpy(char* dest, const char* src) {
     dest[dest_size - 1] = '\0';
 }
 
+// Copies a string into memory from ma_malloc. Returns NULL for a NULL string or when out of memory.
+static char* sf_copy_string(const char* src) {
+    if (src == NULL) {
+        return NULL;
+    }
+
+    const size_t length = strlen(src);
+    char* dest = (char*)ma_malloc(length + 1, NULL);
+    if (dest != NULL) {
+        memcpy(dest, src, length + 1);
+    }
+    return dest;
+}
+
 // Helper function to create device info structure - eliminates code duplication
 static struct sf_device_info sf_create_device_info(const ma_device_info* pBasicInfo, const ma_device_info* pFullInfo) {
     struct sf_device_info deviceInfo;
@@ -59,6 +146,723 @@ static struct sf_device_info sf_create_device_info(const ma_device_info* pBasicI
     return deviceInfo;
 }
 
+// Monotonic clock used for callback timestamps, in nanoseconds.
+static ma_uint64 sf_time_ns(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (ma_uint64)(counter.QuadPart / frequency.QuadPart) * 1000000000ULL +
+           (ma_uint64)(counter.QuadPart % frequency.QuadPart) * 1000000000ULL / (ma_uint64)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ma_uint64)ts.tv_sec * 1000000000ULL + (ma_uint64)ts.tv_nsec;
+#endif
+}
+
+// The affinity mask last applied to the calling thread, so each thread is pinned once rather than on every callback.
+static SF_THREAD_LOCAL ma_uint64 g_thread_affinity_mask = 0;
+
+// Restricts the calling thread to the CPUs set in mask, once per thread and mask. A no-op where threads cannot be
+// pinned to CPUs (macOS) and on Android, where callbacks run on AAudio and OpenSL ES threads owned by the system.
+static void sf_set_current_thread_affinity(const ma_uint64 mask) {
+    if (g_thread_affinity_mask == mask) {
+        return;
+    }
+    g_thread_affinity_mask = mask;
+#if defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)mask);
+#elif defined(__linux__) && !defined(__ANDROID__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+        if (mask & (1ULL << cpu)) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)mask;
+#endif
+}
+
+#ifdef _WIN32
+static void sf_sleep_ns(const ma_uint64 ns) { Sleep((DWORD)(ns / 1000000)); }
+#else
+static void sf_sleep_ns(const ma_uint64 ns) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000);
+    ts.tv_nsec = (long)(ns % 1000000000);
+    nanosleep(&ts, NULL);
+}
+#endif
+
+// A counting wake-up the device callback can post without taking a lock. ma_event is a mutex and condition variable
+// on POSIX, so signalling it from the callback could block on the render thread sleeping in ma_event_wait.
+#if defined(_WIN32)
+typedef HANDLE sf_semaphore;
+#elif defined(__APPLE__)
+typedef dispatch_semaphore_t sf_semaphore; // macOS does not implement unnamed POSIX semaphores.
+#else
+typedef sem_t sf_semaphore;
+#endif
+
+static ma_result sf_semaphore_init(sf_semaphore* pSemaphore) {
+#if defined(_WIN32)
+    *pSemaphore = CreateEventA(NULL, FALSE, FALSE, NULL);
+    return *pSemaphore != NULL ? MA_SUCCESS : MA_ERROR;
+#elif defined(__APPLE__)
+    *pSemaphore = dispatch_semaphore_create(0);
+    return *pSemaphore != NULL ? MA_SUCCESS : MA_ERROR;
+#else
+    return sem_init(pSemaphore, 0, 0) == 0 ? MA_SUCCESS : MA_ERROR;
+#endif
+}
+
+static void sf_semaphore_uninit(sf_semaphore* pSemaphore) {
+#if defined(_WIN32)
+    CloseHandle(*pSemaphore);
+#elif defined(__APPLE__)
+    dispatch_release(*pSemaphore);
+#else
+    sem_destroy(pSemaphore);
+#endif
+}
+
+static void sf_semaphore_post(sf_semaphore* pSemaphore) {
+#if defined(_WIN32)
+    SetEvent(*pSemaphore);
+#elif defined(__APPLE__)
+    dispatch_semaphore_signal(*pSemaphore);
+#else
+    sem_post(pSemaphore);
+#endif
+}
+
+static ma_result sf_semaphore_wait(sf_semaphore* pSemaphore) {
+#if defined(_WIN32)
+    return WaitForSingleObject(*pSemaphore, INFINITE) == WAIT_OBJECT_0 ? MA_SUCCESS : MA_ERROR;
+#elif defined(__APPLE__)
+    dispatch_semaphore_wait(*pSemaphore, DISPATCH_TIME_FOREVER);
+    return MA_SUCCESS;
+#else
+    while (sem_wait(pSemaphore) != 0) {
+        if (errno != EINTR) {
+            return MA_ERROR;
+        }
+    }
+    return MA_SUCCESS;
+#endif
+}
+
+// Per-device state owned by the facade. It is installed as the device's user data, so the data callback reaches
+// it directly and the facade can run its own modes (such as render-ahead) in front of the managed callback.
+struct sf_device_state {
+    ma_device_data_proc onData;         // The plain miniaudio-style data callback, used when no table is set.
+    struct sf_DeviceCallbacks callbacks;
+    void* pCallbackUserData;            // Passed back to every function in the table.
+    atomic_ullong framePosition;        // Frames processed by the callback so far. Written only by the device thread.
+    ma_uint32 renderAheadPeriods;       // Ring depth requested in the config; 0 disables render-ahead.
+
+    // Render-ahead ring. Single producer (the render thread), single consumer (the device callback).
+    ma_bool32 ringEnabled;
+    ma_pcm_rb ring;
+    sf_semaphore ringWake;              // Posted by the callback each time it drains a period.
+    atomic_int ringWakePending;         // Set while a post is outstanding, so the count stays at most one.
+    ma_uint32 ringPeriodInFrames;
+    atomic_ullong underrunCount;
+    atomic_ullong underrunFrames;
+
+    // Callback instrumentation. Accumulated by the device thread and published to readers through a seqlock.
+    struct sf_PerfStats perf;
+    ma_uint64 perfLastStartNs;
+    ma_uint64 perfTotalDurationNs;
+    ma_uint64 perfTotalBudgetNs;
+    ma_uint64 perfTotalJitterNs;
+    struct sf_PerfStats perfSnapshot;
+    ma_uint64 clockFramePosition;       // Frame position and start time of the last callback, published with perfSnapshot.
+    ma_uint64 clockTimestampNs;
+    ma_uint32 clockFrameCount;
+    ma_uint32 layoutSampleRate;         // Period layout of the device, published with perfSnapshot while it is stopped.
+    ma_uint32 layoutInternalSampleRate;
+    ma_uint32 layoutPeriodSizeInFrames;
+    ma_uint32 layoutPeriods;
+    atomic_uint perfSequence;           // Odd while perfSnapshot, the clock or the layout fields are being written.
+    atomic_int perfResetRequested;
+
+    // Offline rendering, requested through sf_DeviceConfig.offline. pOffline is created by sf_device_init.
+    ma_bool32 offline;
+    char* pOfflineOutputPath;
+    struct sf_offline_device* pOffline;
+
+    // Backend data of a device opened on the virtual backend, owned by that backend.
+    struct sf_virtual_stream* pVirtual;
+
+    // CPU affinity inherited from a context created by sf_context_init, applied from the callback to whichever
+    // thread runs it, since backends own their device threads.
+    ma_uint64 cpuAffinityMask;
+
+    // Period auto-tuning, requested through sf_DeviceConfig.autoTune. pTuner is created by sf_device_init.
+    ma_bool32 autoTuneEnabled;
+    struct sf_AutoTuneConfig autoTune;
+    struct sf_autotuner* pTuner;
+};
+
+static void sf_device_state_free(struct sf_device_state* pState) {
+    if (pState == NULL) {
+        return;
+    }
+
+    if (pState->ringEnabled) {
+        sf_semaphore_uninit(&pState->ringWake);
+        ma_pcm_rb_uninit(&pState->ring);
+    }
+    ma_free(pState->pOfflineOutputPath, NULL);
+    ma_free(pState, NULL);
+}
+
+// Devices from sf_allocate_device carry a slot for their facade state after the ma_device itself. Entry points
+// called from other threads find the state there rather than through pDevice->pUserData, which the auto-tuner's
+// in-place reinitialisation briefly zeroes.
+struct sf_device_block {
+    ma_device device;
+    struct sf_device_state* pState;
+};
+
+static struct sf_device_state* sf_device_state_of(const ma_device* pDevice) {
+    return pDevice != NULL ? ((const struct sf_device_block*)pDevice)->pState : NULL;
+}
+
+static void sf_device_set_state(ma_device* pDevice, struct sf_device_state* pState) {
+    ((struct sf_device_block*)pDevice)->pState = pState;
+}
+
+// Wakes the render thread without blocking. Safe to call from the device callback.
+static void sf_device_ring_signal(struct sf_device_state* pState) {
+    if (!atomic_exchange_explicit(&pState->ringWakePending, 1, memory_order_acq_rel)) {
+        sf_semaphore_post(&pState->ringWake);
+    }
+}
+
+// Copies the next frames out of the render-ahead ring, padding with silence and counting an underrun if the
+// render thread has fallen behind.
+static void sf_device_ring_read(struct sf_device_state* pState, const ma_device* pDevice, void* pOutput, const ma_uint32 frameCount) {
+    const ma_format format = pDevice->playback.format;
+    const ma_uint32 channels = pDevice->playback.channels;
+    ma_uint32 framesRead = 0;
+
+    while (framesRead < frameCount) {
+        ma_uint32 framesToRead = frameCount - framesRead;
+        void* pReadBuffer;
+        if (ma_pcm_rb_acquire_read(&pState->ring, &framesToRead, &pReadBuffer) != MA_SUCCESS || framesToRead == 0) {
+            break;
+        }
+
+        ma_copy_pcm_frames(ma_offset_pcm_frames_ptr(pOutput, framesRead, format, channels), pReadBuffer, framesToRead, format, channels);
+        ma_pcm_rb_commit_read(&pState->ring, framesToRead);
+        framesRead += framesToRead;
+    }
+
+    if (framesRead < frameCount) {
+        ma_silence_pcm_frames(ma_offset_pcm_frames_ptr(pOutput, framesRead, format, channels), frameCount - framesRead, format, channels);
+        atomic_fetch_add_explicit(&pState->underrunCount, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&pState->underrunFrames, frameCount - framesRead, memory_order_relaxed);
+    }
+
+    sf_device_ring_signal(pState);
+}
+
+// Folds one callback into the device's performance counters and publishes a new snapshot.
+static void sf_perf_record(struct sf_device_state* pState, const ma_device* pDevice, const ma_uint32 frameCount,
+                           const ma_uint64 framePosition, const ma_uint64 startNs, const ma_uint64 endNs) {
+    struct sf_PerfStats* pPerf = &pState->perf;
+
+    if (atomic_exchange_explicit(&pState->perfResetRequested, 0, memory_order_acquire)) {
+        memset(pPerf, 0, sizeof(*pPerf));
+        pState->perfLastStartNs = 0;
+        pState->perfTotalDurationNs = 0;
+        pState->perfTotalBudgetNs = 0;
+        pState->perfTotalJitterNs = 0;
+    }
+
+    const ma_uint64 durationNs = endNs - startNs;
+    const ma_uint64 budgetNs = pDevice->sampleRate == 0 ? 0 : (ma_uint64)frameCount * 1000000000ULL / pDevice->sampleRate;
+
+    pPerf->callbackCount++;
+    pPerf->budgetNs = budgetNs;
+    pPerf->lastDurationNs = durationNs;
+    if (pPerf->callbackCount == 1 || durationNs < pPerf->minDurationNs) {
+        pPerf->minDurationNs = durationNs;
+    }
+    if (durationNs > pPerf->maxDurationNs) {
+        pPerf->maxDurationNs = durationNs;
+    }
+    pState->perfTotalDurationNs += durationNs;
+    pState->perfTotalBudgetNs += budgetNs;
+    pPerf->avgDurationNs = pState->perfTotalDurationNs / pPerf->callbackCount;
+
+    // Jitter is how far the spacing between callbacks strays from the period they cover.
+    if (pState->perfLastStartNs != 0) {
+        const ma_uint64 intervalNs = startNs - pState->perfLastStartNs;
+        const ma_uint64 jitterNs = intervalNs > budgetNs ? intervalNs - budgetNs : budgetNs - intervalNs;
+        pPerf->lastIntervalNs = intervalNs;
+        pState->perfTotalJitterNs += jitterNs;
+        pPerf->avgJitterNs = pState->perfTotalJitterNs / (pPerf->callbackCount - 1);
+        if (jitterNs > pPerf->maxJitterNs) {
+            pPerf->maxJitterNs = jitterNs;
+        }
+        if (budgetNs > 0 && intervalNs > budgetNs * SF_PERF_LATE_CALLBACK_PERIODS) {
+            pPerf->lateCallbackCount++;
+        }
+    }
+    pState->perfLastStartNs = startNs;
+
+    if (budgetNs > 0) {
+        const float load = (float)((double)durationNs / (double)budgetNs);
+        pPerf->dspLoad = pPerf->callbackCount == 1 ? load : pPerf->dspLoad + (load - pPerf->dspLoad) * 0.1f;
+        if (load > pPerf->peakDspLoad) {
+            pPerf->peakDspLoad = load;
+        }
+        pPerf->averageDspLoad = (float)((double)pState->perfTotalDurationNs / (double)pState->perfTotalBudgetNs);
+        if (durationNs > budgetNs) {
+            pPerf->overrunCount++;
+        }
+
+        ma_uint64 bin = durationNs * 10 / budgetNs;
+        if (bin >= SF_PERF_HISTOGRAM_BINS) {
+            bin = SF_PERF_HISTOGRAM_BINS - 1;
+        }
+        pPerf->histogram[bin]++;
+    }
+
+    pPerf->underrunCount = atomic_load_explicit(&pState->underrunCount, memory_order_relaxed);
+
+    // Publish. Readers retry while the sequence is odd or changes under them.
+    const unsigned int sequence = atomic_load_explicit(&pState->perfSequence, memory_order_relaxed);
+    atomic_store_explicit(&pState->perfSequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    pState->perfSnapshot = *pPerf;
+    pState->clockFramePosition = framePosition;
+    pState->clockTimestampNs = startNs;
+    pState->clockFrameCount = frameCount;
+    atomic_store_explicit(&pState->perfSequence, sequence + 2, memory_order_release);
+}
+
+// Copies the latest published performance snapshot, retrying while the device thread is writing it.
+static void sf_perf_read(struct sf_device_state* pState, struct sf_PerfStats* pStats) {
+    unsigned int before, after;
+    do {
+        before = atomic_load_explicit(&pState->perfSequence, memory_order_acquire);
+        *pStats = pState->perfSnapshot;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&pState->perfSequence, memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+}
+
+// Publishes the period layout of a freshly initialised device. Only while it is stopped, so the callback, the other
+// writer of the sequence, cannot run.
+static void sf_device_publish_layout(struct sf_device_state* pState, const ma_device* pDevice) {
+    // Playback and duplex devices are timed by their output side.
+    const ma_bool32 isCapture = pDevice->type == ma_device_type_capture || pDevice->type == ma_device_type_loopback;
+
+    const unsigned int sequence = atomic_load_explicit(&pState->perfSequence, memory_order_relaxed);
+    atomic_store_explicit(&pState->perfSequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    pState->layoutSampleRate = pDevice->sampleRate;
+    pState->layoutInternalSampleRate = isCapture ? pDevice->capture.internalSampleRate : pDevice->playback.internalSampleRate;
+    pState->layoutPeriodSizeInFrames = isCapture ? pDevice->capture.internalPeriodSizeInFrames : pDevice->playback.internalPeriodSizeInFrames;
+    pState->layoutPeriods = isCapture ? pDevice->capture.internalPeriods : pDevice->playback.internalPeriods;
+    atomic_store_explicit(&pState->perfSequence, sequence + 2, memory_order_release);
+}
+
+// The data callback installed on every device created through sf_allocate_device_config.
+static void sf_device_data_callback(ma_device* pDevice, void* pOutput, const void* pInput, const ma_uint32 frameCount) {
+    struct sf_device_state* pState = (struct sf_device_state*)pDevice->pUserData;
+    if (pState == NULL) {
+        return;
+    }
+
+    const ma_uint64 startNs = sf_time_ns();
+    const ma_uint64 framePosition = atomic_load_explicit(&pState->framePosition, memory_order_relaxed);
+
+    if (pState->cpuAffinityMask != 0) {
+        sf_set_current_thread_affinity(pState->cpuAffinityMask);
+    }
+
+    if (pState->ringEnabled) {
+        sf_device_ring_read(pState, pDevice, pOutput, frameCount);
+    } else if (pState->callbacks.onData != NULL) {
+        struct sf_CallbackInfo info;
+        info.framePosition = framePosition;
+        info.timestampNs = startNs;
+        pState->callbacks.onData(pState->pCallbackUserData, pOutput, pInput, frameCount, &info);
+    } else if (pState->onData != NULL) {
+        pState->onData(pDevice, pOutput, pInput, frameCount);
+    }
+
+    atomic_store_explicit(&pState->framePosition, framePosition + frameCount, memory_order_relaxed);
+    sf_perf_record(pState, pDevice, frameCount, framePosition, startNs, sf_time_ns());
+}
+
+static void sf_device_cache_invalidate_context(const ma_context* pContext);
+
+// The notification callback installed on every device created through sf_allocate_device_config.
+static void sf_device_notification_callback(const ma_device_notification* pNotification) {
+    // A reroute means the default device changed, so any cached device list is stale.
+    if (pNotification->type == ma_device_notification_type_rerouted) {
+        sf_device_cache_invalidate_context(pNotification->pDevice->pContext);
+    }
+
+    struct sf_device_state* pState = (struct sf_device_state*)pNotification->pDevice->pUserData;
+    if (pState != NULL && pState->callbacks.onNotification != NULL) {
+        pState->callbacks.onNotification(pState->pCallbackUserData, pNotification->type);
+    }
+}
+
+// Sizes the render-ahead ring from the period the device actually negotiated.
+static ma_result sf_device_ring_init(struct sf_device_state* pState, const ma_device* pDevice) {
+    ma_uint32 periodInFrames = pDevice->playback.internalPeriodSizeInFrames;
+    if (pDevice->playback.internalSampleRate != 0 && pDevice->playback.internalSampleRate != pDevice->sampleRate) {
+        periodInFrames = (ma_uint32)(((ma_uint64)periodInFrames * pDevice->sampleRate) / pDevice->playback.internalSampleRate);
+    }
+    if (periodInFrames == 0) {
+        return MA_INVALID_OPERATION;
+    }
+
+    ma_result result = ma_pcm_rb_init(pDevice->playback.format, pDevice->playback.channels,
+                                      periodInFrames * pState->renderAheadPeriods, NULL, NULL, &pState->ring);
+    if (result != MA_SUCCESS) {
+        return result;
+    }
+
+    atomic_init(&pState->ringWakePending, 0);
+    result = sf_semaphore_init(&pState->ringWake);
+    if (result != MA_SUCCESS) {
+        ma_pcm_rb_uninit(&pState->ring);
+        return result;
+    }
+
+    pState->ringPeriodInFrames = periodInFrames;
+    pState->ringEnabled = MA_TRUE;
+    return MA_SUCCESS;
+}
+
+// Releases what sf_offline_init created, except the device itself.
+static void sf_offline_free(struct sf_offline_device* pOffline) {
+    if (pOffline->hasEncoder) {
+        ma_encoder_uninit(&pOffline->encoder);
+    }
+    ma_free(pOffline->pOutput, NULL);
+    ma_free(pOffline->pInput, NULL);
+    ma_context_uninit(&pOffline->context);
+    ma_free(pOffline, NULL);
+}
+
+// Initialises an offline device on its own null-backend context. The null backend is only used for its
+// bookkeeping; the device is never started, so nothing paces the callback.
+static ma_result sf_offline_init(struct sf_device_state* pState, const ma_device_config* pConfig, ma_device* pDevice) {
+    struct sf_offline_device* pOffline = sf_create(struct sf_offline_device);
+    if (pOffline == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+    memset(pOffline, 0, sizeof(*pOffline));
+
+    const ma_backend backend = ma_backend_null;
+    const ma_context_config contextConfig = ma_context_config_init();
+    ma_result result = ma_context_init(&backend, 1, &contextConfig, &pOffline->context);
+    if (result != MA_SUCCESS) {
+        ma_free(pOffline, NULL);
+        return result;
+    }
+
+    // Device ids belong to the caller's context and mean nothing to the null backend.
+    ma_device_config config = *pConfig;
+    config.playback.pDeviceID = NULL;
+    config.capture.pDeviceID = NULL;
+
+    result = ma_device_init(&pOffline->context, &config, pDevice);
+    if (result != MA_SUCCESS) {
+        ma_context_uninit(&pOffline->context);
+        ma_free(pOffline, NULL);
+        return result;
+    }
+
+    // The null backend runs at the client rate, so its period is already in callback frames.
+    const ma_bool32 hasPlayback = pDevice->type != ma_device_type_capture && pDevice->type != ma_device_type_loopback;
+    const ma_bool32 hasCapture = pDevice->type != ma_device_type_playback;
+    pOffline->periodInFrames = hasPlayback ? pDevice->playback.internalPeriodSizeInFrames : pDevice->capture.internalPeriodSizeInFrames;
+    if (pOffline->periodInFrames == 0) {
+        pOffline->periodInFrames = pDevice->sampleRate / 100;
+    }
+
+    if (hasPlayback) {
+        pOffline->pOutput = ma_malloc((size_t)pOffline->periodInFrames * ma_get_bytes_per_frame(pDevice->playback.format, pDevice->playback.channels), NULL);
+        result = pOffline->pOutput != NULL ? MA_SUCCESS : MA_OUT_OF_MEMORY;
+    }
+    if (result == MA_SUCCESS && hasCapture) {
+        pOffline->pInput = ma_malloc((size_t)pOffline->periodInFrames * ma_get_bytes_per_frame(pDevice->capture.format, pDevice->capture.channels), NULL);
+        if (pOffline->pInput != NULL) {
+            ma_silence_pcm_frames(pOffline->pInput, pOffline->periodInFrames, pDevice->capture.format, pDevice->capture.channels);
+        } else {
+            result = MA_OUT_OF_MEMORY;
+        }
+    }
+    if (result == MA_SUCCESS && hasPlayback && pState->pOfflineOutputPath != NULL) {
+        const ma_encoder_config encoderConfig = ma_encoder_config_init(ma_encoding_format_wav, pDevice->playback.format,
+                                                                       pDevice->playback.channels, pDevice->sampleRate);
+        result = ma_encoder_init_file(pState->pOfflineOutputPath, &encoderConfig, &pOffline->encoder);
+        pOffline->hasEncoder = result == MA_SUCCESS;
+    }
+
+    if (result != MA_SUCCESS) {
+        ma_device_uninit(pDevice);
+        sf_offline_free(pOffline);
+        return result;
+    }
+
+    atomic_init(&pOffline->running, 0);
+    pState->pOffline = pOffline;
+    return MA_SUCCESS;
+}
+
+// Runs the data callback for up to one period and passes the output to the sink and to pDst, if given.
+static void sf_offline_render_period(ma_device* pDevice, struct sf_offline_device* pOffline, const ma_uint32 frameCount, void* pDst) {
+    if (pOffline->pOutput != NULL) {
+        ma_silence_pcm_frames(pOffline->pOutput, frameCount, pDevice->playback.format, pDevice->playback.channels);
+    }
+
+    sf_device_data_callback(pDevice, pOffline->pOutput, pOffline->pInput, frameCount);
+
+    if (pOffline->pOutput == NULL) {
+        return;
+    }
+    if (pOffline->hasEncoder) {
+        ma_encoder_write_pcm_frames(&pOffline->encoder, pOffline->pOutput, frameCount, NULL);
+    }
+    if (pDst != NULL) {
+        ma_copy_pcm_frames(pDst, pOffline->pOutput, frameCount, pDevice->playback.format, pDevice->playback.channels);
+    }
+}
+
+static void sf_offline_loop(ma_device* pDevice) {
+    struct sf_offline_device* pOffline = ((struct sf_device_state*)pDevice->pUserData)->pOffline;
+    while (atomic_load_explicit(&pOffline->running, memory_order_acquire)) {
+        sf_offline_render_period(pDevice, pOffline, pOffline->periodInFrames, NULL);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI sf_offline_thread_main(LPVOID arg) { sf_offline_loop((ma_device*)arg); return 0; }
+static int sf_offline_thread_start(struct sf_offline_device* pOffline, ma_device* pDevice) {
+    pOffline->thread = CreateThread(NULL, 0, sf_offline_thread_main, pDevice, 0, NULL);
+    return pOffline->thread != NULL ? 0 : -1;
+}
+static void sf_offline_thread_join(sf_offline_thread thread) { WaitForSingleObject(thread, INFINITE); CloseHandle(thread); }
+#else
+static void* sf_offline_thread_main(void* arg) { sf_offline_loop((ma_device*)arg); return NULL; }
+static int sf_offline_thread_start(struct sf_offline_device* pOffline, ma_device* pDevice) { return pthread_create(&pOffline->thread, NULL, sf_offline_thread_main, pDevice); }
+static void sf_offline_thread_join(sf_offline_thread thread) { pthread_join(thread, NULL); }
+#endif
+
+static struct sf_offline_device* sf_device_get_offline(const ma_device* pDevice) {
+    const struct sf_device_state* pState = sf_device_state_of(pDevice);
+    return pState != NULL ? pState->pOffline : NULL;
+}
+
+static void sf_offline_stop(struct sf_offline_device* pOffline) {
+    if (atomic_exchange_explicit(&pOffline->running, 0, memory_order_acq_rel) && pOffline->threadStarted) {
+        sf_offline_thread_join(pOffline->thread);
+        pOffline->threadStarted = MA_FALSE;
+    }
+}
+
+// Records the period count the backend chose, which may differ from the one requested.
+static void sf_autotune_read_periods(struct sf_autotuner* pTuner, const ma_device* pDevice) {
+    const ma_bool32 isCapture = pDevice->type == ma_device_type_capture || pDevice->type == ma_device_type_loopback;
+    pTuner->status.periods = isCapture ? pDevice->capture.internalPeriods : pDevice->playback.internalPeriods;
+}
+
+// Reinitialises the device in place with the tuner's current period, restarting it if the owner had it started.
+// Called with the tuner lock held. The per-device state outlives the device, so counters and callbacks carry over.
+static ma_result sf_autotune_reinit(struct sf_device_state* pState, ma_device* pDevice) {
+    struct sf_autotuner* pTuner = pState->pTuner;
+
+    ma_device_uninit(pDevice);
+    pTuner->config.periodSizeInFrames = pTuner->status.periodSizeInFrames;
+    pTuner->config.periodSizeInMilliseconds = 0;
+
+    ma_result result = ma_device_init(pTuner->pContext, &pTuner->config, pDevice);
+    if (result == MA_SUCCESS) {
+        sf_autotune_read_periods(pTuner, pDevice);
+        sf_device_publish_layout(pState, pDevice);
+    }
+    if (result == MA_SUCCESS && pTuner->started) {
+        // The gap while the device was down is not a late callback.
+        pState->perfLastStartNs = 0;
+        result = ma_device_start(pDevice);
+    }
+
+    pTuner->status.reinitCount++;
+    pTuner->status.lastResult = result;
+    return result;
+}
+
+// Judges the window that just ended and grows the period if it glitched too often.
+static ma_bool32 sf_autotune_evaluate(struct sf_device_state* pState, ma_device* pDevice) {
+    struct sf_autotuner* pTuner = pState->pTuner;
+    const struct sf_AutoTuneConfig* pConfig = &pState->autoTune;
+
+    struct sf_PerfStats stats;
+    sf_perf_read(pState, &stats);
+    const ma_uint64 glitches = stats.overrunCount + stats.underrunCount + stats.lateCallbackCount;
+
+    // A reset of the counters restarts the deltas; a window without callbacks says nothing about the period.
+    const ma_bool32 wasReset = stats.callbackCount < pTuner->lastCallbacks || glitches < pTuner->lastGlitches;
+    const ma_uint64 windowGlitches = wasReset ? 0 : glitches - pTuner->lastGlitches;
+    const ma_bool32 ranThisWindow = !wasReset && stats.callbackCount > pTuner->lastCallbacks;
+    pTuner->lastGlitches = glitches;
+    pTuner->lastCallbacks = stats.callbackCount;
+    if (!ranThisWindow) {
+        return MA_TRUE;
+    }
+
+    if (windowGlitches <= pConfig->maxGlitchesPerWindow) {
+        pTuner->status.stableWindows++;
+        pTuner->status.converged = pTuner->status.stableWindows >= pConfig->stableWindows;
+        return MA_TRUE;
+    }
+
+    pTuner->status.stableWindows = 0;
+    pTuner->status.converged = MA_FALSE;
+    if (pTuner->status.atMaximum) {
+        return MA_TRUE;
+    }
+
+    ma_uint32 periodSizeInFrames = pTuner->status.periodSizeInFrames * 2;
+    if (periodSizeInFrames >= pConfig->maxPeriodSizeInFrames) {
+        periodSizeInFrames = pConfig->maxPeriodSizeInFrames;
+        pTuner->status.atMaximum = MA_TRUE;
+    }
+    pTuner->status.periodSizeInFrames = periodSizeInFrames;
+
+    // Stop tuning if the device cannot come back up; the owner sees lastResult.
+    return sf_autotune_reinit(pState, pDevice) == MA_SUCCESS;
+}
+
+static void sf_autotune_loop(ma_device* pDevice) {
+    struct sf_device_state* pState = (struct sf_device_state*)pDevice->pUserData;
+    struct sf_autotuner* pTuner = pState->pTuner;
+    const ma_uint64 windowNs = (ma_uint64)pState->autoTune.windowMilliseconds * 1000000;
+
+    for (;;) {
+        // Sleep in short steps so uninit does not wait out a whole window.
+        const ma_uint64 deadlineNs = sf_time_ns() + windowNs;
+        ma_uint64 nowNs;
+        while (!atomic_load_explicit(&pTuner->stopRequested, memory_order_acquire) && (nowNs = sf_time_ns()) < deadlineNs) {
+            const ma_uint64 remainingNs = deadlineNs - nowNs;
+            sf_sleep_ns(remainingNs < 10000000 ? remainingNs : 10000000);
+        }
+        if (atomic_load_explicit(&pTuner->stopRequested, memory_order_acquire)) {
+            return;
+        }
+
+        ma_mutex_lock(&pTuner->lock);
+        const ma_bool32 keepTuning = sf_autotune_evaluate(pState, pDevice);
+        ma_mutex_unlock(&pTuner->lock);
+        if (!keepTuning) {
+            return;
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI sf_autotune_thread_main(LPVOID arg) { sf_autotune_loop((ma_device*)arg); return 0; }
+static int sf_autotune_thread_start(struct sf_autotuner* pTuner, ma_device* pDevice) {
+    pTuner->thread = CreateThread(NULL, 0, sf_autotune_thread_main, pDevice, 0, NULL);
+    return pTuner->thread != NULL ? 0 : -1;
+}
+static void sf_autotune_thread_join(sf_autotune_thread thread) { WaitForSingleObject(thread, INFINITE); CloseHandle(thread); }
+#else
+static void* sf_autotune_thread_main(void* arg) { sf_autotune_loop((ma_device*)arg); return NULL; }
+static int sf_autotune_thread_start(struct sf_autotuner* pTuner, ma_device* pDevice) { return pthread_create(&pTuner->thread, NULL, sf_autotune_thread_main, pDevice); }
+static void sf_autotune_thread_join(sf_autotune_thread thread) { pthread_join(thread, NULL); }
+#endif
+
+static void sf_autotune_free(struct sf_autotuner* pTuner) {
+    if (pTuner->threadStarted) {
+        atomic_store_explicit(&pTuner->stopRequested, 1, memory_order_release);
+        sf_autotune_thread_join(pTuner->thread);
+        pTuner->threadStarted = MA_FALSE;
+    }
+    ma_mutex_uninit(&pTuner->lock);
+    ma_free(pTuner->pPulseStreamNamePlayback, NULL);
+    ma_free(pTuner->pPulseStreamNameCapture, NULL);
+    ma_free(pTuner, NULL);
+}
+
+// Initialises the device at the smallest period and starts the tuner thread that grows it.
+static ma_result sf_autotune_init(struct sf_device_state* pState, ma_context* pContext, const ma_device_config* pConfig, ma_device* pDevice) {
+    struct sf_autotuner* pTuner = sf_create(struct sf_autotuner);
+    if (pTuner == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+    memset(pTuner, 0, sizeof(*pTuner));
+
+    ma_result result = ma_mutex_init(&pTuner->lock);
+    if (result != MA_SUCCESS) {
+        ma_free(pTuner, NULL);
+        return result;
+    }
+
+    // The caller's device ids and stream names need not outlive init, but every reinitialisation reuses them.
+    pTuner->pContext = pContext;
+    pTuner->config = *pConfig;
+    if (pConfig->playback.pDeviceID != NULL) {
+        pTuner->playbackId = *pConfig->playback.pDeviceID;
+        pTuner->config.playback.pDeviceID = &pTuner->playbackId;
+    }
+    if (pConfig->capture.pDeviceID != NULL) {
+        pTuner->captureId = *pConfig->capture.pDeviceID;
+        pTuner->config.capture.pDeviceID = &pTuner->captureId;
+    }
+    pTuner->pPulseStreamNamePlayback = sf_copy_string(pConfig->pulse.pStreamNamePlayback);
+    pTuner->pPulseStreamNameCapture = sf_copy_string(pConfig->pulse.pStreamNameCapture);
+    pTuner->config.pulse.pStreamNamePlayback = pTuner->pPulseStreamNamePlayback;
+    pTuner->config.pulse.pStreamNameCapture = pTuner->pPulseStreamNameCapture;
+    if ((pConfig->pulse.pStreamNamePlayback != NULL && pTuner->pPulseStreamNamePlayback == NULL) ||
+        (pConfig->pulse.pStreamNameCapture != NULL && pTuner->pPulseStreamNameCapture == NULL)) {
+        sf_autotune_free(pTuner);
+        return MA_OUT_OF_MEMORY;
+    }
+    pTuner->config.periodSizeInFrames = pState->autoTune.minPeriodSizeInFrames;
+    pTuner->config.periodSizeInMilliseconds = 0;
+    pTuner->status.periodSizeInFrames = pState->autoTune.minPeriodSizeInFrames;
+    pTuner->status.atMaximum = pState->autoTune.minPeriodSizeInFrames >= pState->autoTune.maxPeriodSizeInFrames;
+    atomic_init(&pTuner->stopRequested, 0);
+
+    result = ma_device_init(pContext, &pTuner->config, pDevice);
+    if (result != MA_SUCCESS) {
+        sf_autotune_free(pTuner);
+        return result;
+    }
+
+    sf_autotune_read_periods(pTuner, pDevice);
+    sf_device_publish_layout(pState, pDevice);
+    pState->pTuner = pTuner;
+    if (sf_autotune_thread_start(pTuner, pDevice) != 0) {
+        pState->pTuner = NULL;
+        ma_device_uninit(pDevice);
+        sf_autotune_free(pTuner);
+        return MA_FAILED_TO_CREATE_THREAD;
+    }
+    pTuner->threadStarted = MA_TRUE;
+    return MA_SUCCESS;
+}
+
 // Frees a structure allocated with sf_create().
 MA_API void sf_free(void *ptr) {
     ma_free(ptr, NULL);
@@ -76,7 +880,12 @@ MA_API ma_encoder *sf_allocate_encoder() {
 
 // Allocate memory for a device struct.
 MA_API ma_device *sf_allocate_device() {
-    return sf_create(ma_device);
+    struct sf_device_block* pBlock = sf_create(struct sf_device_block);
+    if (pBlock == NULL) {
+        return NULL;
+    }
+    pBlock->pState = NULL;
+    return &pBlock->device;
 }
 
 // Allocate memory for a context struct.
@@ -94,9 +903,20 @@ MA_API ma_device_config* sf_allocate_device_config(const ma_device_type deviceTy
     // Initialize with miniaudio defaults
     *config = ma_device_config_init(deviceType);
 
+    // The facade owns the data callback; the managed one is called through the per-device state, which
+    // sf_device_init hands over to the device.
+    struct sf_device_state* pState = sf_create(struct sf_device_state);
+    if (pState == NULL) {
+        ma_free(config, NULL);
+        return NULL;
+    }
+    memset(pState, 0, sizeof(*pState));
+    pState->onData = onData;
+
     // Basic setup from non-DTO parameters
-    config->dataCallback = onData;
-    config->pUserData = NULL;
+    config->dataCallback = sf_device_data_callback;
+    config->notificationCallback = sf_device_notification_callback;
+    config->pUserData = pState;
     config->sampleRate = sampleRate;
 
     // Apply settings from the config DTO if it's provided.
@@ -109,6 +929,39 @@ MA_API ma_device_config* sf_allocate_device_config(const ma_device_type deviceTy
         config->noClip = pSfConfig->noClip;
         config->noDisableDenormals = pSfConfig->noDisableDenormals;
         config->noFixedSizedCallback = pSfConfig->noFixedSizedCallback;
+        pState->renderAheadPeriods = deviceType == ma_device_type_playback ? pSfConfig->renderAheadPeriods : 0;
+
+        // Offline devices are pumped back to back, so there is no deadline for a render-ahead ring to protect.
+        if (pSfConfig->offline != NULL) {
+            pState->offline = MA_TRUE;
+            pState->renderAheadPeriods = 0;
+            if (pSfConfig->offline->pOutputPath != NULL) {
+                const size_t length = strlen(pSfConfig->offline->pOutputPath);
+                pState->pOfflineOutputPath = (char*)ma_malloc(length + 1, NULL);
+                if (pState->pOfflineOutputPath == NULL) {
+                    ma_free(pState, NULL);
+                    ma_free(config, NULL);
+                    return NULL;
+                }
+                memcpy(pState->pOfflineOutputPath, pSfConfig->offline->pOutputPath, length + 1);
+            }
+        }
+
+        // The tuner bounds latency by reinitialising the device, which a render-ahead ring sized from the
+        // first period would not survive, so it takes the ring's place.
+        if (pSfConfig->autoTune != NULL && !pState->offline) {
+            struct sf_AutoTuneConfig* pTune = &pState->autoTune;
+            *pTune = *pSfConfig->autoTune;
+            pTune->minPeriodSizeInFrames = pTune->minPeriodSizeInFrames != 0 ? pTune->minPeriodSizeInFrames : 64;
+            pTune->maxPeriodSizeInFrames = pTune->maxPeriodSizeInFrames != 0 ? pTune->maxPeriodSizeInFrames : 4096;
+            pTune->windowMilliseconds = pTune->windowMilliseconds != 0 ? pTune->windowMilliseconds : 1000;
+            pTune->stableWindows = pTune->stableWindows != 0 ? pTune->stableWindows : 5;
+            if (pTune->maxPeriodSizeInFrames < pTune->minPeriodSizeInFrames) {
+                pTune->maxPeriodSizeInFrames = pTune->minPeriodSizeInFrames;
+            }
+            pState->autoTuneEnabled = MA_TRUE;
+            pState->renderAheadPeriods = 0;
+        }
 
         // Playback and Capture sub-configs
         if (pSfConfig->playback != NULL) {
@@ -289,12 +1142,1880 @@ MA_API ma_result sf_get_devices(ma_context *context, struct sf_device_info **ppP
     return result;
 }
 
-// Returns the backend used by the context.
-MA_API ma_backend sf_context_get_backend(const ma_context* pContext)
-{
+static ma_result sf_virtual_context_init(ma_context* pContext, const ma_context_config* pConfig, ma_backend_callbacks* pCallbacks);
+
+// Facade data of a context created by sf_context_init, installed as the context's user data.
+#define SF_CONTEXT_STATE_MAGIC 0x53464354u
+
+struct sf_context_state {
+    ma_uint32 magic;                    // Tells sf_device_init the user data is ours.
+    ma_uint64 cpuAffinityMask;
+};
+
+static const struct sf_context_state* sf_context_get_state(const ma_context* pContext) {
+    if (pContext == NULL || pContext->pUserData == NULL) {
+        return NULL;
+    }
+
+    const struct sf_context_state* pState = (const struct sf_context_state*)pContext->pUserData;
+    return pState->magic == SF_CONTEXT_STATE_MAGIC ? pState : NULL;
+}
+
+// Initializes a context with the thread and backend options from the config DTO, if provided.
+MA_API ma_result sf_context_init(const ma_backend* pBackends, const ma_uint32 backendCount, const struct sf_ContextConfig* pSfConfig,
+                                 ma_context* pContext) {
     if (pContext == NULL) {
-        return ma_backend_null;
+        return MA_INVALID_ARGS;
     }
 
-    return pContext->backend;
-}
\ No newline at end of file
+    struct sf_context_state* pState = sf_create(struct sf_context_state);
+    if (pState == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+    memset(pState, 0, sizeof(*pState));
+    pState->magic = SF_CONTEXT_STATE_MAGIC;
+
+    ma_context_config config = ma_context_config_init();
+    config.pUserData = pState;
+
+    // The virtual backend always initialises, so it is only installed on request. Default probing tries
+    // ma_backend_custom before ma_backend_null and would otherwise open headless hosts on an empty device list.
+    for (ma_uint32 i = 0; pBackends != NULL && i < backendCount; i++) {
+        if (pBackends[i] == ma_backend_custom) {
+            config.custom.onContextInit = sf_virtual_context_init;
+            break;
+        }
+    }
+
+    if (pSfConfig != NULL) {
+        config.threadPriority = pSfConfig->threadPriority;
+        config.threadStackSize = pSfConfig->threadStackSize;
+        pState->cpuAffinityMask = pSfConfig->cpuAffinityMask;
+
+        if (pSfConfig->alsa != NULL) {
+            config.alsa.useVerboseDeviceEnumeration = pSfConfig->alsa->useVerboseDeviceEnumeration;
+        }
+        if (pSfConfig->pulse != NULL) {
+            config.pulse.pApplicationName = pSfConfig->pulse->pApplicationName;
+            config.pulse.pServerName = pSfConfig->pulse->pServerName;
+            config.pulse.tryAutoSpawn = pSfConfig->pulse->tryAutoSpawn;
+        }
+        if (pSfConfig->jack != NULL) {
+            config.jack.pClientName = pSfConfig->jack->pClientName;
+            config.jack.tryStartServer = pSfConfig->jack->tryStartServer;
+        }
+        if (pSfConfig->coreaudio != NULL) {
+            config.coreaudio.sessionCategory = pSfConfig->coreaudio->sessionCategory;
+            config.coreaudio.sessionCategoryOptions = pSfConfig->coreaudio->sessionCategoryOptions;
+            config.coreaudio.noAudioSessionActivate = pSfConfig->coreaudio->noAudioSessionActivate;
+            config.coreaudio.noAudioSessionDeactivate = pSfConfig->coreaudio->noAudioSessionDeactivate;
+        }
+    }
+
+    const ma_result result = ma_context_init(pBackends, backendCount, &config, pContext);
+    if (result != MA_SUCCESS) {
+        ma_free(pState, NULL);
+    }
+    return result;
+}
+
+// Uninitializes a context created with sf_context_init and frees its facade data.
+MA_API ma_result sf_context_uninit(ma_context* pContext) {
+    if (pContext == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+    struct sf_context_state* pState = (struct sf_context_state*)sf_context_get_state(pContext);
+    const ma_result result = ma_context_uninit(pContext);
+    ma_free(pState, NULL);
+    return result;
+}
+
+// Returns the backend used by the context.
+MA_API ma_backend sf_context_get_backend(const ma_context* pContext)
+{
+    if (pContext == NULL) {
+        return ma_backend_null;
+    }
+
+    return pContext->backend;
+}
+
+// Routes a config's callbacks through a function table with an opaque per-device context, so each callback reaches
+// its handler directly. Must be called before sf_device_init.
+MA_API ma_result sf_device_config_set_callbacks(ma_device_config* pConfig, const struct sf_DeviceCallbacks* pCallbacks, void* pUserData) {
+    if (pConfig == NULL || pConfig->pUserData == NULL || pConfig->dataCallback != sf_device_data_callback) {
+        return MA_INVALID_ARGS;
+    }
+
+    struct sf_device_state* pState = (struct sf_device_state*)pConfig->pUserData;
+    if (pCallbacks != NULL) {
+        pState->callbacks = *pCallbacks;
+    } else {
+        memset(&pState->callbacks, 0, sizeof(pState->callbacks));
+    }
+    pState->pCallbackUserData = pUserData;
+    return MA_SUCCESS;
+}
+
+// Returns the monotonic clock used for callback timestamps, in nanoseconds.
+MA_API ma_uint64 sf_get_time_ns(void) {
+    return sf_time_ns();
+}
+
+// Initializes a device from a config allocated with sf_allocate_device_config and takes ownership of its
+// per-device state. The state is released on failure, so the config must not be reused afterwards.
+MA_API ma_result sf_device_init(ma_context* pContext, const ma_device_config* pConfig, ma_device* pDevice) {
+    if (pConfig == NULL || pDevice == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+    struct sf_device_state* pState = (struct sf_device_state*)pConfig->pUserData;
+
+    // Offline devices run their callback on the caller's thread in sf_device_render, which must not end up pinned.
+    const struct sf_context_state* pContextState = sf_context_get_state(pContext);
+    if (pState != NULL && !pState->offline && pContextState != NULL) {
+        pState->cpuAffinityMask = pContextState->cpuAffinityMask;
+    }
+
+    if (pState != NULL && pState->offline) {
+        const ma_result result = sf_offline_init(pState, pConfig, pDevice);
+        if (result != MA_SUCCESS) {
+            sf_device_state_free(pState);
+            return result;
+        }
+        sf_device_publish_layout(pState, pDevice);
+        sf_device_set_state(pDevice, pState);
+        return MA_SUCCESS;
+    }
+
+    if (pState != NULL && pState->autoTuneEnabled) {
+        const ma_result result = sf_autotune_init(pState, pContext, pConfig, pDevice);
+        if (result != MA_SUCCESS) {
+            sf_device_state_free(pState);
+            return result;
+        }
+        sf_device_set_state(pDevice, pState);
+        return MA_SUCCESS;
+    }
+
+    ma_result result = ma_device_init(pContext, pConfig, pDevice);
+    if (result != MA_SUCCESS) {
+        sf_device_state_free(pState);
+        return result;
+    }
+
+    if (pState != NULL && pState->renderAheadPeriods > 0) {
+        result = sf_device_ring_init(pState, pDevice);
+        if (result != MA_SUCCESS) {
+            ma_device_uninit(pDevice);
+            sf_device_state_free(pState);
+            return result;
+        }
+    }
+
+    if (pState != NULL) {
+        sf_device_publish_layout(pState, pDevice);
+    }
+    sf_device_set_state(pDevice, pState);
+    return MA_SUCCESS;
+}
+
+// Uninitializes a device created with sf_device_init and frees its per-device state.
+MA_API void sf_device_uninit(ma_device* pDevice) {
+    if (pDevice == NULL) {
+        return;
+    }
+
+    struct sf_device_state* pState = sf_device_state_of(pDevice);
+    struct sf_offline_device* pOffline = pState != NULL ? pState->pOffline : NULL;
+    if (pOffline != NULL) {
+        sf_offline_stop(pOffline);
+    }
+
+    // Join the tuner first, so it cannot reinitialise the device under us.
+    if (pState != NULL && pState->pTuner != NULL) {
+        sf_autotune_free(pState->pTuner);
+        pState->pTuner = NULL;
+    }
+
+    ma_device_uninit(pDevice);
+    if (pOffline != NULL) {
+        sf_offline_free(pOffline);
+    }
+    sf_device_set_state(pDevice, NULL);
+    sf_device_state_free(pState);
+}
+
+// Starts a device created with sf_device_init. An offline device starts rendering on its own thread instead.
+MA_API ma_result sf_device_start(ma_device* pDevice) {
+    struct sf_offline_device* pOffline = sf_device_get_offline(pDevice);
+    if (pOffline == NULL) {
+        struct sf_device_state* pState = sf_device_state_of(pDevice);
+        struct sf_autotuner* pTuner = pState != NULL ? pState->pTuner : NULL;
+        if (pTuner != NULL) {
+            ma_mutex_lock(&pTuner->lock);
+        }
+
+        // The gap while the device was stopped is not a late callback.
+        if (pState != NULL && !ma_device_is_started(pDevice)) {
+            pState->perfLastStartNs = 0;
+        }
+        const ma_result result = ma_device_start(pDevice);
+
+        if (pTuner != NULL) {
+            pTuner->started = result == MA_SUCCESS;
+            ma_mutex_unlock(&pTuner->lock);
+        }
+        return result;
+    }
+
+    if (atomic_exchange_explicit(&pOffline->running, 1, memory_order_acq_rel)) {
+        return MA_SUCCESS;
+    }
+    if (sf_offline_thread_start(pOffline, pDevice) != 0) {
+        atomic_store_explicit(&pOffline->running, 0, memory_order_release);
+        return MA_FAILED_TO_CREATE_THREAD;
+    }
+    pOffline->threadStarted = MA_TRUE;
+    return MA_SUCCESS;
+}
+
+// Stops a device created with sf_device_init. For an offline device, returns once the current period is rendered.
+MA_API ma_result sf_device_stop(ma_device* pDevice) {
+    struct sf_offline_device* pOffline = sf_device_get_offline(pDevice);
+    if (pOffline == NULL) {
+        const struct sf_device_state* pState = sf_device_state_of(pDevice);
+        struct sf_autotuner* pTuner = pState != NULL ? pState->pTuner : NULL;
+        if (pTuner == NULL) {
+            return ma_device_stop(pDevice);
+        }
+
+        ma_mutex_lock(&pTuner->lock);
+        const ma_result result = ma_device_stop(pDevice);
+        pTuner->started = MA_FALSE;
+        ma_mutex_unlock(&pTuner->lock);
+        return result;
+    }
+
+    sf_offline_stop(pOffline);
+    return MA_SUCCESS;
+}
+
+// Renders frameCount frames of an offline device on the calling thread, one period at a time.
+MA_API ma_result sf_device_render(ma_device* pDevice, ma_uint64 frameCount, void* pOutput) {
+    struct sf_offline_device* pOffline = sf_device_get_offline(pDevice);
+    if (pOffline == NULL) {
+        return MA_INVALID_OPERATION;
+    }
+    if (atomic_load_explicit(&pOffline->running, memory_order_acquire)) {
+        return MA_BUSY;
+    }
+
+    while (frameCount > 0) {
+        const ma_uint32 frames = frameCount < pOffline->periodInFrames ? (ma_uint32)frameCount : pOffline->periodInFrames;
+        sf_offline_render_period(pDevice, pOffline, frames, pOutput);
+        if (pOutput != NULL) {
+            pOutput = ma_offset_pcm_frames_ptr(pOutput, frames, pDevice->playback.format, pDevice->playback.channels);
+        }
+        frameCount -= frames;
+    }
+    return MA_SUCCESS;
+}
+
+MA_API ma_bool32 sf_device_is_offline(const ma_device* pDevice) {
+    return sf_device_get_offline(pDevice) != NULL;
+}
+
+// Returns the render-ahead state of a device, or NULL if render-ahead is disabled.
+static struct sf_device_state* sf_device_get_ring_state(const ma_device* pDevice) {
+    struct sf_device_state* pState = sf_device_state_of(pDevice);
+    return pState != NULL && pState->ringEnabled ? pState : NULL;
+}
+
+// Writes frames into the render-ahead ring. Returns the number of frames written, which is less than
+// frameCount when the ring is full.
+MA_API ma_uint32 sf_device_ring_write(ma_device* pDevice, const void* pFrames, const ma_uint32 frameCount) {
+    struct sf_device_state* pState = sf_device_get_ring_state(pDevice);
+    if (pState == NULL || pFrames == NULL) {
+        return 0;
+    }
+
+    const ma_format format = pDevice->playback.format;
+    const ma_uint32 channels = pDevice->playback.channels;
+    ma_uint32 framesWritten = 0;
+
+    while (framesWritten < frameCount) {
+        ma_uint32 framesToWrite = frameCount - framesWritten;
+        void* pWriteBuffer;
+        if (ma_pcm_rb_acquire_write(&pState->ring, &framesToWrite, &pWriteBuffer) != MA_SUCCESS || framesToWrite == 0) {
+            break;
+        }
+
+        ma_copy_pcm_frames(pWriteBuffer, ma_offset_pcm_frames_const_ptr(pFrames, framesWritten, format, channels), framesToWrite, format, channels);
+        ma_pcm_rb_commit_write(&pState->ring, framesToWrite);
+        framesWritten += framesToWrite;
+    }
+
+    return framesWritten;
+}
+
+// Returns how many frames can be written to the render-ahead ring without blocking.
+MA_API ma_uint32 sf_device_ring_available_write(ma_device* pDevice) {
+    struct sf_device_state* pState = sf_device_get_ring_state(pDevice);
+    return pState == NULL ? 0 : ma_pcm_rb_available_write(&pState->ring);
+}
+
+// Blocks the render thread until the device callback has consumed frames from the ring, or sf_device_ring_wake is called.
+MA_API ma_result sf_device_ring_wait(ma_device* pDevice) {
+    struct sf_device_state* pState = sf_device_get_ring_state(pDevice);
+    if (pState == NULL) {
+        return MA_INVALID_OPERATION;
+    }
+
+    const ma_result result = sf_semaphore_wait(&pState->ringWake);
+    // Cleared after waking, so a drain that lands before the caller re-checks the ring needs no second post.
+    atomic_store_explicit(&pState->ringWakePending, 0, memory_order_release);
+    return result;
+}
+
+// Releases a render thread blocked in sf_device_ring_wait, e.g. when the device is being stopped.
+MA_API void sf_device_ring_wake(ma_device* pDevice) {
+    struct sf_device_state* pState = sf_device_get_ring_state(pDevice);
+    if (pState != NULL) {
+        sf_device_ring_signal(pState);
+    }
+}
+
+// Discards the frames queued in the render-ahead ring. Only while the device is stopped and no render thread is writing.
+MA_API void sf_device_ring_reset(ma_device* pDevice) {
+    struct sf_device_state* pState = sf_device_get_ring_state(pDevice);
+    if (pState != NULL) {
+        ma_pcm_rb_reset(&pState->ring);
+    }
+}
+
+// Retrieves the render-ahead ring's size, fill level and underrun counters.
+MA_API ma_result sf_device_ring_get_stats(ma_device* pDevice, struct sf_RingStats* pStats) {
+    if (pStats == NULL) {
+        return MA_INVALID_ARGS;
+    }
+    memset(pStats, 0, sizeof(*pStats));
+
+    struct sf_device_state* pState = sf_device_get_ring_state(pDevice);
+    if (pState == NULL) {
+        return MA_INVALID_OPERATION;
+    }
+
+    pStats->periodSizeInFrames = pState->ringPeriodInFrames;
+    pStats->capacityInFrames = pState->ringPeriodInFrames * pState->renderAheadPeriods;
+    pStats->availableFrames = ma_pcm_rb_available_read(&pState->ring);
+    pStats->underrunCount = atomic_load_explicit(&pState->underrunCount, memory_order_relaxed);
+    pStats->underrunFrames = atomic_load_explicit(&pState->underrunFrames, memory_order_relaxed);
+    return MA_SUCCESS;
+}
+
+// Copies the latest callback performance snapshot. Lock-free; safe to call from any thread while the device runs.
+MA_API ma_result sf_device_get_perf_stats(ma_device* pDevice, struct sf_PerfStats* pStats) {
+    struct sf_device_state* pState = sf_device_state_of(pDevice);
+    if (pState == NULL || pStats == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+    sf_perf_read(pState, pStats);
+    return MA_SUCCESS;
+}
+
+// Converts a frame count at the device's internal rate to the client rate the callback runs at.
+static ma_uint32 sf_internal_to_client_frames(const ma_uint64 frames, const ma_uint32 internalSampleRate, const ma_uint32 sampleRate) {
+    if (internalSampleRate == 0 || internalSampleRate == sampleRate) {
+        return (ma_uint32)frames;
+    }
+    return (ma_uint32)(frames * sampleRate / internalSampleRate);
+}
+
+// Reports the device's clock: frames rendered, the time of the last callback and the negotiated period layout,
+// so callers can interpolate what is being heard between callbacks. Lock-free and callable from any thread, also
+// while the auto-tuner reinitialises the device: the layout is the one published when the device was last initialised.
+MA_API ma_result sf_device_get_timing(ma_device* pDevice, struct sf_DeviceTiming* pTiming) {
+    if (pDevice == NULL || pTiming == NULL) {
+        return MA_INVALID_ARGS;
+    }
+    memset(pTiming, 0, sizeof(*pTiming));
+
+    struct sf_device_state* pState = sf_device_state_of(pDevice);
+    if (pState != NULL) {
+        unsigned int before, after;
+        do {
+            before = atomic_load_explicit(&pState->perfSequence, memory_order_acquire);
+            pTiming->lastCallbackFramePosition = pState->clockFramePosition;
+            pTiming->lastCallbackTimestampNs = pState->clockTimestampNs;
+            pTiming->lastCallbackFrameCount = pState->clockFrameCount;
+            pTiming->sampleRate = pState->layoutSampleRate;
+            pTiming->internalSampleRate = pState->layoutInternalSampleRate;
+            pTiming->periodSizeInFrames = pState->layoutPeriodSizeInFrames;
+            pTiming->periods = pState->layoutPeriods;
+            atomic_thread_fence(memory_order_acquire);
+            after = atomic_load_explicit(&pState->perfSequence, memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        if (pState->ringEnabled) {
+            pTiming->renderAheadFrames = pState->ringPeriodInFrames * pState->renderAheadPeriods;
+        }
+        pTiming->framesRendered = atomic_load_explicit(&pState->framePosition, memory_order_relaxed);
+    } else {
+        // Without per-device state there is no tuner, so the device fields are stable.
+        const ma_bool32 isCapture = pDevice->type == ma_device_type_capture || pDevice->type == ma_device_type_loopback;
+        pTiming->sampleRate = pDevice->sampleRate;
+        pTiming->internalSampleRate = isCapture ? pDevice->capture.internalSampleRate : pDevice->playback.internalSampleRate;
+        pTiming->periodSizeInFrames = isCapture ? pDevice->capture.internalPeriodSizeInFrames : pDevice->playback.internalPeriodSizeInFrames;
+        pTiming->periods = isCapture ? pDevice->capture.internalPeriods : pDevice->playback.internalPeriods;
+    }
+
+    pTiming->periodLatencyFrames = sf_internal_to_client_frames(pTiming->periodSizeInFrames, pTiming->internalSampleRate, pTiming->sampleRate);
+    pTiming->internalLatencyFrames = sf_internal_to_client_frames((ma_uint64)pTiming->periodSizeInFrames * pTiming->periods,
+                                                                  pTiming->internalSampleRate, pTiming->sampleRate);
+    pTiming->timestampNs = sf_time_ns();
+    return MA_SUCCESS;
+}
+
+// Reports the period the auto-tuner has settled on, or is currently trying.
+MA_API ma_result sf_device_get_autotune_status(ma_device* pDevice, struct sf_AutoTuneStatus* pStatus) {
+    const struct sf_device_state* pState = sf_device_state_of(pDevice);
+    if (pState == NULL || pStatus == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+    struct sf_autotuner* pTuner = pState->pTuner;
+    if (pTuner == NULL) {
+        return MA_INVALID_OPERATION;
+    }
+
+    ma_mutex_lock(&pTuner->lock);
+    *pStatus = pTuner->status;
+    ma_mutex_unlock(&pTuner->lock);
+    return MA_SUCCESS;
+}
+
+// Clears the performance counters. Takes effect at the device's next callback.
+MA_API void sf_device_reset_perf_stats(ma_device* pDevice) {
+    struct sf_device_state* pState = sf_device_state_of(pDevice);
+    if (pState == NULL) {
+        return;
+    }
+
+    atomic_store_explicit(&pState->perfResetRequested, 1, memory_order_release);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Device Cache
+// ---------------------------------------------------------------------------------------------------------------------
+
+// A device seen by the cache. Entries live until the cache is destroyed, so the ids and formats that snapshots
+// point at stay valid, and a device keeps the same id pointer across refreshes.
+struct sf_cached_device {
+    ma_device_type type;
+    ma_device_id id;
+    struct sf_device_info info;         // info.id points at id above.
+    ma_bool32 present;
+    ma_bool32 wasPresent;
+    struct sf_cached_device* next;
+};
+
+// A device added or removed by a refresh, queued for the change callback. info is a copy; the id and formats it
+// points at belong to the cache.
+struct sf_device_cache_event {
+    ma_device_type type;
+    struct sf_device_info info;
+    ma_bool32 added;
+    struct sf_device_cache_event* next;
+};
+
+// Formats replaced when a device came back with new info. Older snapshots may still point at them.
+struct sf_retired_formats {
+    struct native_data_format* pFormats;
+    struct sf_retired_formats* next;
+};
+
+// An immutable device list handed to readers. Reference counted so a refresh never frees a list being read.
+struct sf_device_snapshot {
+    atomic_int refs;
+    ma_uint64 generation;
+    struct sf_device_info* playback;
+    struct sf_device_info* capture;
+    ma_uint32 playbackCount;
+    ma_uint32 captureCount;
+};
+
+#ifdef _WIN32
+typedef SRWLOCK sf_cache_lock;
+typedef CONDITION_VARIABLE sf_cache_cond;
+typedef HANDLE sf_cache_thread;
+#else
+typedef pthread_mutex_t sf_cache_lock;
+typedef pthread_cond_t sf_cache_cond;
+typedef pthread_t sf_cache_thread;
+#endif
+
+struct sf_device_cache {
+    ma_context* pContext;
+    ma_uint32 refreshIntervalMs;
+    sf_cache_lock refreshLock;          // Serializes refreshes; held while enumerating.
+    sf_cache_lock lock;                 // Guards the fields below; never held while enumerating.
+    sf_cache_cond wake;
+    sf_cache_cond idle;                 // Signalled when activeCalls drops to zero.
+    ma_bool32 stop;
+    ma_bool32 dirty;
+    struct sf_device_snapshot* current;
+    ma_uint64 generation;
+    sf_device_cache_proc onChange;
+    void* pUserData;
+    ma_uint32 activeCalls;              // Refreshes in progress, change delivery included. Destroy waits for them.
+    ma_bool32 dispatching;              // A thread is delivering queued events.
+    struct sf_device_cache_event* pEventHead;
+    struct sf_device_cache_event* pEventTail;
+    struct sf_cached_device* devices;   // Changed under refreshLock, as is pRetiredFormats.
+    struct sf_retired_formats* pRetiredFormats;
+    sf_cache_thread thread;
+    ma_bool32 threadStarted;
+    struct sf_device_cache* nextCache;
+};
+
+// Live caches, so device notifications can invalidate the cache of their context.
+static ma_spinlock g_cache_registry_lock = 0;
+static struct sf_device_cache* g_cache_registry = NULL;
+
+#ifdef _WIN32
+static void sf_cache_lock_init(sf_cache_lock* pLock) { InitializeSRWLock(pLock); }
+static void sf_cache_lock_uninit(sf_cache_lock* pLock) { (void)pLock; }
+static void sf_cache_lock_acquire(sf_cache_lock* pLock) { AcquireSRWLockExclusive(pLock); }
+static void sf_cache_lock_release(sf_cache_lock* pLock) { ReleaseSRWLockExclusive(pLock); }
+static void sf_cache_cond_init(sf_cache_cond* pCond) { InitializeConditionVariable(pCond); }
+static void sf_cache_cond_uninit(sf_cache_cond* pCond) { (void)pCond; }
+static void sf_cache_cond_signal(sf_cache_cond* pCond) { WakeConditionVariable(pCond); }
+static void sf_cache_cond_wait(sf_cache_cond* pCond, sf_cache_lock* pLock, const ma_uint32 timeoutMs) {
+    SleepConditionVariableSRW(pCond, pLock, timeoutMs == 0 ? INFINITE : timeoutMs, 0);
+}
+#else
+static void sf_cache_lock_init(sf_cache_lock* pLock) { pthread_mutex_init(pLock, NULL); }
+static void sf_cache_lock_uninit(sf_cache_lock* pLock) { pthread_mutex_destroy(pLock); }
+static void sf_cache_lock_acquire(sf_cache_lock* pLock) { pthread_mutex_lock(pLock); }
+static void sf_cache_lock_release(sf_cache_lock* pLock) { pthread_mutex_unlock(pLock); }
+static void sf_cache_cond_init(sf_cache_cond* pCond) { pthread_cond_init(pCond, NULL); }
+static void sf_cache_cond_uninit(sf_cache_cond* pCond) { pthread_cond_destroy(pCond); }
+static void sf_cache_cond_signal(sf_cache_cond* pCond) { pthread_cond_signal(pCond); }
+static void sf_cache_cond_wait(sf_cache_cond* pCond, sf_cache_lock* pLock, const ma_uint32 timeoutMs) {
+    if (timeoutMs == 0) {
+        pthread_cond_wait(pCond, pLock);
+        return;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(pCond, pLock, &deadline);
+}
+#endif
+
+static void sf_device_snapshot_release(struct sf_device_snapshot* pSnapshot) {
+    if (pSnapshot == NULL || atomic_fetch_sub_explicit(&pSnapshot->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    ma_free(pSnapshot->playback, NULL);
+    ma_free(pSnapshot->capture, NULL);
+    ma_free(pSnapshot, NULL);
+}
+
+// Queries a device's full info into its entry. Formats it replaces are retired rather than freed, since older
+// snapshots may still point at them.
+static void sf_device_cache_query_info(struct sf_device_cache* pCache, struct sf_cached_device* pEntry, const ma_device_info* pBasicInfo) {
+    if (pEntry->info.nativeDataFormats != NULL) {
+        struct sf_retired_formats* pRetired = sf_create(struct sf_retired_formats);
+        if (pRetired == NULL) {
+            return;
+        }
+        pRetired->pFormats = pEntry->info.nativeDataFormats;
+        pRetired->next = pCache->pRetiredFormats;
+        pCache->pRetiredFormats = pRetired;
+    }
+
+    ma_device_info fullDeviceInfo;
+    const ma_result infoResult = ma_context_get_device_info(pCache->pContext, pEntry->type, &pBasicInfo->id, &fullDeviceInfo);
+    pEntry->info = sf_create_device_info(pBasicInfo, infoResult == MA_SUCCESS ? &fullDeviceInfo : pBasicInfo);
+    pEntry->info.id = &pEntry->id;
+}
+
+// Finds the entry for a device id, creating it the first time it is seen. The device's full info is queried then,
+// and again when a removed device comes back, since it may return with a different name or formats.
+static struct sf_cached_device* sf_device_cache_lookup(struct sf_device_cache* pCache, const ma_device_type type, const ma_device_info* pBasicInfo) {
+    for (struct sf_cached_device* pEntry = pCache->devices; pEntry != NULL; pEntry = pEntry->next) {
+        if (pEntry->type == type && memcmp(&pEntry->id, &pBasicInfo->id, sizeof(ma_device_id)) == 0) {
+            if (!pEntry->wasPresent && !pEntry->present) {
+                sf_device_cache_query_info(pCache, pEntry, pBasicInfo);
+            }
+            return pEntry;
+        }
+    }
+
+    struct sf_cached_device* pEntry = sf_create(struct sf_cached_device);
+    if (pEntry == NULL) {
+        return NULL;
+    }
+    memset(pEntry, 0, sizeof(*pEntry));
+    pEntry->type = type;
+    pEntry->id = pBasicInfo->id;
+    sf_device_cache_query_info(pCache, pEntry, pBasicInfo);
+
+    pEntry->next = pCache->devices;
+    pCache->devices = pEntry;
+    return pEntry;
+}
+
+// Builds one direction of a snapshot from the enumerated devices, marking each as present.
+static ma_result sf_device_cache_collect(struct sf_device_cache* pCache, const ma_device_type type, const ma_device_info* pBasicInfos,
+                                         const ma_uint32 count, struct sf_device_info** ppInfos, ma_uint32* pCount, ma_bool32* pChanged) {
+    *ppInfos = NULL;
+    *pCount = 0;
+    if (count == 0 || pBasicInfos == NULL) {
+        return MA_SUCCESS;
+    }
+
+    *ppInfos = (struct sf_device_info*)ma_malloc(sizeof(struct sf_device_info) * count, NULL);
+    if (*ppInfos == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+
+    for (ma_uint32 i = 0; i < count; ++i) {
+        struct sf_cached_device* pEntry = sf_device_cache_lookup(pCache, type, &pBasicInfos[i]);
+        if (pEntry == NULL) {
+            continue;
+        }
+
+        // The default device can move without any device appearing or disappearing.
+        if (pEntry->info.isDefault != (ma_bool8)pBasicInfos[i].isDefault) {
+            pEntry->info.isDefault = (ma_bool8)pBasicInfos[i].isDefault;
+            *pChanged = MA_TRUE;
+        }
+        pEntry->present = MA_TRUE;
+        (*ppInfos)[(*pCount)++] = pEntry->info;
+    }
+
+    return MA_SUCCESS;
+}
+
+// Queues a change of pEntry for the callback. Under refreshLock, while the entry's presence is stable.
+static void sf_device_cache_queue_event(struct sf_device_cache* pCache, const struct sf_cached_device* pEntry) {
+    struct sf_device_cache_event* pEvent = sf_create(struct sf_device_cache_event);
+    if (pEvent == NULL) {
+        return;
+    }
+    pEvent->type = pEntry->type;
+    pEvent->info = pEntry->info;
+    pEvent->added = pEntry->present;
+    pEvent->next = NULL;
+
+    sf_cache_lock_acquire(&pCache->lock);
+    if (pCache->pEventTail != NULL) {
+        pCache->pEventTail->next = pEvent;
+    } else {
+        pCache->pEventHead = pEvent;
+    }
+    pCache->pEventTail = pEvent;
+    sf_cache_lock_release(&pCache->lock);
+}
+
+// Delivers queued events in order, with no lock held, so the callback may refresh the cache itself. One thread
+// delivers at a time; a refresh that finds another thread delivering leaves its events to that thread.
+static void sf_device_cache_dispatch(struct sf_device_cache* pCache) {
+    sf_cache_lock_acquire(&pCache->lock);
+    if (pCache->dispatching) {
+        sf_cache_lock_release(&pCache->lock);
+        return;
+    }
+
+    pCache->dispatching = MA_TRUE;
+    while (pCache->pEventHead != NULL && !pCache->stop) {
+        struct sf_device_cache_event* pEvent = pCache->pEventHead;
+        pCache->pEventHead = pEvent->next;
+        if (pCache->pEventHead == NULL) {
+            pCache->pEventTail = NULL;
+        }
+        const sf_device_cache_proc onChange = pCache->onChange;
+        void* pUserData = pCache->pUserData;
+        sf_cache_lock_release(&pCache->lock);
+
+        if (onChange != NULL) {
+            onChange(pUserData, pEvent->type, &pEvent->info, pEvent->added);
+        }
+        ma_free(pEvent, NULL);
+
+        sf_cache_lock_acquire(&pCache->lock);
+    }
+    pCache->dispatching = MA_FALSE;
+    sf_cache_lock_release(&pCache->lock);
+}
+
+// Re-enumerates under refreshLock and publishes a new snapshot if anything changed, queueing the changes.
+static ma_result sf_device_cache_enumerate(struct sf_device_cache* pCache) {
+    sf_cache_lock_acquire(&pCache->refreshLock);
+
+    ma_device_info* pPlaybackInfos = NULL;
+    ma_device_info* pCaptureInfos = NULL;
+    ma_uint32 playbackCount = 0;
+    ma_uint32 captureCount = 0;
+    ma_result result = ma_context_get_devices(pCache->pContext, &pPlaybackInfos, &playbackCount, &pCaptureInfos, &captureCount);
+    if (result != MA_SUCCESS) {
+        sf_cache_lock_release(&pCache->refreshLock);
+        return result;
+    }
+
+    for (struct sf_cached_device* pEntry = pCache->devices; pEntry != NULL; pEntry = pEntry->next) {
+        pEntry->wasPresent = pEntry->present;
+        pEntry->present = MA_FALSE;
+    }
+
+    struct sf_device_snapshot* pSnapshot = sf_create(struct sf_device_snapshot);
+    if (pSnapshot == NULL) {
+        sf_cache_lock_release(&pCache->refreshLock);
+        return MA_OUT_OF_MEMORY;
+    }
+    memset(pSnapshot, 0, sizeof(*pSnapshot));
+    atomic_init(&pSnapshot->refs, 1);
+
+    ma_bool32 changed = pCache->current == NULL;
+    result = sf_device_cache_collect(pCache, ma_device_type_playback, pPlaybackInfos, playbackCount,
+                                     &pSnapshot->playback, &pSnapshot->playbackCount, &changed);
+    if (result == MA_SUCCESS) {
+        result = sf_device_cache_collect(pCache, ma_device_type_capture, pCaptureInfos, captureCount,
+                                         &pSnapshot->capture, &pSnapshot->captureCount, &changed);
+    }
+    if (result != MA_SUCCESS) {
+        // Leave the previous list in place.
+        for (struct sf_cached_device* pEntry = pCache->devices; pEntry != NULL; pEntry = pEntry->next) {
+            pEntry->present = pEntry->wasPresent;
+        }
+        sf_device_snapshot_release(pSnapshot);
+        sf_cache_lock_release(&pCache->refreshLock);
+        return result;
+    }
+
+    for (struct sf_cached_device* pEntry = pCache->devices; pEntry != NULL; pEntry = pEntry->next) {
+        if (pEntry->present != pEntry->wasPresent) {
+            changed = MA_TRUE;
+        }
+    }
+
+    sf_cache_lock_acquire(&pCache->lock);
+    struct sf_device_snapshot* pPrevious = NULL;
+    if (changed) {
+        pSnapshot->generation = ++pCache->generation;
+        pPrevious = pCache->current;
+        pCache->current = pSnapshot;
+        pSnapshot = NULL;
+    }
+    const ma_bool32 hasCallback = pCache->onChange != NULL;
+    sf_cache_lock_release(&pCache->lock);
+
+    sf_device_snapshot_release(pSnapshot);
+    sf_device_snapshot_release(pPrevious);
+
+    if (hasCallback) {
+        for (struct sf_cached_device* pEntry = pCache->devices; pEntry != NULL; pEntry = pEntry->next) {
+            if (pEntry->present != pEntry->wasPresent) {
+                sf_device_cache_queue_event(pCache, pEntry);
+            }
+        }
+    }
+
+    sf_cache_lock_release(&pCache->refreshLock);
+    return MA_SUCCESS;
+}
+
+// Re-enumerates the context's devices, querying details only for devices not seen before or coming back, and
+// publishes a new snapshot if anything changed. Change callbacks run after the snapshot is published, on the
+// calling thread unless another refresh is already delivering them, and without any cache lock held.
+MA_API ma_result sf_device_cache_refresh(struct sf_device_cache* pCache) {
+    if (pCache == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+    sf_cache_lock_acquire(&pCache->lock);
+    if (pCache->stop) {
+        sf_cache_lock_release(&pCache->lock);
+        return MA_INVALID_OPERATION;
+    }
+    pCache->activeCalls++;
+    sf_cache_lock_release(&pCache->lock);
+
+    const ma_result result = sf_device_cache_enumerate(pCache);
+    sf_device_cache_dispatch(pCache);
+
+    sf_cache_lock_acquire(&pCache->lock);
+    if (--pCache->activeCalls == 0) {
+        sf_cache_cond_signal(&pCache->idle);
+    }
+    sf_cache_lock_release(&pCache->lock);
+    return result;
+}
+
+static void sf_device_cache_loop(struct sf_device_cache* pCache) {
+    sf_cache_lock_acquire(&pCache->lock);
+    while (!pCache->stop) {
+        if (!pCache->dirty) {
+            sf_cache_cond_wait(&pCache->wake, &pCache->lock, pCache->refreshIntervalMs);
+        }
+        if (pCache->stop) {
+            break;
+        }
+        pCache->dirty = MA_FALSE;
+        sf_cache_lock_release(&pCache->lock);
+
+        sf_device_cache_refresh(pCache);
+
+        sf_cache_lock_acquire(&pCache->lock);
+    }
+    sf_cache_lock_release(&pCache->lock);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI sf_device_cache_thread_main(LPVOID arg) { sf_device_cache_loop((struct sf_device_cache*)arg); return 0; }
+static int sf_device_cache_thread_start(struct sf_device_cache* pCache) {
+    pCache->thread = CreateThread(NULL, 0, sf_device_cache_thread_main, pCache, 0, NULL);
+    return pCache->thread ? 0 : -1;
+}
+static void sf_device_cache_thread_join(sf_cache_thread thread) { WaitForSingleObject(thread, INFINITE); CloseHandle(thread); }
+#else
+static void* sf_device_cache_thread_main(void* arg) { sf_device_cache_loop((struct sf_device_cache*)arg); return NULL; }
+static int sf_device_cache_thread_start(struct sf_device_cache* pCache) { return pthread_create(&pCache->thread, NULL, sf_device_cache_thread_main, pCache); }
+static void sf_device_cache_thread_join(sf_cache_thread thread) { pthread_join(thread, NULL); }
+#endif
+
+// Asks the background thread to refresh now rather than at its next interval.
+MA_API void sf_device_cache_invalidate(struct sf_device_cache* pCache) {
+    if (pCache == NULL) {
+        return;
+    }
+
+    sf_cache_lock_acquire(&pCache->lock);
+    pCache->dirty = MA_TRUE;
+    sf_cache_cond_signal(&pCache->wake);
+    sf_cache_lock_release(&pCache->lock);
+}
+
+static void sf_device_cache_invalidate_context(const ma_context* pContext) {
+    ma_spinlock_lock(&g_cache_registry_lock);
+    for (struct sf_device_cache* pCache = g_cache_registry; pCache != NULL; pCache = pCache->nextCache) {
+        if (pCache->pContext == pContext) {
+            sf_device_cache_invalidate(pCache);
+        }
+    }
+    ma_spinlock_unlock(&g_cache_registry_lock);
+}
+
+// Creates a device cache for a context. The first enumeration runs before this returns; afterwards a background
+// thread refreshes the list every refreshIntervalMs (0 to refresh only on invalidation) and whenever a device
+// reports that the default device changed.
+MA_API struct sf_device_cache* sf_device_cache_create(ma_context* pContext, const ma_uint32 refreshIntervalMs) {
+    if (pContext == NULL) {
+        return NULL;
+    }
+
+    struct sf_device_cache* pCache = sf_create(struct sf_device_cache);
+    if (pCache == NULL) {
+        return NULL;
+    }
+    memset(pCache, 0, sizeof(*pCache));
+    pCache->pContext = pContext;
+    pCache->refreshIntervalMs = refreshIntervalMs;
+    sf_cache_lock_init(&pCache->refreshLock);
+    sf_cache_lock_init(&pCache->lock);
+    sf_cache_cond_init(&pCache->wake);
+    sf_cache_cond_init(&pCache->idle);
+
+    if (sf_device_cache_refresh(pCache) != MA_SUCCESS || sf_device_cache_thread_start(pCache) != 0) {
+        sf_device_cache_destroy(pCache);
+        return NULL;
+    }
+    pCache->threadStarted = MA_TRUE;
+
+    ma_spinlock_lock(&g_cache_registry_lock);
+    pCache->nextCache = g_cache_registry;
+    g_cache_registry = pCache;
+    ma_spinlock_unlock(&g_cache_registry_lock);
+
+    return pCache;
+}
+
+// Stops the background thread, waits for refreshes in progress on other threads, and frees the cache. Must not be
+// called from the change callback. Snapshots still held by readers stay valid until released, but the device ids
+// and formats they point at are freed here.
+MA_API void sf_device_cache_destroy(struct sf_device_cache* pCache) {
+    if (pCache == NULL) {
+        return;
+    }
+
+    ma_spinlock_lock(&g_cache_registry_lock);
+    for (struct sf_device_cache** ppCache = &g_cache_registry; *ppCache != NULL; ppCache = &(*ppCache)->nextCache) {
+        if (*ppCache == pCache) {
+            *ppCache = pCache->nextCache;
+            break;
+        }
+    }
+    ma_spinlock_unlock(&g_cache_registry_lock);
+
+    sf_cache_lock_acquire(&pCache->lock);
+    pCache->stop = MA_TRUE;
+    sf_cache_cond_signal(&pCache->wake);
+    while (pCache->activeCalls > 0) {
+        sf_cache_cond_wait(&pCache->idle, &pCache->lock, 0);
+    }
+    sf_cache_lock_release(&pCache->lock);
+    if (pCache->threadStarted) {
+        sf_device_cache_thread_join(pCache->thread);
+    }
+
+    sf_device_snapshot_release(pCache->current);
+
+    struct sf_device_cache_event* pEvent = pCache->pEventHead;
+    while (pEvent != NULL) {
+        struct sf_device_cache_event* pNextEvent = pEvent->next;
+        ma_free(pEvent, NULL);
+        pEvent = pNextEvent;
+    }
+
+    struct sf_retired_formats* pRetired = pCache->pRetiredFormats;
+    while (pRetired != NULL) {
+        struct sf_retired_formats* pNextRetired = pRetired->next;
+        ma_free(pRetired->pFormats, NULL);
+        ma_free(pRetired, NULL);
+        pRetired = pNextRetired;
+    }
+
+    struct sf_cached_device* pEntry = pCache->devices;
+    while (pEntry != NULL) {
+        struct sf_cached_device* pNext = pEntry->next;
+        ma_free(pEntry->info.nativeDataFormats, NULL);
+        ma_free(pEntry, NULL);
+        pEntry = pNext;
+    }
+
+    sf_cache_cond_uninit(&pCache->wake);
+    sf_cache_cond_uninit(&pCache->idle);
+    sf_cache_lock_uninit(&pCache->lock);
+    sf_cache_lock_uninit(&pCache->refreshLock);
+    ma_free(pCache, NULL);
+}
+
+// Sets the function called for every device added or removed, in order, from whichever thread refreshed the cache
+// (normally its background thread). pInfo is valid for the call; the id and formats it points at stay valid for the
+// lifetime of the cache.
+MA_API void sf_device_cache_set_callback(struct sf_device_cache* pCache, const sf_device_cache_proc onChange, void* pUserData) {
+    if (pCache == NULL) {
+        return;
+    }
+
+    sf_cache_lock_acquire(&pCache->lock);
+    pCache->onChange = onChange;
+    pCache->pUserData = pUserData;
+    sf_cache_lock_release(&pCache->lock);
+}
+
+// Returns the current device list without enumerating. The arrays stay valid until the returned snapshot is
+// passed to sf_device_cache_release.
+MA_API struct sf_device_snapshot* sf_device_cache_acquire(struct sf_device_cache* pCache, struct sf_device_info** ppPlaybackDeviceInfos,
+                                                          struct sf_device_info** ppCaptureDeviceInfos, ma_uint32* pPlaybackDeviceCount,
+                                                          ma_uint32* pCaptureDeviceCount, ma_uint64* pGeneration) {
+    if (pCache == NULL || ppPlaybackDeviceInfos == NULL || ppCaptureDeviceInfos == NULL ||
+        pPlaybackDeviceCount == NULL || pCaptureDeviceCount == NULL) {
+        return NULL;
+    }
+
+    sf_cache_lock_acquire(&pCache->lock);
+    struct sf_device_snapshot* pSnapshot = pCache->current;
+    if (pSnapshot != NULL) {
+        atomic_fetch_add_explicit(&pSnapshot->refs, 1, memory_order_relaxed);
+    }
+    sf_cache_lock_release(&pCache->lock);
+
+    *ppPlaybackDeviceInfos = pSnapshot != NULL ? pSnapshot->playback : NULL;
+    *ppCaptureDeviceInfos = pSnapshot != NULL ? pSnapshot->capture : NULL;
+    *pPlaybackDeviceCount = pSnapshot != NULL ? pSnapshot->playbackCount : 0;
+    *pCaptureDeviceCount = pSnapshot != NULL ? pSnapshot->captureCount : 0;
+    if (pGeneration != NULL) {
+        *pGeneration = pSnapshot != NULL ? pSnapshot->generation : 0;
+    }
+    return pSnapshot;
+}
+
+// Releases a snapshot returned by sf_device_cache_acquire.
+MA_API void sf_device_cache_release(struct sf_device_snapshot* pSnapshot) {
+    sf_device_snapshot_release(pSnapshot);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Sample Conversion
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Converts between f32 and the integer device formats with clipping and optional TPDF dither. The s16 and s32 paths
+// have SSE2/AVX2 (x86) and NEON (arm64) kernels chosen at runtime; s24 and u8 run scalar. Integer scaling matches
+// the managed DeviceBufferHelper: full scale is 32767, 8388607 and 2147483647, and u8 is centred on 127.5.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SF_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SF_TARGET_SSE2
+#define SF_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define SF_TARGET_SSE2 __attribute__((target("sse2")))
+#define SF_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SF_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// The largest float below 2^31, so scaled s32 samples never overflow the conversion.
+#define SF_S32_MAX_FLOAT 2147483520.0f
+
+// Per-thread dither generator state: one scalar xorshift32 and eight SIMD lanes, seeded on first use.
+static SF_THREAD_LOCAL ma_uint32 g_dither_state = 0;
+static SF_THREAD_LOCAL ma_uint32 g_dither_lanes[8];
+
+static ma_uint32 sf_xorshift32(ma_uint32* pState) {
+    ma_uint32 x = *pState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *pState = x;
+    return x;
+}
+
+static void sf_dither_seed(void) {
+    if (g_dither_state != 0) {
+        return;
+    }
+
+    g_dither_state = (ma_uint32)(sf_time_ns() ^ (ma_uint64)(size_t)&g_dither_state) | 1u;
+    for (int i = 0; i < 8; ++i) {
+        g_dither_lanes[i] = sf_xorshift32(&g_dither_state) | 1u;
+    }
+}
+
+// Triangular noise in [-1, 1] LSB: the difference of two uniform values.
+static float sf_tpdf(ma_uint32* pState) {
+    const float a = (float)(sf_xorshift32(pState) >> 8) * (1.0f / 16777216.0f);
+    const float b = (float)(sf_xorshift32(pState) >> 8) * (1.0f / 16777216.0f);
+    return a - b;
+}
+
+static ma_int32 sf_quantize(float value, const float lo, const float hi) {
+    if (value < lo) value = lo;
+    if (value > hi) value = hi;
+    return (ma_int32)(value >= 0 ? value + 0.5f : value - 0.5f);
+}
+
+// Scalar conversion of samples [start, count), also used for the tails of the SIMD kernels.
+static void sf_f32_to_pcm_scalar(void* pDst, const ma_format format, const float* pSrc, const ma_uint64 start, const ma_uint64 count, const ma_bool32 dither) {
+    ma_uint32 state = g_dither_state;
+
+    switch (format) {
+        case ma_format_u8: {
+            ma_uint8* pOut = (ma_uint8*)pDst;
+            for (ma_uint64 i = start; i < count; ++i) {
+                const float noise = dither ? sf_tpdf(&state) : 0.0f;
+                pOut[i] = (ma_uint8)sf_quantize(pSrc[i] * 127.5f + 127.5f + noise, 0.0f, 255.0f);
+            }
+            break;
+        }
+        case ma_format_s16: {
+            ma_int16* pOut = (ma_int16*)pDst;
+            for (ma_uint64 i = start; i < count; ++i) {
+                const float noise = dither ? sf_tpdf(&state) : 0.0f;
+                pOut[i] = (ma_int16)sf_quantize(pSrc[i] * 32767.0f + noise, -32768.0f, 32767.0f);
+            }
+            break;
+        }
+        case ma_format_s24: {
+            ma_uint8* pOut = (ma_uint8*)pDst;
+            for (ma_uint64 i = start; i < count; ++i) {
+                const float noise = dither ? sf_tpdf(&state) : 0.0f;
+                const ma_int32 sample = sf_quantize(pSrc[i] * 8388607.0f + noise, -8388608.0f, 8388607.0f);
+                pOut[i * 3 + 0] = (ma_uint8)sample;
+                pOut[i * 3 + 1] = (ma_uint8)(sample >> 8);
+                pOut[i * 3 + 2] = (ma_uint8)(sample >> 16);
+            }
+            break;
+        }
+        case ma_format_s32: {
+            // f32 carries 24 bits of precision, far coarser than an s32 LSB, so s32 is never dithered.
+            ma_int32* pOut = (ma_int32*)pDst;
+            for (ma_uint64 i = start; i < count; ++i) {
+                pOut[i] = sf_quantize(pSrc[i] * 2147483647.0f, -2147483648.0f, SF_S32_MAX_FLOAT);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    g_dither_state = state;
+}
+
+static void sf_pcm_to_f32_scalar(float* pDst, const void* pSrc, const ma_format format, const ma_uint64 start, const ma_uint64 count) {
+    switch (format) {
+        case ma_format_u8: {
+            const ma_uint8* pIn = (const ma_uint8*)pSrc;
+            for (ma_uint64 i = start; i < count; ++i) {
+                pDst[i] = ((float)pIn[i] - 128.0f) * (1.0f / 128.0f);
+            }
+            break;
+        }
+        case ma_format_s16: {
+            const ma_int16* pIn = (const ma_int16*)pSrc;
+            for (ma_uint64 i = start; i < count; ++i) {
+                pDst[i] = (float)pIn[i] * (1.0f / 32767.0f);
+            }
+            break;
+        }
+        case ma_format_s24: {
+            const ma_uint8* pIn = (const ma_uint8*)pSrc;
+            for (ma_uint64 i = start; i < count; ++i) {
+                // Assemble in the top 24 bits so the arithmetic shift sign-extends.
+                const ma_int32 sample = (ma_int32)(((ma_uint32)pIn[i * 3] << 8) | ((ma_uint32)pIn[i * 3 + 1] << 16) | ((ma_uint32)pIn[i * 3 + 2] << 24)) >> 8;
+                pDst[i] = (float)sample * (1.0f / 8388607.0f);
+            }
+            break;
+        }
+        case ma_format_s32: {
+            const ma_int32* pIn = (const ma_int32*)pSrc;
+            for (ma_uint64 i = start; i < count; ++i) {
+                pDst[i] = (float)((double)pIn[i] * (1.0 / 2147483647.0));
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+#if defined(SF_SIMD_X86)
+static ma_uint32 sf_detect_simd(void) {
+    ma_uint32 features = 0;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    if (info[3] & (1 << 26)) features |= SF_SIMD_SSE2;
+    const ma_bool32 osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 0x6) == 0x6);
+    if (maxLeaf >= 7 && osSavesYmm) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) features |= SF_SIMD_AVX2;
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) features |= SF_SIMD_SSE2;
+    if (__builtin_cpu_supports("avx2")) features |= SF_SIMD_AVX2;
+#endif
+    return features;
+}
+
+SF_TARGET_SSE2 static __m128 sf_tpdf_sse2(__m128i* pState) {
+    const __m128i one = _mm_set1_epi32(0x3f800000);
+    __m128 noise[2];
+    for (int n = 0; n < 2; ++n) {
+        __m128i x = *pState;
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+        *pState = x;
+        // Mantissa bits under an exponent of 0 give a float in [1, 2).
+        noise[n] = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(x, 9), one));
+    }
+    return _mm_sub_ps(noise[0], noise[1]);
+}
+
+SF_TARGET_SSE2 static ma_uint64 sf_f32_to_s16_sse2(ma_int16* pDst, const float* pSrc, const ma_uint64 count, const ma_bool32 dither) {
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    __m128i state = _mm_loadu_si128((const __m128i*)g_dither_lanes);
+    ma_uint64 i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(pSrc + i), scale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(pSrc + i + 4), scale);
+        if (dither) {
+            a = _mm_add_ps(a, sf_tpdf_sse2(&state));
+            b = _mm_add_ps(b, sf_tpdf_sse2(&state));
+        }
+        a = _mm_min_ps(_mm_max_ps(a, lo), hi);
+        b = _mm_min_ps(_mm_max_ps(b, lo), hi);
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+
+    _mm_storeu_si128((__m128i*)g_dither_lanes, state);
+    return i;
+}
+
+SF_TARGET_SSE2 static ma_uint64 sf_s16_to_f32_sse2(float* pDst, const ma_int16* pSrc, const ma_uint64 count) {
+    const __m128 scale = _mm_set1_ps(1.0f / 32767.0f);
+    ma_uint64 i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(pSrc + i));
+        // Unpacking a register with itself puts each sample in the top half of a lane; shifting down sign-extends it.
+        const __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+        _mm_storeu_ps(pDst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+    }
+
+    return i;
+}
+
+SF_TARGET_SSE2 static ma_uint64 sf_f32_to_s32_sse2(ma_int32* pDst, const float* pSrc, const ma_uint64 count) {
+    const __m128 scale = _mm_set1_ps(2147483647.0f);
+    const __m128 lo = _mm_set1_ps(-2147483648.0f);
+    const __m128 hi = _mm_set1_ps(SF_S32_MAX_FLOAT);
+    ma_uint64 i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(pSrc + i), scale), lo), hi);
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm_cvtps_epi32(v));
+    }
+
+    return i;
+}
+
+SF_TARGET_SSE2 static ma_uint64 sf_s32_to_f32_sse2(float* pDst, const ma_int32* pSrc, const ma_uint64 count) {
+    const __m128 scale = _mm_set1_ps(1.0f / 2147483647.0f);
+    ma_uint64 i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(pSrc + i));
+        _mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+
+    return i;
+}
+
+SF_TARGET_AVX2 static __m256 sf_tpdf_avx2(__m256i* pState) {
+    const __m256i one = _mm256_set1_epi32(0x3f800000);
+    __m256 noise[2];
+    for (int n = 0; n < 2; ++n) {
+        __m256i x = *pState;
+        x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+        x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+        *pState = x;
+        noise[n] = _mm256_castsi256_ps(_mm256_or_si256(_mm256_srli_epi32(x, 9), one));
+    }
+    return _mm256_sub_ps(noise[0], noise[1]);
+}
+
+SF_TARGET_AVX2 static ma_uint64 sf_f32_to_s16_avx2(ma_int16* pDst, const float* pSrc, const ma_uint64 count, const ma_bool32 dither) {
+    const __m256 scale = _mm256_set1_ps(32767.0f);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    __m256i state = _mm256_loadu_si256((const __m256i*)g_dither_lanes);
+    ma_uint64 i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), scale);
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(pSrc + i + 8), scale);
+        if (dither) {
+            a = _mm256_add_ps(a, sf_tpdf_avx2(&state));
+            b = _mm256_add_ps(b, sf_tpdf_avx2(&state));
+        }
+        a = _mm256_min_ps(_mm256_max_ps(a, lo), hi);
+        b = _mm256_min_ps(_mm256_max_ps(b, lo), hi);
+        // packs works per 128-bit lane; the permute restores sample order across lanes.
+        const __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256((__m256i*)(pDst + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+
+    _mm256_storeu_si256((__m256i*)g_dither_lanes, state);
+    return i;
+}
+
+SF_TARGET_AVX2 static ma_uint64 sf_s16_to_f32_avx2(float* pDst, const ma_int16* pSrc, const ma_uint64 count) {
+    const __m256 scale = _mm256_set1_ps(1.0f / 32767.0f);
+    ma_uint64 i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(pSrc + i)));
+        _mm256_storeu_ps(pDst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+
+    return i;
+}
+#elif defined(SF_SIMD_NEON)
+static ma_uint32 sf_detect_simd(void) {
+    return SF_SIMD_NEON;
+}
+
+static float32x4_t sf_tpdf_neon(uint32x4_t* pState) {
+    const uint32x4_t one = vdupq_n_u32(0x3f800000);
+    float32x4_t noise[2];
+    for (int n = 0; n < 2; ++n) {
+        uint32x4_t x = *pState;
+        x = veorq_u32(x, vshlq_n_u32(x, 13));
+        x = veorq_u32(x, vshrq_n_u32(x, 17));
+        x = veorq_u32(x, vshlq_n_u32(x, 5));
+        *pState = x;
+        noise[n] = vreinterpretq_f32_u32(vorrq_u32(vshrq_n_u32(x, 9), one));
+    }
+    return vsubq_f32(noise[0], noise[1]);
+}
+
+static ma_uint64 sf_f32_to_s16_neon(ma_int16* pDst, const float* pSrc, const ma_uint64 count, const ma_bool32 dither) {
+    const float32x4_t scale = vdupq_n_f32(32767.0f);
+    const float32x4_t lo = vdupq_n_f32(-32768.0f);
+    const float32x4_t hi = vdupq_n_f32(32767.0f);
+    uint32x4_t state = vld1q_u32(g_dither_lanes);
+    ma_uint64 i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vmulq_f32(vld1q_f32(pSrc + i), scale);
+        float32x4_t b = vmulq_f32(vld1q_f32(pSrc + i + 4), scale);
+        if (dither) {
+            a = vaddq_f32(a, sf_tpdf_neon(&state));
+            b = vaddq_f32(b, sf_tpdf_neon(&state));
+        }
+        a = vminq_f32(vmaxq_f32(a, lo), hi);
+        b = vminq_f32(vmaxq_f32(b, lo), hi);
+        vst1q_s16(pDst + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b))));
+    }
+
+    vst1q_u32(g_dither_lanes, state);
+    return i;
+}
+
+static ma_uint64 sf_s16_to_f32_neon(float* pDst, const ma_int16* pSrc, const ma_uint64 count) {
+    const float32x4_t scale = vdupq_n_f32(1.0f / 32767.0f);
+    ma_uint64 i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t v = vld1q_s16(pSrc + i);
+        vst1q_f32(pDst + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(pDst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+
+    return i;
+}
+
+static ma_uint64 sf_f32_to_s32_neon(ma_int32* pDst, const float* pSrc, const ma_uint64 count) {
+    const float32x4_t scale = vdupq_n_f32(2147483647.0f);
+    const float32x4_t lo = vdupq_n_f32(-2147483648.0f);
+    const float32x4_t hi = vdupq_n_f32(SF_S32_MAX_FLOAT);
+    ma_uint64 i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t v = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(pSrc + i), scale), lo), hi);
+        vst1q_s32(pDst + i, vcvtnq_s32_f32(v));
+    }
+
+    return i;
+}
+
+static ma_uint64 sf_s32_to_f32_neon(float* pDst, const ma_int32* pSrc, const ma_uint64 count) {
+    const float32x4_t scale = vdupq_n_f32(1.0f / 2147483647.0f);
+    ma_uint64 i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(pDst + i, vmulq_f32(vcvtq_f32_s32(vld1q_s32(pSrc + i)), scale));
+    }
+
+    return i;
+}
+#else
+static ma_uint32 sf_detect_simd(void) {
+    return 0;
+}
+#endif
+
+// Detected once; a racing first call only repeats the detection.
+static atomic_uint g_simd_features = 0;
+static atomic_int g_simd_detected = 0;
+
+// Returns the SIMD instruction sets the conversion kernels use on this machine (SF_SIMD_* flags).
+MA_API ma_uint32 sf_get_simd_features(void) {
+    if (!atomic_load_explicit(&g_simd_detected, memory_order_acquire)) {
+        atomic_store_explicit(&g_simd_features, sf_detect_simd(), memory_order_relaxed);
+        atomic_store_explicit(&g_simd_detected, 1, memory_order_release);
+    }
+    return atomic_load_explicit(&g_simd_features, memory_order_relaxed);
+}
+
+// Converts interleaved f32 samples to a device format, clipping to full scale. With dither, TPDF noise of
+// +/-1 LSB is added before rounding to u8, s16 or s24.
+MA_API void sf_pcm_convert_from_f32(void* pDst, const ma_format dstFormat, const float* pSrc, const ma_uint64 sampleCount, const ma_bool32 dither) {
+    if (pDst == NULL || pSrc == NULL || sampleCount == 0) {
+        return;
+    }
+
+    if (dstFormat == ma_format_f32) {
+        if (pDst != (const void*)pSrc) {
+            memmove(pDst, pSrc, sampleCount * sizeof(float));
+        }
+        return;
+    }
+
+    if (dither) {
+        sf_dither_seed();
+    }
+
+    ma_uint64 done = 0;
+#if defined(SF_SIMD_X86) || defined(SF_SIMD_NEON)
+    const ma_uint32 features = sf_get_simd_features();
+    (void)features;
+    if (dstFormat == ma_format_s16) {
+#if defined(SF_SIMD_X86)
+        if (features & SF_SIMD_AVX2) {
+            done = sf_f32_to_s16_avx2((ma_int16*)pDst, pSrc, sampleCount, dither);
+        } else if (features & SF_SIMD_SSE2) {
+            done = sf_f32_to_s16_sse2((ma_int16*)pDst, pSrc, sampleCount, dither);
+        }
+#else
+        done = sf_f32_to_s16_neon((ma_int16*)pDst, pSrc, sampleCount, dither);
+#endif
+    } else if (dstFormat == ma_format_s32) {
+#if defined(SF_SIMD_X86)
+        if (features & SF_SIMD_SSE2) {
+            done = sf_f32_to_s32_sse2((ma_int32*)pDst, pSrc, sampleCount);
+        }
+#else
+        done = sf_f32_to_s32_neon((ma_int32*)pDst, pSrc, sampleCount);
+#endif
+    }
+#endif
+
+    sf_f32_to_pcm_scalar(pDst, dstFormat, pSrc, done, sampleCount, dither);
+}
+
+// Converts interleaved samples in a device format to f32.
+MA_API void sf_pcm_convert_to_f32(float* pDst, const void* pSrc, const ma_format srcFormat, const ma_uint64 sampleCount) {
+    if (pDst == NULL || pSrc == NULL || sampleCount == 0) {
+        return;
+    }
+
+    if (srcFormat == ma_format_f32) {
+        if ((const void*)pDst != pSrc) {
+            memmove(pDst, pSrc, sampleCount * sizeof(float));
+        }
+        return;
+    }
+
+    ma_uint64 done = 0;
+#if defined(SF_SIMD_X86) || defined(SF_SIMD_NEON)
+    const ma_uint32 features = sf_get_simd_features();
+    (void)features;
+    if (srcFormat == ma_format_s16) {
+#if defined(SF_SIMD_X86)
+        if (features & SF_SIMD_AVX2) {
+            done = sf_s16_to_f32_avx2(pDst, (const ma_int16*)pSrc, sampleCount);
+        } else if (features & SF_SIMD_SSE2) {
+            done = sf_s16_to_f32_sse2(pDst, (const ma_int16*)pSrc, sampleCount);
+        }
+#else
+        done = sf_s16_to_f32_neon(pDst, (const ma_int16*)pSrc, sampleCount);
+#endif
+    } else if (srcFormat == ma_format_s32) {
+#if defined(SF_SIMD_X86)
+        if (features & SF_SIMD_SSE2) {
+            done = sf_s32_to_f32_sse2(pDst, (const ma_int32*)pSrc, sampleCount);
+        }
+#else
+        done = sf_s32_to_f32_neon(pDst, (const ma_int32*)pSrc, sampleCount);
+#endif
+    }
+#endif
+
+    sf_pcm_to_f32_scalar(pDst, pSrc, srcFormat, done, sampleCount);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Virtual Devices
+// ---------------------------------------------------------------------------------------------------------------------
+
+// A registered virtual device. The registry is process-wide, so every context using the virtual backend sees it.
+struct sf_virtual_endpoint {
+    ma_int32 id;                        // Stored in ma_device_id.custom.i.
+    ma_device_type type;
+    char name[MA_MAX_DEVICE_NAME_LENGTH + 1];
+    char* pFilePath;                    // Capture source or playback sink. NULL discards playback.
+    float rateMultiple;                 // 1 runs at real time, 0 as fast as possible.
+    ma_format nativeFormat;             // A capture source's format, read once at registration; unset for playback.
+    ma_uint32 nativeChannels;
+    ma_uint32 nativeSampleRate;
+    ma_bool32 hasNativeFormat;
+    struct sf_virtual_endpoint* pNext;
+};
+
+// The backend data of an open virtual device, owned through the device's sf_device_state.
+struct sf_virtual_stream {
+    ma_device_type type;
+    ma_decoder decoder;                 // Capture source.
+    ma_encoder encoder;                 // Playback sink.
+    ma_bool32 hasEncoder;
+    void* pBuffer;                      // One period in the backend format.
+    ma_format format;
+    ma_uint32 channels;
+    ma_uint32 sampleRate;
+    ma_uint32 periodInFrames;
+    float rateMultiple;
+};
+
+static ma_spinlock g_virtual_lock = 0;
+static struct sf_virtual_endpoint* g_virtual_endpoints = NULL;
+static ma_int32 g_virtual_next_id = 1;
+
+// Finds an endpoint by id, or the first of the given type for a NULL id. Call with g_virtual_lock held.
+static struct sf_virtual_endpoint* sf_virtual_find(const ma_device_type type, const ma_device_id* pDeviceID) {
+    for (struct sf_virtual_endpoint* pEndpoint = g_virtual_endpoints; pEndpoint != NULL; pEndpoint = pEndpoint->pNext) {
+        if (pEndpoint->type == type && (pDeviceID == NULL || pDeviceID->custom.i == pEndpoint->id)) {
+            return pEndpoint;
+        }
+    }
+    return NULL;
+}
+
+static void sf_virtual_fill_info(const struct sf_virtual_endpoint* pEndpoint, ma_device_info* pInfo) {
+    memset(pInfo, 0, sizeof(*pInfo));
+    pInfo->id.custom.i = pEndpoint->id;
+    sf_safe_strcpy(pInfo->name, pEndpoint->name);
+    pInfo->isDefault = sf_virtual_find(pEndpoint->type, NULL) == pEndpoint;
+
+    // A capture device's native format is its source file's; playback devices take whatever they are given.
+    if (pEndpoint->hasNativeFormat) {
+        pInfo->nativeDataFormatCount = 1;
+        pInfo->nativeDataFormats[0].format = pEndpoint->nativeFormat;
+        pInfo->nativeDataFormats[0].channels = pEndpoint->nativeChannels;
+        pInfo->nativeDataFormats[0].sampleRate = pEndpoint->nativeSampleRate;
+        pInfo->nativeDataFormats[0].flags = 0;
+    }
+}
+
+static ma_result sf_virtual_context_uninit(ma_context* pContext) {
+    (void)pContext;
+    return MA_SUCCESS;
+}
+
+static ma_result sf_virtual_enumerate_devices(ma_context* pContext, const ma_enum_devices_callback_proc callback, void* pUserData) {
+    ma_spinlock_lock(&g_virtual_lock);
+    for (const struct sf_virtual_endpoint* pEndpoint = g_virtual_endpoints; pEndpoint != NULL; pEndpoint = pEndpoint->pNext) {
+        ma_device_info info;
+        sf_virtual_fill_info(pEndpoint, &info);
+        if (!callback(pContext, pEndpoint->type, &info, pUserData)) {
+            break;
+        }
+    }
+    ma_spinlock_unlock(&g_virtual_lock);
+    return MA_SUCCESS;
+}
+
+static ma_result sf_virtual_get_device_info(ma_context* pContext, const ma_device_type deviceType, const ma_device_id* pDeviceID,
+                                            ma_device_info* pDeviceInfo) {
+    (void)pContext;
+
+    ma_spinlock_lock(&g_virtual_lock);
+    const struct sf_virtual_endpoint* pEndpoint = sf_virtual_find(deviceType, pDeviceID);
+    if (pEndpoint != NULL) {
+        sf_virtual_fill_info(pEndpoint, pDeviceInfo);
+    }
+    ma_spinlock_unlock(&g_virtual_lock);
+
+    return pEndpoint != NULL ? MA_SUCCESS : MA_NO_DEVICE;
+}
+
+static void sf_virtual_stream_free(struct sf_virtual_stream* pStream) {
+    if (pStream->type == ma_device_type_capture) {
+        ma_decoder_uninit(&pStream->decoder);
+    } else if (pStream->hasEncoder) {
+        ma_encoder_uninit(&pStream->encoder);
+    }
+    ma_free(pStream->pBuffer, NULL);
+    ma_free(pStream, NULL);
+}
+
+static ma_result sf_virtual_device_init(ma_device* pDevice, const ma_device_config* pConfig, ma_device_descriptor* pDescriptorPlayback,
+                                        ma_device_descriptor* pDescriptorCapture) {
+    // Virtual devices are single-direction, and keep their backend data in the facade's per-device state.
+    struct sf_device_state* pState = (struct sf_device_state*)pDevice->pUserData;
+    if (pConfig->deviceType != ma_device_type_playback && pConfig->deviceType != ma_device_type_capture) {
+        return MA_DEVICE_TYPE_NOT_SUPPORTED;
+    }
+    if (pState == NULL) {
+        return MA_INVALID_OPERATION;
+    }
+
+    const ma_device_type type = pConfig->deviceType;
+    ma_device_descriptor* pDescriptor = type == ma_device_type_capture ? pDescriptorCapture : pDescriptorPlayback;
+
+    struct sf_virtual_stream* pStream = sf_create(struct sf_virtual_stream);
+    if (pStream == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+    memset(pStream, 0, sizeof(*pStream));
+    pStream->type = type;
+
+    char* pFilePath = NULL;
+    ma_spinlock_lock(&g_virtual_lock);
+    const struct sf_virtual_endpoint* pEndpoint = sf_virtual_find(type, pDescriptor->pDeviceID);
+    if (pEndpoint != NULL) {
+        pStream->rateMultiple = pEndpoint->rateMultiple;
+        if (pEndpoint->pFilePath != NULL) {
+            const size_t length = strlen(pEndpoint->pFilePath);
+            pFilePath = (char*)ma_malloc(length + 1, NULL);
+            if (pFilePath != NULL) {
+                memcpy(pFilePath, pEndpoint->pFilePath, length + 1);
+            }
+        }
+    }
+    ma_spinlock_unlock(&g_virtual_lock);
+
+    if (pEndpoint == NULL) {
+        ma_free(pStream, NULL);
+        return MA_NO_DEVICE;
+    }
+
+    ma_result result = MA_SUCCESS;
+    if (type == ma_device_type_capture) {
+        // The decoder converts the file to the requested format; unset fields keep the file's own.
+        const ma_decoder_config decoderConfig = ma_decoder_config_init(pDescriptor->format, pDescriptor->channels, pDescriptor->sampleRate);
+        result = pFilePath != NULL ? ma_decoder_init_file(pFilePath, &decoderConfig, &pStream->decoder) : MA_INVALID_FILE;
+        if (result == MA_SUCCESS) {
+            pDescriptor->format = pStream->decoder.outputFormat;
+            pDescriptor->channels = pStream->decoder.outputChannels;
+            pDescriptor->sampleRate = pStream->decoder.outputSampleRate;
+        }
+    } else {
+        pDescriptor->format = pDescriptor->format != ma_format_unknown ? pDescriptor->format : ma_format_f32;
+        pDescriptor->channels = pDescriptor->channels != 0 ? pDescriptor->channels : 2;
+        pDescriptor->sampleRate = pDescriptor->sampleRate != 0 ? pDescriptor->sampleRate : 48000;
+        if (pFilePath != NULL) {
+            const ma_encoder_config encoderConfig = ma_encoder_config_init(ma_encoding_format_wav, pDescriptor->format,
+                                                                           pDescriptor->channels, pDescriptor->sampleRate);
+            result = ma_encoder_init_file(pFilePath, &encoderConfig, &pStream->encoder);
+            pStream->hasEncoder = result == MA_SUCCESS;
+        }
+    }
+    ma_free(pFilePath, NULL);
+
+    if (result != MA_SUCCESS) {
+        ma_free(pStream, NULL);
+        return result;
+    }
+
+    ma_channel_map_init_standard(ma_standard_channel_map_default, pDescriptor->channelMap, MA_MAX_CHANNELS, pDescriptor->channels);
+    pDescriptor->periodSizeInFrames = ma_calculate_buffer_size_in_frames_from_descriptor(pDescriptor, pDescriptor->sampleRate, pConfig->performanceProfile);
+    pDescriptor->periodCount = pDescriptor->periodCount != 0 ? pDescriptor->periodCount : 2;
+
+    pStream->format = pDescriptor->format;
+    pStream->channels = pDescriptor->channels;
+    pStream->sampleRate = pDescriptor->sampleRate;
+    pStream->periodInFrames = pDescriptor->periodSizeInFrames;
+    pStream->pBuffer = ma_malloc((size_t)pStream->periodInFrames * ma_get_bytes_per_frame(pStream->format, pStream->channels), NULL);
+    if (pStream->pBuffer == NULL) {
+        sf_virtual_stream_free(pStream);
+        return MA_OUT_OF_MEMORY;
+    }
+
+    pState->pVirtual = pStream;
+    return MA_SUCCESS;
+}
+
+static ma_result sf_virtual_device_uninit(ma_device* pDevice) {
+    struct sf_device_state* pState = (struct sf_device_state*)pDevice->pUserData;
+    if (pState != NULL && pState->pVirtual != NULL) {
+        sf_virtual_stream_free(pState->pVirtual);
+        pState->pVirtual = NULL;
+    }
+    return MA_SUCCESS;
+}
+
+static ma_result sf_virtual_device_start(ma_device* pDevice) {
+    (void)pDevice;
+    return MA_SUCCESS;
+}
+
+static ma_result sf_virtual_device_stop(ma_device* pDevice) {
+    (void)pDevice;
+    return MA_SUCCESS;
+}
+
+// Fills a capture period from the source file, looping at its end so the stream never runs dry.
+static void sf_virtual_read_source(struct sf_virtual_stream* pStream) {
+    ma_uint64 done = 0;
+    ma_bool32 rewound = MA_FALSE;
+    while (done < pStream->periodInFrames) {
+        void* pFrames = ma_offset_pcm_frames_ptr(pStream->pBuffer, done, pStream->format, pStream->channels);
+        ma_uint64 framesRead = 0;
+        ma_decoder_read_pcm_frames(&pStream->decoder, pFrames, pStream->periodInFrames - done, &framesRead);
+        done += framesRead;
+        if (framesRead == 0) {
+            // An empty file rewinds to nothing, so give up and pad with silence.
+            if (rewound || ma_decoder_seek_to_pcm_frame(&pStream->decoder, 0) != MA_SUCCESS) {
+                ma_silence_pcm_frames(pFrames, pStream->periodInFrames - done, pStream->format, pStream->channels);
+                return;
+            }
+            rewound = MA_TRUE;
+        } else {
+            rewound = MA_FALSE;
+        }
+    }
+}
+
+// The device thread: moves one period at a time and sleeps until the next is due at the configured rate.
+static ma_result sf_virtual_device_data_loop(ma_device* pDevice) {
+    struct sf_virtual_stream* pStream = ((struct sf_device_state*)pDevice->pUserData)->pVirtual;
+    const ma_uint64 periodNs = (ma_uint64)pStream->periodInFrames * 1000000000 / pStream->sampleRate;
+    const ma_uint64 intervalNs = pStream->rateMultiple > 0 ? (ma_uint64)((double)periodNs / pStream->rateMultiple) : 0;
+    ma_uint64 deadlineNs = sf_time_ns();
+
+    while (ma_device_get_state(pDevice) == ma_device_state_started) {
+        if (pStream->type == ma_device_type_capture) {
+            sf_virtual_read_source(pStream);
+            ma_device_handle_backend_data_callback(pDevice, NULL, pStream->pBuffer, pStream->periodInFrames);
+        } else {
+            ma_silence_pcm_frames(pStream->pBuffer, pStream->periodInFrames, pStream->format, pStream->channels);
+            ma_device_handle_backend_data_callback(pDevice, pStream->pBuffer, NULL, pStream->periodInFrames);
+            if (pStream->hasEncoder) {
+                ma_encoder_write_pcm_frames(&pStream->encoder, pStream->pBuffer, pStream->periodInFrames, NULL);
+            }
+        }
+
+        if (intervalNs == 0) {
+            continue;
+        }
+
+        // Sleep in short steps so a stop request is noticed promptly. A stream that falls well behind resynchronises
+        // rather than bursting to catch up.
+        deadlineNs += intervalNs;
+        ma_uint64 nowNs = sf_time_ns();
+        if (nowNs > deadlineNs + intervalNs * 4) {
+            deadlineNs = nowNs;
+        }
+        while (nowNs < deadlineNs && ma_device_get_state(pDevice) == ma_device_state_started) {
+            const ma_uint64 remainingNs = deadlineNs - nowNs;
+            sf_sleep_ns(remainingNs < 10000000 ? remainingNs : 10000000);
+            nowNs = sf_time_ns();
+        }
+    }
+    return MA_SUCCESS;
+}
+
+static ma_result sf_virtual_device_data_loop_wakeup(ma_device* pDevice) {
+    // The data loop polls the device state between short sleeps.
+    (void)pDevice;
+    return MA_SUCCESS;
+}
+
+static ma_result sf_virtual_context_init(ma_context* pContext, const ma_context_config* pConfig, ma_backend_callbacks* pCallbacks) {
+    (void)pContext;
+    (void)pConfig;
+
+    pCallbacks->onContextInit = sf_virtual_context_init;
+    pCallbacks->onContextUninit = sf_virtual_context_uninit;
+    pCallbacks->onContextEnumerateDevices = sf_virtual_enumerate_devices;
+    pCallbacks->onContextGetDeviceInfo = sf_virtual_get_device_info;
+    pCallbacks->onDeviceInit = sf_virtual_device_init;
+    pCallbacks->onDeviceUninit = sf_virtual_device_uninit;
+    pCallbacks->onDeviceStart = sf_virtual_device_start;
+    pCallbacks->onDeviceStop = sf_virtual_device_stop;
+    pCallbacks->onDeviceRead = NULL;
+    pCallbacks->onDeviceWrite = NULL;
+    pCallbacks->onDeviceDataLoop = sf_virtual_device_data_loop;
+    pCallbacks->onDeviceDataLoopWakeup = sf_virtual_device_data_loop_wakeup;
+    pCallbacks->onDeviceGetInfo = NULL;
+    return MA_SUCCESS;
+}
+
+// Registers a virtual device. Capture devices stream pFilePath (any format ma_decoder reads) in a loop; playback devices
+// write a WAV file to it, or discard their output when it is NULL. rateMultiple scales real time; 0 runs unthrottled.
+MA_API ma_result sf_virtual_device_add(const ma_device_type type, const char* pName, const char* pFilePath, const float rateMultiple,
+                                       ma_int32* pId) {
+    if (pName == NULL || pId == NULL || rateMultiple < 0 || (type != ma_device_type_playback && type != ma_device_type_capture)) {
+        return MA_INVALID_ARGS;
+    }
+    if (type == ma_device_type_capture && pFilePath == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+    struct sf_virtual_endpoint* pEndpoint = sf_create(struct sf_virtual_endpoint);
+    if (pEndpoint == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+    memset(pEndpoint, 0, sizeof(*pEndpoint));
+    if (pFilePath != NULL) {
+        const size_t length = strlen(pFilePath);
+        pEndpoint->pFilePath = (char*)ma_malloc(length + 1, NULL);
+        if (pEndpoint->pFilePath == NULL) {
+            ma_free(pEndpoint, NULL);
+            return MA_OUT_OF_MEMORY;
+        }
+        memcpy(pEndpoint->pFilePath, pFilePath, length + 1);
+    }
+    pEndpoint->type = type;
+    pEndpoint->rateMultiple = rateMultiple;
+    sf_safe_strcpy(pEndpoint->name, pName);
+
+    // Device info is queried far more often than devices are registered, so the source is only opened here. A source
+    // that cannot be read yet reports no native format; opening the device reports the error.
+    if (type == ma_device_type_capture) {
+        ma_decoder decoder;
+        const ma_decoder_config decoderConfig = ma_decoder_config_init(ma_format_unknown, 0, 0);
+        if (ma_decoder_init_file(pFilePath, &decoderConfig, &decoder) == MA_SUCCESS) {
+            pEndpoint->nativeFormat = decoder.outputFormat;
+            pEndpoint->nativeChannels = decoder.outputChannels;
+            pEndpoint->nativeSampleRate = decoder.outputSampleRate;
+            pEndpoint->hasNativeFormat = MA_TRUE;
+            ma_decoder_uninit(&decoder);
+        }
+    }
+
+    // Append, so the first device registered of each type stays the default.
+    ma_spinlock_lock(&g_virtual_lock);
+    pEndpoint->id = g_virtual_next_id++;
+    struct sf_virtual_endpoint** ppLink = &g_virtual_endpoints;
+    while (*ppLink != NULL) {
+        ppLink = &(*ppLink)->pNext;
+    }
+    *ppLink = pEndpoint;
+    ma_spinlock_unlock(&g_virtual_lock);
+
+    *pId = pEndpoint->id;
+    return MA_SUCCESS;
+}
+
+// Unregisters a virtual device. Devices already open on it keep running.
+MA_API ma_result sf_virtual_device_remove(const ma_int32 id) {
+    struct sf_virtual_endpoint* pRemoved = NULL;
+
+    ma_spinlock_lock(&g_virtual_lock);
+    for (struct sf_virtual_endpoint** ppLink = &g_virtual_endpoints; *ppLink != NULL; ppLink = &(*ppLink)->pNext) {
+        if ((*ppLink)->id == id) {
+            pRemoved = *ppLink;
+            *ppLink = pRemoved->pNext;
+            break;
+        }
+    }
+    ma_spinlock_unlock(&g_virtual_lock);
+
+    if (pRemoved == NULL) {
+        return MA_DOES_NOT_EXIST;
+    }
+    ma_free(pRemoved->pFilePath, NULL);
+    ma_free(pRemoved, NULL);
+    return MA_SUCCESS;
+}
@@ -69,6 +69,58 @@ struct sf_DeviceSubConfig {
     ma_share_mode shareMode;
 };
 
+// Context-level backend options, applied by sf_context_init.
+struct sf_AlsaContextConfig {
+    ma_bool32 useVerboseDeviceEnumeration;
+};
+
+struct sf_PulseContextConfig {
+    const char *pApplicationName;
+    const char *pServerName;
+    ma_bool32 tryAutoSpawn;
+};
+
+struct sf_JackContextConfig {
+    const char *pClientName;
+    ma_bool32 tryStartServer;
+};
+
+struct sf_CoreAudioContextConfig {
+    ma_ios_session_category sessionCategory;
+    ma_uint32 sessionCategoryOptions;
+    ma_bool32 noAudioSessionActivate;
+    ma_bool32 noAudioSessionDeactivate;
+};
+
+// The context config DTO that C# will marshal. Zero fields keep miniaudio's defaults.
+struct sf_ContextConfig {
+    ma_thread_priority threadPriority; // Priority of the device threads miniaudio creates.
+    size_t threadStackSize;
+    ma_uint64 cpuAffinityMask;         // Bit n allows device threads on CPU n; 0 leaves them unpinned. Windows and desktop Linux only.
+
+    struct sf_AlsaContextConfig *alsa;
+    struct sf_PulseContextConfig *pulse;
+    struct sf_JackContextConfig *jack;
+    struct sf_CoreAudioContextConfig *coreaudio;
+};
+
+// Offline rendering: sf_device_init creates the device on a private null-backend context that nothing drives in
+// real time. sf_device_start pumps the data callback as fast as it runs, and sf_device_render pumps it on demand.
+struct sf_OfflineConfig {
+    const char *pOutputPath; // Optional WAV file the playback output is written to; NULL discards it.
+};
+
+// Period auto-tuning: the device starts at minPeriodSizeInFrames and a monitor thread doubles the period, reinitialising
+// the device in place, whenever a window sees more deadline misses and xruns than allowed. The period is never shrunk
+// again, however long the device then runs clean. Zero fields take defaults.
+struct sf_AutoTuneConfig {
+    ma_uint32 minPeriodSizeInFrames; // The period tried first. Default 64.
+    ma_uint32 maxPeriodSizeInFrames; // The largest period tried. Default 4096.
+    ma_uint32 windowMilliseconds;    // How long each observation lasts. Default 1000.
+    ma_uint32 stableWindows;         // Clean windows in a row before the period counts as converged. Default 5.
+    ma_uint32 maxGlitchesPerWindow;  // Overruns, underruns and late callbacks tolerated per window.
+};
+
 // The main config DTO that C# will marshal
 struct sf_DeviceConfig {
     ma_uint32 periodSizeInFrames;
@@ -88,6 +140,87 @@ struct sf_DeviceConfig {
     struct sf_PulseConfig *pulse;
     struct sf_OpenSlConfig *opensl;
     struct sf_AAudioConfig *aaudio;
+
+    ma_uint32 renderAheadPeriods; // Playback only. When non-zero, the callback plays from a ring kept this many periods ahead.
+    struct sf_OfflineConfig *offline; // When set, the device renders offline instead of opening hardware.
+    struct sf_AutoTuneConfig *autoTune; // When set, the period is tuned at runtime. Replaces render-ahead; ignored offline.
+};
+
+#define SF_PERF_HISTOGRAM_BINS 16
+
+// Data callback performance reported by sf_device_get_perf_stats. Durations are in nanoseconds; loads are
+// callback duration over the period budget (the audio time the callback covers), so 1.0 is a missed deadline.
+struct sf_PerfStats {
+    ma_uint64 callbackCount;
+    ma_uint64 budgetNs;          // Budget of the last callback.
+    ma_uint64 lastDurationNs;
+    ma_uint64 minDurationNs;
+    ma_uint64 avgDurationNs;
+    ma_uint64 maxDurationNs;
+    ma_uint64 lastIntervalNs;    // Time between the last two callback starts.
+    ma_uint64 avgJitterNs;       // Mean deviation of the callback interval from the budget.
+    ma_uint64 maxJitterNs;
+    ma_uint64 overrunCount;      // Callbacks that took longer than their budget.
+    ma_uint64 underrunCount;     // Render-ahead callbacks that found the ring short.
+    ma_uint64 lateCallbackCount; // Callbacks arriving more than two periods after the previous one.
+    float dspLoad;               // Smoothed load of recent callbacks.
+    float averageDspLoad;        // Total callback time over total budget.
+    float peakDspLoad;
+    ma_uint32 histogram[SF_PERF_HISTOGRAM_BINS]; // Callbacks by load, in 10% steps; the last bin holds 150% and over.
+};
+
+// Device clock and latency reported by sf_device_get_timing. Frame counts are at the client sample rate; the
+// period size is as negotiated with the backend, at the internal rate.
+struct sf_DeviceTiming {
+    ma_uint64 framesRendered;            // Frames the callback has processed in total.
+    ma_uint64 lastCallbackFramePosition; // Frames processed before the last callback started.
+    ma_uint64 lastCallbackTimestampNs;   // Monotonic start time of the last callback, 0 before the first.
+    ma_uint64 timestampNs;               // Monotonic time the timing was read, see sf_get_time_ns.
+    ma_uint32 lastCallbackFrameCount;
+    ma_uint32 sampleRate;
+    ma_uint32 internalSampleRate;
+    ma_uint32 periodSizeInFrames;
+    ma_uint32 periods;
+    ma_uint32 periodLatencyFrames;       // One period.
+    ma_uint32 internalLatencyFrames;     // The whole device buffer (period size times periods).
+    ma_uint32 renderAheadFrames;         // Render-ahead ring capacity, 0 when disabled.
+};
+
+// The state of a device's period auto-tuner, reported by sf_device_get_autotune_status.
+struct sf_AutoTuneStatus {
+    ma_uint32 periodSizeInFrames;    // The period currently requested from the backend.
+    ma_uint32 periods;               // The period count the backend chose.
+    ma_uint32 stableWindows;         // Clean windows in a row at the current period.
+    ma_uint32 reinitCount;           // How many times the device was reinitialised with a larger period.
+    ma_bool32 converged;             // The current period has held for sf_AutoTuneConfig.stableWindows windows.
+    ma_bool32 atMaximum;             // The period reached maxPeriodSizeInFrames and will not grow further.
+    ma_result lastResult;            // The result of the last reinitialisation; tuning stops if it failed.
+};
+
+// Passed to every sf_device_data_proc call.
+struct sf_CallbackInfo {
+    ma_uint64 framePosition;     // Frames the device processed before this callback.
+    ma_uint64 timestampNs;       // Monotonic time the callback started, see sf_get_time_ns.
+};
+
+typedef void (*sf_device_data_proc)(void *pUserData, void *pOutput, const void *pInput, ma_uint32 frameCount,
+                                    const struct sf_CallbackInfo *pInfo);
+
+typedef void (*sf_device_notification_proc)(void *pUserData, ma_device_notification_type type);
+
+// Per-device callback table. Any entry may be NULL.
+struct sf_DeviceCallbacks {
+    sf_device_data_proc onData;
+    sf_device_notification_proc onNotification;
+};
+
+// Render-ahead ring state reported by sf_device_ring_get_stats.
+struct sf_RingStats {
+    ma_uint32 capacityInFrames;
+    ma_uint32 availableFrames;   // Frames queued and not yet played.
+    ma_uint32 periodSizeInFrames;
+    ma_uint64 underrunCount;     // Callbacks that found the ring short.
+    ma_uint64 underrunFrames;    // Frames replaced with silence across those callbacks.
 };
 
 // Frees a structure allocated with sf_create().
@@ -99,7 +232,7 @@ MA_API ma_decoder *sf_allocate_decoder(void);
 // Allocate memory for an encoder struct.
 MA_API ma_encoder *sf_allocate_encoder(void);
 
-// Allocate memory for a device struct.
+// Allocate memory for a device struct. Devices passed to sf_device_init must be allocated here.
 MA_API ma_device *sf_allocate_device(void);
 
 // Allocate memory for a context struct.
@@ -123,8 +256,110 @@ MA_API ma_result sf_get_devices(ma_context *context, struct sf_device_info **ppP
 
 MA_API void sf_free_device_infos(struct sf_device_info* deviceInfos, ma_uint32 count);
 
+// Initializes a context with the options in pSfConfig, which may be NULL. Installs the virtual device backend as
+// ma_backend_custom when pBackends lists it. Contexts initialized here must be uninitialized with sf_context_uninit.
+MA_API ma_result sf_context_init(const ma_backend *pBackends, ma_uint32 backendCount, const struct sf_ContextConfig *pSfConfig,
+                                 ma_context *pContext);
+
+MA_API ma_result sf_context_uninit(ma_context *pContext);
+
 MA_API ma_backend sf_context_get_backend(const ma_context* pContext);
 
+// Routes the device's callbacks through a function table called with pUserData, instead of the onData passed to
+// sf_allocate_device_config. Must be called before sf_device_init.
+MA_API ma_result sf_device_config_set_callbacks(ma_device_config *pConfig, const struct sf_DeviceCallbacks *pCallbacks,
+                                                void *pUserData);
+
+// Returns the monotonic clock used for callback timestamps, in nanoseconds.
+MA_API ma_uint64 sf_get_time_ns(void);
+
+// Initializes a device from a config allocated with sf_allocate_device_config, taking ownership of its per-device state.
+MA_API ma_result sf_device_init(ma_context *pContext, const ma_device_config *pConfig, ma_device *pDevice);
+
+// Uninitializes a device created with sf_device_init.
+MA_API void sf_device_uninit(ma_device *pDevice);
+
+// Starts or stops a device created with sf_device_init. Offline devices start a thread that renders back to back.
+MA_API ma_result sf_device_start(ma_device *pDevice);
+
+MA_API ma_result sf_device_stop(ma_device *pDevice);
+
+// Renders frameCount frames on the calling thread. Offline devices only, and only while stopped. pOutput may be NULL;
+// otherwise it receives the playback output in the device format.
+MA_API ma_result sf_device_render(ma_device *pDevice, ma_uint64 frameCount, void *pOutput);
+
+MA_API ma_bool32 sf_device_is_offline(const ma_device *pDevice);
+
+// Render-ahead ring: the device callback only copies from a lock-free ring that a render thread keeps filled
+// (see sf_DeviceConfig.renderAheadPeriods). The ring holds frames in the device's playback format.
+MA_API ma_uint32 sf_device_ring_write(ma_device *pDevice, const void *pFrames, ma_uint32 frameCount);
+
+MA_API ma_uint32 sf_device_ring_available_write(ma_device *pDevice);
+
+MA_API ma_result sf_device_ring_wait(ma_device *pDevice);
+
+MA_API void sf_device_ring_wake(ma_device *pDevice);
+
+// Discards the queued frames. Only while the device is stopped and no render thread is writing.
+MA_API void sf_device_ring_reset(ma_device *pDevice);
+
+MA_API ma_result sf_device_ring_get_stats(ma_device *pDevice, struct sf_RingStats *pStats);
+
+// Copies the latest data callback performance snapshot. Lock-free; callable from any thread.
+MA_API ma_result sf_device_get_perf_stats(ma_device *pDevice, struct sf_PerfStats *pStats);
+
+// Reads the device's clock and negotiated period layout. Lock-free; callable from any thread, and does not wait for an
+// auto-tuning reinitialisation.
+MA_API ma_result sf_device_get_timing(ma_device *pDevice, struct sf_DeviceTiming *pTiming);
+
+// Reads the auto-tuner state of a device configured with sf_DeviceConfig.autoTune.
+MA_API ma_result sf_device_get_autotune_status(ma_device *pDevice, struct sf_AutoTuneStatus *pStatus);
+
+// Clears the performance counters at the device's next callback.
+MA_API void sf_device_reset_perf_stats(ma_device *pDevice);
+
+// Device cache: enumerates once, refreshes on a background thread and serves the device list without
+// blocking. Snapshot device ids stay valid, and stable across refreshes, for the lifetime of the cache.
+struct sf_device_cache;
+struct sf_device_snapshot;
+
+typedef void (*sf_device_cache_proc)(void *pUserData, ma_device_type type, const struct sf_device_info *pInfo, ma_bool32 added);
+
+MA_API struct sf_device_cache *sf_device_cache_create(ma_context *pContext, ma_uint32 refreshIntervalMs);
+
+MA_API void sf_device_cache_destroy(struct sf_device_cache *pCache);
+
+MA_API ma_result sf_device_cache_refresh(struct sf_device_cache *pCache);
+
+MA_API void sf_device_cache_invalidate(struct sf_device_cache *pCache);
+
+MA_API void sf_device_cache_set_callback(struct sf_device_cache *pCache, sf_device_cache_proc onChange, void *pUserData);
+
+MA_API struct sf_device_snapshot *sf_device_cache_acquire(struct sf_device_cache *pCache, struct sf_device_info **ppPlaybackDeviceInfos,
+                                                          struct sf_device_info **ppCaptureDeviceInfos, ma_uint32 *pPlaybackDeviceCount,
+                                                          ma_uint32 *pCaptureDeviceCount, ma_uint64 *pGeneration);
+
+MA_API void sf_device_cache_release(struct sf_device_snapshot *pSnapshot);
+
+// Sample conversion between f32 and the device formats, with SIMD kernels selected at runtime.
+#define SF_SIMD_SSE2 0x1
+#define SF_SIMD_AVX2 0x2
+#define SF_SIMD_NEON 0x4
+
+MA_API ma_uint32 sf_get_simd_features(void);
+
+MA_API void sf_pcm_convert_from_f32(void *pDst, ma_format dstFormat, const float *pSrc, ma_uint64 sampleCount, ma_bool32 dither);
+
+MA_API void sf_pcm_convert_to_f32(float *pDst, const void *pSrc, ma_format srcFormat, ma_uint64 sampleCount);
+
+// Virtual devices, served by the backend sf_context_init installs when ma_backend_custom is requested. Capture devices
+// loop a file, playback devices write a WAV file or discard their output, at a multiple of real time. A capture
+// source's format is read once, when it is added, and reported as the device's native format from then on.
+MA_API ma_result sf_virtual_device_add(ma_device_type type, const char *pName, const char *pFilePath, float rateMultiple,
+                                       ma_int32 *pId);
+
+MA_API ma_result sf_virtual_device_remove(ma_int32 id);
+
 #ifdef __cplusplus
 }
 #endif
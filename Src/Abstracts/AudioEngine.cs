@@ -93,6 +93,7 @@ public abstract class AudioEngine : IDisposable
     /// <summary>
     /// Occurs after a block of audio has been prepared for rendering by a playback device.
     /// This event provides a sample-accurate clock tick for driving master synchronization (e.g., MIDI Clock).
+    /// Devices that render ahead of the hardware raise it when a block is mixed, which can precede playback.
     /// </summary>
     public event EventHandler<AudioFramesRenderedEventArgs>? AudioFramesRendered;
 
@@ -19,6 +19,11 @@ internal sealed class MiniAudioCaptureDevice : AudioCaptureDevice
         Capability = _device.Capability;
     }
 
+    /// <summary>
+    /// Gets the underlying MiniAudio device.
+    /// </summary>
+    internal MiniAudioDevice Device => _device;
+
     public override void Start()
     {
         _device.Start();
@@ -65,7 +70,7 @@ internal sealed class MiniAudioCaptureDevice : AudioCaptureDevice
             var floatSpan = tempBuffer.AsSpan(0, length);
 
             // 1. Convert from the device's native format into our temporary float buffer.
-            DeviceBufferHelper.ConvertFromDeviceFormat(pInput, floatSpan, length, device.Format.Format);
+            device.ConvertFromDeviceFormat(pInput, floatSpan);
 
             // 2. Invoke the event with the correctly converted sample data.
             InvokeOnAudioProcessed(floatSpan);
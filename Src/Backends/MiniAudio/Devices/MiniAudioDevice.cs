@@ -1,19 +1,32 @@
+using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 using SoundFlow.Abstracts.Devices;
 using SoundFlow.Backends.MiniAudio.Enums;
 using SoundFlow.Backends.MiniAudio.Structs;
 using SoundFlow.Enums;
 using SoundFlow.Structs;
+using SoundFlow.Utils;
 
 namespace SoundFlow.Backends.MiniAudio.Devices;
 
 internal delegate void OnProcessCallback(nint pOutput, nint pInput, uint frameCount, MiniAudioDevice device);
 
-internal sealed class MiniAudioDevice : IDisposable
+internal sealed unsafe class MiniAudioDevice : IDisposable
 {
     private readonly nint _device;
     private readonly OnProcessCallback _onProcess;
 
+    // Passed to the native callback table as the per-device context, so callbacks resolve this instance directly.
+    private GCHandle _handle;
+
+    // Render-ahead mode: the mixer runs on _renderThread and fills a native ring the device callback plays from.
+    private readonly uint _ringPeriod;
+    private readonly nint _ringBuffer;
+    private Thread? _renderThread;
+    private volatile bool _rendering;
+
+    private readonly bool _ditherOutput;
+
     public DeviceInfo? Info { get; }
     public Capability Capability { get; }
     public AudioFormat Format { get; }
@@ -28,6 +41,7 @@ internal sealed class MiniAudioDevice : IDisposable
         Info = info;
         Format = format;
         _onProcess = onProcess;
+        _ditherOutput = miniAudioDeviceConfig.DitherOutput;
         Engine = (MiniAudioEngine)owner.Engine;
 
         Capability = owner is AudioCaptureDevice
@@ -44,10 +58,17 @@ internal sealed class MiniAudioDevice : IDisposable
             var deviceConfig = Native.AllocateDeviceConfig(
                 Capability,
                 (uint)Format.SampleRate,
-                MiniAudioEngine.DataCallback,
+                nint.Zero,
                 pSfConfig
             );
 
+            _handle = GCHandle.Alloc(this);
+            var callbacks = new SfDeviceCallbacks
+            {
+                OnData = (nint)(delegate* unmanaged[Cdecl]<nint, nint, nint, uint, SfCallbackInfo*, void>)&OnData
+            };
+            Native.DeviceConfigSetCallbacks(deviceConfig, callbacks, GCHandle.ToIntPtr(_handle));
+
             _device = Native.AllocateDevice();
             var result = Native.DeviceInit(context, deviceConfig, _device);
             Native.Free(deviceConfig);
@@ -55,10 +76,15 @@ internal sealed class MiniAudioDevice : IDisposable
             if (result != MiniAudioResult.Success)
             {
                 Native.Free(_device);
+                _handle.Free();
                 throw new InvalidOperationException($"Unable to init device {info?.Name ?? "Default Device"}. Result: {result}");
             }
-            
-            MiniAudioEngine.RegisterEngineHandle(_device, Engine);
+
+            if (Native.DeviceRingGetStats(_device, out var ringStats) == MiniAudioResult.Success)
+            {
+                _ringPeriod = ringStats.PeriodSizeInFrames;
+                _ringBuffer = Marshal.AllocHGlobal((int)_ringPeriod * Format.Channels * Format.Format.GetBytesPerSample());
+            }
         }
         finally
         {
@@ -68,8 +94,6 @@ internal sealed class MiniAudioDevice : IDisposable
                 Marshal.FreeHGlobal(handle);
             }
         }
-
-        Engine.RegisterDevice(_device, this);
     }
 
     private nint MarshalConfig(MiniAudioDeviceConfig maConfig, List<nint> handles)
@@ -83,6 +107,7 @@ internal sealed class MiniAudioDevice : IDisposable
             NoClip = maConfig.NoClip,
             NoDisableDenormals = maConfig.NoDisableDenormals,
             NoFixedSizedCallback = maConfig.NoFixedSizedCallback,
+            RenderAheadPeriods = maConfig.RenderAheadPeriods,
             Playback = MarshalStruct(new SfDeviceSubConfig
             {
                 Format = Format.Format,
@@ -150,6 +175,25 @@ internal sealed class MiniAudioDevice : IDisposable
             }, handles);
         }
 
+        if (maConfig.Offline != null)
+        {
+            var pOutputPath = Marshal.StringToHGlobalAnsi(maConfig.Offline.OutputPath);
+            if (pOutputPath != nint.Zero) handles.Add(pOutputPath);
+            mainDto.Offline = MarshalStruct(new SfOfflineConfig { pOutputPath = pOutputPath }, handles);
+        }
+
+        if (maConfig.AutoTune != null)
+        {
+            mainDto.AutoTune = MarshalStruct(new SfAutoTuneConfig
+            {
+                MinPeriodSizeInFrames = maConfig.AutoTune.MinPeriodSizeInFrames,
+                MaxPeriodSizeInFrames = maConfig.AutoTune.MaxPeriodSizeInFrames,
+                WindowMilliseconds = maConfig.AutoTune.WindowMilliseconds,
+                StableWindows = maConfig.AutoTune.StableWindows,
+                MaxGlitchesPerWindow = maConfig.AutoTune.MaxGlitchesPerWindow
+            }, handles);
+        }
+
         if (maConfig.AAudio != null)
         {
             mainDto.AAudio = MarshalStruct(
@@ -176,24 +220,209 @@ internal sealed class MiniAudioDevice : IDisposable
     private static uint ToUInt(bool value) => (uint)(value ? 1 : 0);
 
 
-    public void Start() => Native.DeviceStart(_device);
+    /// <summary>
+    /// Gets whether the device plays from a render-ahead ring instead of calling the mixer from its callback.
+    /// </summary>
+    public bool IsRenderingAhead => _ringBuffer != nint.Zero;
+
+    public void Start()
+    {
+        if (IsRenderingAhead && _renderThread == null)
+        {
+            // Prime the ring so the first callbacks don't underrun while the render thread spins up.
+            FillRing();
+            _rendering = true;
+            _renderThread = new Thread(RenderAheadLoop)
+            {
+                Name = "SoundFlow Render-Ahead",
+                IsBackground = true,
+                Priority = ThreadPriority.Highest
+            };
+            _renderThread.Start();
+        }
+
+        Native.DeviceStart(_device);
+    }
+
+    public void Stop()
+    {
+        Native.DeviceStop(_device);
+
+        if (_renderThread == null) return;
+        _rendering = false;
+        Native.DeviceRingWake(_device);
+        _renderThread.Join();
+        _renderThread = null;
+
+        // Drop what was rendered ahead, so the next Start does not play stale audio.
+        Native.DeviceRingReset(_device);
+    }
+
+    /// <summary>
+    /// Gets a snapshot of the render-ahead ring, or null if the device renders in its callback.
+    /// </summary>
+    public RenderAheadStatistics? GetRenderAheadStatistics()
+    {
+        if (Native.DeviceRingGetStats(_device, out var stats) != MiniAudioResult.Success) return null;
+        return new RenderAheadStatistics((int)stats.CapacityInFrames, (int)stats.AvailableFrames,
+            (int)stats.PeriodSizeInFrames, (long)stats.UnderrunCount, (long)stats.UnderrunFrames);
+    }
+
+    /// <summary>
+    /// Gets a snapshot of the data callback's timing against its deadline.
+    /// </summary>
+    public DevicePerformanceStatistics GetPerformanceStatistics()
+    {
+        Native.DeviceGetPerfStats(_device, out var stats);
+
+        var histogram = new long[SfPerfStats.HistogramBins];
+        for (var i = 0; i < histogram.Length; i++) histogram[i] = stats.Histogram[i];
+
+        return new DevicePerformanceStatistics
+        {
+            CallbackCount = (long)stats.CallbackCount,
+            Budget = FromNanoseconds(stats.BudgetNs),
+            LastDuration = FromNanoseconds(stats.LastDurationNs),
+            MinDuration = FromNanoseconds(stats.MinDurationNs),
+            AverageDuration = FromNanoseconds(stats.AvgDurationNs),
+            MaxDuration = FromNanoseconds(stats.MaxDurationNs),
+            AverageJitter = FromNanoseconds(stats.AvgJitterNs),
+            MaxJitter = FromNanoseconds(stats.MaxJitterNs),
+            OverrunCount = (long)stats.OverrunCount,
+            UnderrunCount = (long)stats.UnderrunCount,
+            LateCallbackCount = (long)stats.LateCallbackCount,
+            DspLoadPercent = stats.DspLoad * 100f,
+            AverageDspLoadPercent = stats.AverageDspLoad * 100f,
+            PeakDspLoadPercent = stats.PeakDspLoad * 100f,
+            LoadHistogram = histogram
+        };
+    }
+
+    public void ResetPerformanceStatistics() => Native.DeviceResetPerfStats(_device);
+
+    /// <summary>
+    /// Gets the state of the period auto-tuner, or null if the device was not configured to auto-tune.
+    /// </summary>
+    public AutoTuneStatus? GetAutoTuneStatus()
+    {
+        if (Native.DeviceGetAutoTuneStatus(_device, out var status) != MiniAudioResult.Success) return null;
+        return new AutoTuneStatus((int)status.PeriodSizeInFrames, (int)status.Periods, (int)status.StableWindows,
+            (int)status.ReinitCount, status.Converged != 0, status.AtMaximum != 0, status.LastResult);
+    }
 
-    public void Stop() => Native.DeviceStop(_device);
+    /// <summary>
+    /// Gets whether the device renders offline rather than to hardware, see <see cref="MiniAudioDeviceConfig.Offline"/>.
+    /// </summary>
+    public bool IsOffline => Native.DeviceIsOffline(_device);
 
-    public void Process(nint pOutput, nint pInput, uint frameCount)
+    /// <summary>
+    /// Runs the device's callback for the given number of frames on the calling thread.
+    /// </summary>
+    public void Render(long frameCount)
     {
-        _onProcess(pOutput, pInput, frameCount, this);
+        var result = Native.DeviceRender(_device, (ulong)frameCount, nint.Zero);
+        if (result == MiniAudioResult.Busy)
+            throw new InvalidOperationException("An offline device cannot be rendered on demand while it is started.");
+        if (result != MiniAudioResult.Success)
+            throw new InvalidOperationException($"Unable to render device {Info?.Name ?? "Default Device"}. Result: {result}");
+    }
+
+    /// <summary>
+    /// Gets the device's clock and the period configuration negotiated with the backend.
+    /// </summary>
+    public DeviceTiming GetTiming()
+    {
+        Native.DeviceGetTiming(_device, out var timing);
+        return new DeviceTiming
+        {
+            FramesRendered = (long)timing.FramesRendered,
+            LastCallbackFramePosition = (long)timing.LastCallbackFramePosition,
+            LastCallbackFrameCount = (int)timing.LastCallbackFrameCount,
+            LastCallbackTimestampNs = (long)timing.LastCallbackTimestampNs,
+            TimestampNs = (long)timing.TimestampNs,
+            SampleRate = (int)timing.SampleRate,
+            InternalSampleRate = (int)timing.InternalSampleRate,
+            PeriodSizeInFrames = (int)timing.PeriodSizeInFrames,
+            PeriodCount = (int)timing.Periods,
+            PeriodLatencyFrames = (int)timing.PeriodLatencyFrames,
+            InternalLatencyFrames = (int)timing.InternalLatencyFrames,
+            RenderAheadFrames = (int)timing.RenderAheadFrames
+        };
+    }
+
+    private static TimeSpan FromNanoseconds(ulong nanoseconds) => TimeSpan.FromTicks((long)(nanoseconds / 100));
+
+    private void RenderAheadLoop()
+    {
+        try
+        {
+            while (_rendering)
+            {
+                FillRing();
+                if (_rendering) Native.DeviceRingWait(_device);
+            }
+        }
+        catch (Exception ex)
+        {
+            // Stop rendering rather than crash the process; the callback plays silence until the device is restarted.
+            _rendering = false;
+            Log.Error($"Render-ahead thread failed: {ex.Message}");
+        }
+    }
+
+    /// <summary>
+    /// Renders whole periods into the ring until it has no room for another.
+    /// </summary>
+    private void FillRing()
+    {
+        while (Native.DeviceRingAvailableWrite(_device) >= _ringPeriod)
+        {
+            _onProcess(_ringBuffer, nint.Zero, _ringPeriod, this);
+            Native.DeviceRingWrite(_device, _ringBuffer, _ringPeriod);
+        }
+    }
+
+    /// <summary>
+    /// Converts float samples to the device's sample format using the native SIMD kernels, clipping to full scale.
+    /// </summary>
+    public void ConvertToDeviceFormat(Span<float> source, nint destination)
+    {
+        fixed (float* pSource = source)
+            Native.PcmConvertFromF32(destination, Format.Format, pSource, (ulong)source.Length, _ditherOutput ? 1u : 0u);
+    }
+
+    /// <summary>
+    /// Converts samples in the device's sample format to float using the native SIMD kernels.
+    /// </summary>
+    public void ConvertFromDeviceFormat(nint source, Span<float> destination)
+    {
+        fixed (float* pDestination = destination)
+            Native.PcmConvertToF32(pDestination, source, Format.Format, (ulong)destination.Length);
+    }
+
+    [UnmanagedCallersOnly(CallConvs = [typeof(CallConvCdecl)])]
+    private static void OnData(nint pUserData, nint pOutput, nint pInput, uint frameCount, SfCallbackInfo* pInfo)
+    {
+        try
+        {
+            if (GCHandle.FromIntPtr(pUserData).Target is not MiniAudioDevice device) return;
+
+            device._onProcess(pOutput, pInput, frameCount, device);
+        }
+        catch (Exception ex)
+        {
+            // Swallow exception to prevent runtime crash; this runs on the native audio thread.
+            Log.Error($"Device data callback failed: {ex.Message}");
+        }
     }
 
     public void Dispose()
     {
         Stop();
-        
-        // Remove the device from the engine's instance map.
-        Engine.UnregisterDevice(_device);
-        MiniAudioEngine.UnregisterEngineHandle(_device);
 
         Native.DeviceUninit(_device);
         Native.Free(_device);
+        _handle.Free();
+        if (_ringBuffer != nint.Zero) Marshal.FreeHGlobal(_ringBuffer);
     }
 }
\ No newline at end of file
@@ -53,6 +53,44 @@ public class MiniAudioDeviceConfig : DeviceConfig
     /// </summary>
     public bool NoFixedSizedCallback { get; set; }
 
+    /// <summary>
+    /// Gets or sets how many periods of audio a playback device renders ahead of the hardware.
+    /// When non-zero, the mixer runs on a dedicated render thread that keeps a native ring buffer this many periods
+    /// full, and the real-time callback only copies from that ring, so garbage collection pauses and mixer spikes
+    /// shorter than the ring no longer cause glitches. Each period adds one period of output latency.
+    /// Set to 0 to render directly in the device callback. Ignored for capture devices.
+    /// <para>
+    /// <see cref="Abstracts.AudioEngine.AudioFramesRendered"/> is then raised on the render thread as each period is
+    /// mixed, up to this many periods before it is heard. Use <see cref="MiniAudioEngine.GetDeviceTiming"/> to relate it to
+    /// the playback clock.
+    /// </para>
+    /// </summary>
+    public uint RenderAheadPeriods { get; set; }
+
+    /// <summary>
+    /// Gets or sets whether triangular (TPDF) dither is added when converting output to an 8, 16 or 24-bit integer
+    /// device format. Dither replaces quantization distortion on quiet signals with a constant low-level noise floor.
+    /// Has no effect on float or 32-bit output.
+    /// </summary>
+    public bool DitherOutput { get; set; }
+
+    /// <summary>
+    /// Gets or sets offline rendering. When set, the device opens no hardware: starting it runs the engine as fast as
+    /// the CPU allows, and <see cref="MiniAudioEngine.RenderOffline"/> renders an exact number of frames on demand.
+    /// Use it for batch export, benchmarks and headless tests of the full mixing pipeline.
+    /// </summary>
+    public OfflineSettings? Offline { get; set; }
+
+    /// <summary>
+    /// Gets or sets period auto-tuning. When set, the device starts with a small period and a native monitor doubles
+    /// it, reinitializing the device transparently, whenever callbacks miss their deadline or the device glitches,
+    /// until it finds the lowest latency the machine sustains. The period only ever grows: a glitch-free stretch does not
+    /// shrink it again, so a transient load spike keeps the larger period for the life of the device. Overrides <see cref="PeriodSizeInFrames"/>,
+    /// <see cref="PeriodSizeInMilliseconds"/> and <see cref="RenderAheadPeriods"/>; ignored for offline devices.
+    /// Query the result with <see cref="MiniAudioEngine.GetAutoTuneStatus"/>.
+    /// </summary>
+    public AutoTuneSettings? AutoTune { get; set; }
+
     /// <summary>
     /// Gets or sets the configuration specific to playback.
     /// </summary>
@@ -117,6 +155,50 @@ public class DeviceSubConfig
     internal bool IsLoopback { get; set; }
 }
 
+/// <summary>
+/// Contains settings for an offline device, see <see cref="MiniAudioDeviceConfig.Offline"/>.
+/// </summary>
+public class OfflineSettings
+{
+    /// <summary>
+    /// Gets or sets the path of a WAV file the playback output is written to, in the device format.
+    /// Set to null to discard the output.
+    /// </summary>
+    public string? OutputPath { get; set; }
+}
+
+/// <summary>
+/// Contains settings for period auto-tuning, see <see cref="MiniAudioDeviceConfig.AutoTune"/>.
+/// Set a value to 0 to use its default.
+/// </summary>
+public class AutoTuneSettings
+{
+    /// <summary>
+    /// Gets or sets the period, in frames, tried first. Defaults to 64.
+    /// </summary>
+    public uint MinPeriodSizeInFrames { get; set; }
+
+    /// <summary>
+    /// Gets or sets the largest period, in frames, the tuner will grow to. Defaults to 4096.
+    /// </summary>
+    public uint MaxPeriodSizeInFrames { get; set; }
+
+    /// <summary>
+    /// Gets or sets how long, in milliseconds, each period is observed before it is judged. Defaults to 1000.
+    /// </summary>
+    public uint WindowMilliseconds { get; set; }
+
+    /// <summary>
+    /// Gets or sets how many clean windows in a row make a period count as stable. Defaults to 5.
+    /// </summary>
+    public uint StableWindows { get; set; }
+
+    /// <summary>
+    /// Gets or sets how many overruns, underruns and late callbacks a window may contain and still count as clean.
+    /// </summary>
+    public uint MaxGlitchesPerWindow { get; set; }
+}
+
 /// <summary>
 /// Contains settings specific to the WASAPI audio backend on Windows.
 /// </summary>
@@ -20,6 +20,11 @@ internal sealed class MiniAudioPlaybackDevice : AudioPlaybackDevice
         Capability = _device.Capability;
     }
 
+    /// <summary>
+    /// Gets the underlying MiniAudio device.
+    /// </summary>
+    internal MiniAudioDevice Device => _device;
+
     public override void Start()
     {
         if (IsRunning) return;
@@ -77,7 +82,7 @@ internal sealed class MiniAudioPlaybackDevice : AudioPlaybackDevice
             ProcessAndFillBuffer(buffer, device.Format.Channels);
 
             // 2. Convert the float buffer to the device's native format.
-            DeviceBufferHelper.ConvertToDeviceFormat(buffer, pOutput, length, device.Format.Format);
+            device.ConvertToDeviceFormat(buffer, pOutput);
         }
         finally
         {
@@ -0,0 +1,40 @@
+﻿namespace SoundFlow.Backends.MiniAudio.Enums;
+
+/// <summary>
+/// The AVAudioSession category used on iOS. Maps to the native `ma_ios_session_category` enum.
+/// </summary>
+public enum CoreAudioSessionCategory
+{
+    /// <summary>
+    /// Let MiniAudio choose: play and record for capture, playback otherwise.
+    /// </summary>
+    Default = 0,
+    /// <summary>
+    /// Leave the session category unchanged.
+    /// </summary>
+    None,
+    /// <summary>
+    /// AVAudioSessionCategoryAmbient.
+    /// </summary>
+    Ambient,
+    /// <summary>
+    /// AVAudioSessionCategorySoloAmbient.
+    /// </summary>
+    SoloAmbient,
+    /// <summary>
+    /// AVAudioSessionCategoryPlayback.
+    /// </summary>
+    Playback,
+    /// <summary>
+    /// AVAudioSessionCategoryRecord.
+    /// </summary>
+    Record,
+    /// <summary>
+    /// AVAudioSessionCategoryPlayAndRecord.
+    /// </summary>
+    PlayAndRecord,
+    /// <summary>
+    /// AVAudioSessionCategoryMultiRoute.
+    /// </summary>
+    MultiRoute
+}
@@ -74,7 +74,9 @@ public enum MiniAudioBackend
     WebAudio = 13,
 
     /// <summary>
-    /// A placeholder for a custom user-defined backend. Not currently supported by this wrapper.
+    /// SoundFlow's virtual devices, registered with <see cref="MiniAudioEngine.AddVirtualDevice"/>. They need no
+    /// sound hardware, which makes them suited to headless machines and load tests. Only used when listed in the
+    /// engine's backend priority; default probing skips it.
     /// </summary>
     Custom = 14,
     
@@ -0,0 +1,36 @@
+﻿namespace SoundFlow.Backends.MiniAudio.Enums;
+
+/// <summary>
+/// The scheduling priority of the device threads MiniAudio creates. Maps to the native `ma_thread_priority` enum.
+/// </summary>
+public enum MiniAudioThreadPriority
+{
+    /// <summary>
+    /// The lowest scheduling priority.
+    /// </summary>
+    Idle = -5,
+    /// <summary>
+    /// A priority below <see cref="Low"/>.
+    /// </summary>
+    Lowest = -4,
+    /// <summary>
+    /// A priority below normal.
+    /// </summary>
+    Low = -3,
+    /// <summary>
+    /// The operating system's normal thread priority.
+    /// </summary>
+    Normal = -2,
+    /// <summary>
+    /// A priority above normal.
+    /// </summary>
+    High = -1,
+    /// <summary>
+    /// The highest non-real-time priority. This is MiniAudio's default.
+    /// </summary>
+    Highest = 0,
+    /// <summary>
+    /// Real-time scheduling (for example SCHED_FIFO on Linux), where the process is permitted to use it.
+    /// </summary>
+    Realtime = 1
+}
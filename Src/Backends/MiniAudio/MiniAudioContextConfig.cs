@@ -0,0 +1,134 @@
+﻿using SoundFlow.Backends.MiniAudio.Enums;
+
+namespace SoundFlow.Backends.MiniAudio;
+
+/// <summary>
+/// Configures the MiniAudio context of a <see cref="MiniAudioEngine"/>: how its device threads are scheduled and
+/// context-level options of the individual backends.
+/// </summary>
+public class MiniAudioContextConfig
+{
+    /// <summary>
+    /// Gets or sets the priority of the device threads MiniAudio creates. Backends that run their own callback
+    /// threads, such as CoreAudio and PulseAudio, are not affected.
+    /// </summary>
+    public MiniAudioThreadPriority ThreadPriority { get; set; } = MiniAudioThreadPriority.Highest;
+
+    /// <summary>
+    /// Gets or sets the stack size, in bytes, of the device threads MiniAudio creates. Set to 0 to use the default.
+    /// </summary>
+    public uint ThreadStackSize { get; set; }
+
+    /// <summary>
+    /// Gets or sets the CPUs the device callbacks may run on: bit n allows CPU n. Pinning the audio thread to cores
+    /// the rest of the process leaves free keeps busy worker threads from preempting it. Applies to whichever
+    /// thread runs a device's callback, including backend-owned threads. Set to 0 to leave threads unpinned.
+    /// Offline devices are never pinned, since they render on the caller's thread. Supported on Windows and Linux;
+    /// ignored elsewhere, including Android, whose audio threads belong to the system.
+    /// </summary>
+    public ulong CpuAffinityMask { get; set; }
+
+    /// <summary>
+    /// Gets or sets the context configuration specific to the ALSA backend. This is only used on Linux.
+    /// </summary>
+    public AlsaContextSettings? Alsa { get; set; }
+
+    /// <summary>
+    /// Gets or sets the context configuration specific to the PulseAudio backend.
+    /// </summary>
+    public PulseContextSettings? Pulse { get; set; }
+
+    /// <summary>
+    /// Gets or sets the context configuration specific to the JACK backend.
+    /// </summary>
+    public JackContextSettings? Jack { get; set; }
+
+    /// <summary>
+    /// Gets or sets the context configuration specific to the CoreAudio backend. This is only used on iOS.
+    /// </summary>
+    public CoreAudioContextSettings? CoreAudio { get; set; }
+}
+
+/// <summary>
+/// Contains context settings specific to the ALSA backend on Linux.
+/// </summary>
+public class AlsaContextSettings
+{
+    /// <summary>
+    /// Gets or sets whether enumeration lists every ALSA device, including the plugin devices normally hidden.
+    /// Maps to `ma_context_config.alsa.useVerboseDeviceEnumeration`.
+    /// </summary>
+    public bool UseVerboseDeviceEnumeration { get; set; }
+}
+
+/// <summary>
+/// Contains context settings specific to the PulseAudio backend.
+/// </summary>
+public class PulseContextSettings
+{
+    /// <summary>
+    /// Gets or sets the application name reported to the PulseAudio server.
+    /// Maps to `ma_context_config.pulse.pApplicationName`.
+    /// </summary>
+    public string? ApplicationName { get; set; }
+
+    /// <summary>
+    /// Gets or sets the server to connect to, or null for the default server.
+    /// Maps to `ma_context_config.pulse.pServerName`.
+    /// </summary>
+    public string? ServerName { get; set; }
+
+    /// <summary>
+    /// Gets or sets whether to start a PulseAudio server if none is running.
+    /// Maps to `ma_context_config.pulse.tryAutoSpawn`.
+    /// </summary>
+    public bool TryAutoSpawn { get; set; }
+}
+
+/// <summary>
+/// Contains context settings specific to the JACK backend.
+/// </summary>
+public class JackContextSettings
+{
+    /// <summary>
+    /// Gets or sets the client name registered with the JACK server.
+    /// Maps to `ma_context_config.jack.pClientName`.
+    /// </summary>
+    public string? ClientName { get; set; }
+
+    /// <summary>
+    /// Gets or sets whether to start a JACK server if none is running.
+    /// Maps to `ma_context_config.jack.tryStartServer`.
+    /// </summary>
+    public bool TryStartServer { get; set; }
+}
+
+/// <summary>
+/// Contains context settings specific to the CoreAudio backend on iOS.
+/// </summary>
+public class CoreAudioContextSettings
+{
+    /// <summary>
+    /// Gets or sets the audio session category.
+    /// Maps to `ma_context_config.coreaudio.sessionCategory`.
+    /// </summary>
+    public CoreAudioSessionCategory SessionCategory { get; set; }
+
+    /// <summary>
+    /// Gets or sets the AVAudioSessionCategoryOptions flags applied with the category.
+    /// Maps to `ma_context_config.coreaudio.sessionCategoryOptions`.
+    /// </summary>
+    public uint SessionCategoryOptions { get; set; }
+
+    /// <summary>
+    /// Gets or sets whether MiniAudio leaves activating the audio session to the application.
+    /// Maps to `ma_context_config.coreaudio.noAudioSessionActivate`.
+    /// </summary>
+    public bool NoAudioSessionActivate { get; set; }
+
+    /// <summary>
+    /// Gets or sets whether MiniAudio leaves deactivating the audio session to the application.
+    /// Maps to `ma_context_config.coreaudio.noAudioSessionDeactivate`.
+    /// </summary>
+    public bool NoAudioSessionDeactivate { get; set; }
+}
@@ -1,29 +1,38 @@
 using SoundFlow.Abstracts;
 using SoundFlow.Structs;
 using SoundFlow.Utils;
-using System.Collections.Concurrent;
+using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 using System.Text;
 using SoundFlow.Abstracts.Devices;
 using SoundFlow.Backends.MiniAudio.Devices;
 using SoundFlow.Backends.MiniAudio.Enums;
 using SoundFlow.Backends.MiniAudio.Structs;
+using SoundFlow.Enums;
+using SoundFlow.Structs.Events;
 
 namespace SoundFlow.Backends.MiniAudio;
 
 /// <summary>
 /// An audio engine based on the MiniAudio library.
 /// </summary>
-public class MiniAudioEngine : AudioEngine
+public unsafe class MiniAudioEngine : AudioEngine
 {
+    // How often the device cache re-enumerates in the background when no change notification arrives.
+    private const uint DeviceRefreshIntervalMs = 2000;
+
     private nint _context;
     private readonly List<AudioDevice> _activeDevices = [];
     private readonly MiniAudioBackend[]? _backendPriority;
+    private readonly MiniAudioContextConfig? _contextConfig;
 
-    internal static readonly Native.AudioCallback DataCallback = OnAudioData;
+    private nint _deviceCache;
+    private ulong _deviceCacheGeneration;
+    private readonly object _deviceCacheLock = new();
+    private GCHandle _handle;
 
-    private readonly ConcurrentDictionary<nint, MiniAudioDevice> _deviceMap = new();
-    private static readonly ConcurrentDictionary<nint, GCHandle> ActiveEngineHandles = new();
+    // Set while DeviceAdded or DeviceRemoved handlers run on this thread, which is then inside a device cache refresh.
+    [ThreadStatic] private static bool _isRaisingDeviceListChanged;
 
     /// <summary>
     /// Gets a list of audio backends that are available on the current operating system.
@@ -39,6 +48,20 @@ public class MiniAudioEngine : AudioEngine
     /// </remarks>
     public MiniAudioBackend ActiveBackend { get; private set; }
 
+    /// <summary>
+    /// Occurs when a playback or capture device is connected. Raised from a background thread, or from a thread calling
+    /// <see cref="UpdateAudioDevicesInfo"/>, after <see cref="AudioEngine.PlaybackDevices"/> and
+    /// <see cref="AudioEngine.CaptureDevices"/> have been updated.
+    /// </summary>
+    public event EventHandler<DeviceListChangedEventArgs>? DeviceAdded;
+
+    /// <summary>
+    /// Occurs when a playback or capture device is disconnected. Raised from a background thread, or from a thread calling
+    /// <see cref="UpdateAudioDevicesInfo"/>, after <see cref="AudioEngine.PlaybackDevices"/> and
+    /// <see cref="AudioEngine.CaptureDevices"/> have been updated.
+    /// </summary>
+    public event EventHandler<DeviceListChangedEventArgs>? DeviceRemoved;
+
     static MiniAudioEngine()
     {
         if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
@@ -103,40 +126,17 @@ public class MiniAudioEngine : AudioEngine
     /// attempt to use them in the specified order. If null or empty, MiniAudio's default probing
     /// mechanism will be used.
     /// </param>
-    public MiniAudioEngine(IEnumerable<MiniAudioBackend>? backendPriority = null)
+    /// <param name="contextConfig">
+    /// Optional context settings, such as the priority and CPU affinity of the audio threads. If null, MiniAudio's
+    /// defaults are used.
+    /// </param>
+    public MiniAudioEngine(IEnumerable<MiniAudioBackend>? backendPriority = null, MiniAudioContextConfig? contextConfig = null)
     {
         _backendPriority = backendPriority?.ToArray();
+        _contextConfig = contextConfig;
         InitializeBackend();
     }
 
-    private static void OnAudioData(nint pDevice, nint pOutput, nint pInput, uint frameCount)
-    {
-        // Look up the GCHandle using the native device pointer.
-        if (!ActiveEngineHandles.TryGetValue(pDevice, out var engineHandle) ||
-            engineHandle.Target is not MiniAudioEngine engine ||
-            !engine._deviceMap.TryGetValue(pDevice, out var managedDevice)) return;
-        
-        // Safely get the engine instance from the handle.
-        managedDevice.Process(pOutput, pInput, frameCount);
-    }
-
-    internal static void RegisterEngineHandle(nint pDevice, MiniAudioEngine engine)
-    {
-        var engineHandle = GCHandle.Alloc(engine);
-        ActiveEngineHandles.TryAdd(pDevice, engineHandle);
-    }
-
-    internal static void UnregisterEngineHandle(nint pDevice)
-    {
-        if (ActiveEngineHandles.TryRemove(pDevice, out var engineHandle))
-        {
-            engineHandle.Free();
-        }
-    }
-
-    internal void RegisterDevice(nint pDevice, MiniAudioDevice device) => _deviceMap.TryAdd(pDevice, device);
-    internal void UnregisterDevice(nint pDevice) => _deviceMap.TryRemove(pDevice, out _);
-
     /// <summary>
     /// Initializes the audio backend context.
     /// </summary>
@@ -160,10 +160,15 @@ public class MiniAudioEngine : AudioEngine
             Marshal.Copy(nativeBackends, 0, pBackends, nativeBackends.Length);
         }
 
+        // The native side copies what it keeps from the config, so it is freed once the context is up.
+        var configHandles = new List<nint>();
+
         try
         {
+            var pConfig = _contextConfig != null ? MarshalContextConfig(_contextConfig, configHandles) : nint.Zero;
+
             // Use the marshaled pointer and count in the native call.
-            var result = Native.ContextInit(pBackends, backendCount, nint.Zero, _context);
+            var result = Native.ContextInit(pBackends, backendCount, pConfig, _context);
             if (result != MiniAudioResult.Success)
                 throw new InvalidOperationException($"Unable to init MiniAudio context. Result: {result}");
 
@@ -173,14 +178,93 @@ public class MiniAudioEngine : AudioEngine
         finally
         {
             if (pBackends != nint.Zero) Marshal.FreeHGlobal(pBackends);
+            foreach (var handle in configHandles) Marshal.FreeHGlobal(handle);
         }
 
-        UpdateAudioDevicesInfo();
+        // Enumerate once up front; the cache keeps the lists current from then on.
+        _deviceCache = Native.DeviceCacheCreate(_context, DeviceRefreshIntervalMs);
+        if (_deviceCache != nint.Zero)
+        {
+            _handle = GCHandle.Alloc(this);
+            Native.DeviceCacheSetCallback(_deviceCache,
+                (nint)(delegate* unmanaged[Cdecl]<nint, Capability, nint, uint, void>)&OnDeviceListChanged,
+                GCHandle.ToIntPtr(_handle));
+            ReadDeviceCache();
+        }
+        else
+        {
+            EnumerateAudioDevices();
+        }
 
         // Register the built-in codec factory for formats supported by MiniAudio.
         RegisterCodecFactory(new MiniAudioCodecFactory());
     }
 
+    private static nint MarshalContextConfig(MiniAudioContextConfig config, List<nint> handles)
+    {
+        var dto = new SfContextConfig
+        {
+            ThreadPriority = config.ThreadPriority,
+            ThreadStackSize = config.ThreadStackSize,
+            CpuAffinityMask = config.CpuAffinityMask
+        };
+
+        if (config.Alsa != null)
+        {
+            dto.Alsa = MarshalStruct(new SfAlsaContextConfig
+            {
+                UseVerboseDeviceEnumeration = config.Alsa.UseVerboseDeviceEnumeration ? 1u : 0u
+            }, handles);
+        }
+
+        if (config.Pulse != null)
+        {
+            dto.Pulse = MarshalStruct(new SfPulseContextConfig
+            {
+                pApplicationName = MarshalString(config.Pulse.ApplicationName, handles),
+                pServerName = MarshalString(config.Pulse.ServerName, handles),
+                TryAutoSpawn = config.Pulse.TryAutoSpawn ? 1u : 0u
+            }, handles);
+        }
+
+        if (config.Jack != null)
+        {
+            dto.Jack = MarshalStruct(new SfJackContextConfig
+            {
+                pClientName = MarshalString(config.Jack.ClientName, handles),
+                TryStartServer = config.Jack.TryStartServer ? 1u : 0u
+            }, handles);
+        }
+
+        if (config.CoreAudio != null)
+        {
+            dto.CoreAudio = MarshalStruct(new SfCoreAudioContextConfig
+            {
+                SessionCategory = config.CoreAudio.SessionCategory,
+                SessionCategoryOptions = config.CoreAudio.SessionCategoryOptions,
+                NoAudioSessionActivate = config.CoreAudio.NoAudioSessionActivate ? 1u : 0u,
+                NoAudioSessionDeactivate = config.CoreAudio.NoAudioSessionDeactivate ? 1u : 0u
+            }, handles);
+        }
+
+        return MarshalStruct(dto, handles);
+    }
+
+    private static nint MarshalStruct<T>(T structure, List<nint> handles) where T : struct
+    {
+        var ptr = Marshal.AllocHGlobal(Marshal.SizeOf<T>());
+        Marshal.StructureToPtr(structure, ptr, false);
+        handles.Add(ptr);
+        return ptr;
+    }
+
+    private static nint MarshalString(string? value, List<nint> handles)
+    {
+        var ptr = Marshal.StringToHGlobalAnsi(value);
+        if (ptr != nint.Zero) handles.Add(ptr);
+        return ptr;
+    }
+
     /// <inheritdoc />
     protected override void CleanupBackend()
     {
@@ -191,8 +275,32 @@ public class MiniAudioEngine : AudioEngine
 
         _activeDevices.Clear();
 
-        Native.ContextUninit(_context);
-        Native.Free(_context);
+        var deviceCache = _deviceCache;
+        var handle = _handle;
+        var context = _context;
+        _deviceCache = nint.Zero;
+
+        if (deviceCache != nint.Zero && _isRaisingDeviceListChanged)
+        {
+            // Disposed from a DeviceAdded or DeviceRemoved handler, inside a cache refresh that destroying the cache
+            // waits for. Finish on another thread once that refresh has returned.
+            ThreadPool.QueueUserWorkItem(_ => ReleaseNativeResources(deviceCache, handle, context));
+            return;
+        }
+
+        ReleaseNativeResources(deviceCache, handle, context);
+    }
+
+    private static void ReleaseNativeResources(nint deviceCache, GCHandle handle, nint context)
+    {
+        if (deviceCache != nint.Zero)
+        {
+            Native.DeviceCacheDestroy(deviceCache);
+            handle.Free();
+        }
+
+        Native.ContextUninit(context);
+        Native.Free(context);
     }
 
     /// <inheritdoc />
@@ -348,65 +456,245 @@ public class MiniAudioEngine : AudioEngine
         };
     }
 
+    /// <summary>
+    /// Gets a snapshot of a playback device's render-ahead ring: its fill level and how often the device ran dry.
+    /// </summary>
+    /// <param name="device">A playback device created by this engine, such as <see cref="FullDuplexDevice.PlaybackDevice"/>.</param>
+    /// <returns>The ring statistics, or null if the device was not configured with <see cref="MiniAudioDeviceConfig.RenderAheadPeriods"/>.</returns>
+    /// <exception cref="ArgumentException">Thrown if the device was not created by a <see cref="MiniAudioEngine"/>.</exception>
+    public RenderAheadStatistics? GetRenderAheadStatistics(AudioPlaybackDevice device)
+    {
+        if (device is not MiniAudioPlaybackDevice miniAudioDevice)
+            throw new ArgumentException($"device must be created by a {nameof(MiniAudioEngine)}.", nameof(device));
+
+        return miniAudioDevice.Device.GetRenderAheadStatistics();
+    }
+
+    /// <summary>
+    /// Gets a snapshot of how a device's audio callback performs against its real-time deadline: callback
+    /// durations, jitter, DSP load and glitch counters.
+    /// </summary>
+    /// <param name="device">A playback or capture device created by this engine. For a <see cref="FullDuplexDevice"/>, pass one of its underlying devices.</param>
+    /// <returns>The performance statistics since the device was created or last reset.</returns>
+    /// <exception cref="ArgumentException">Thrown if the device was not created by a <see cref="MiniAudioEngine"/>.</exception>
+    public DevicePerformanceStatistics GetPerformanceStatistics(AudioDevice device) =>
+        GetMiniAudioDevice(device).GetPerformanceStatistics();
+
+    /// <summary>
+    /// Clears a device's performance statistics. The counters restart at the device's next callback.
+    /// </summary>
+    /// <param name="device">A playback or capture device created by this engine.</param>
+    /// <exception cref="ArgumentException">Thrown if the device was not created by a <see cref="MiniAudioEngine"/>.</exception>
+    public void ResetPerformanceStatistics(AudioDevice device) =>
+        GetMiniAudioDevice(device).ResetPerformanceStatistics();
+
+    /// <summary>
+    /// Gets a device's clock and latency: the frames it has rendered, when its last callback ran and the period size
+    /// and count the backend actually chose. Use <see cref="DeviceTiming.EstimatePresentedFrame"/> to interpolate
+    /// the audible position between callbacks, for example to synchronise video with playback.
+    /// </summary>
+    /// <param name="device">A playback or capture device created by this engine.</param>
+    /// <returns>
+    /// The device timing, read without blocking the audio thread or waiting for an auto-tuning reinitialisation, in
+    /// which case the period layout is the one in effect before it.
+    /// </returns>
+    /// <exception cref="ArgumentException">Thrown if the device was not created by a <see cref="MiniAudioEngine"/>.</exception>
+    public DeviceTiming GetDeviceTiming(AudioDevice device) => GetMiniAudioDevice(device).GetTiming();
+
+    /// <summary>
+    /// Gets the period configuration an auto-tuned device has settled on, or is currently trying.
+    /// </summary>
+    /// <param name="device">A playback or capture device created by this engine.</param>
+    /// <returns>The tuner state, or null if the device was not configured with <see cref="MiniAudioDeviceConfig.AutoTune"/>.</returns>
+    /// <exception cref="ArgumentException">Thrown if the device was not created by a <see cref="MiniAudioEngine"/>.</exception>
+    public AutoTuneStatus? GetAutoTuneStatus(AudioDevice device) => GetMiniAudioDevice(device).GetAutoTuneStatus();
+
+    /// <summary>
+    /// Renders an offline device for an exact number of frames on the calling thread, as fast as the mixer runs.
+    /// The output goes to the device's <see cref="OfflineSettings.OutputPath"/>, if set.
+    /// </summary>
+    /// <param name="device">A device created by this engine with <see cref="MiniAudioDeviceConfig.Offline"/> set. It must be stopped.</param>
+    /// <param name="frameCount">The number of frames to render.</param>
+    /// <exception cref="ArgumentException">Thrown if the device was not created by a <see cref="MiniAudioEngine"/> or is not offline.</exception>
+    /// <exception cref="InvalidOperationException">Thrown if the device is started.</exception>
+    public void RenderOffline(AudioDevice device, long frameCount)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegative(frameCount);
+        var miniAudioDevice = GetMiniAudioDevice(device);
+        if (!miniAudioDevice.IsOffline)
+            throw new ArgumentException($"device must be configured with {nameof(MiniAudioDeviceConfig)}.{nameof(MiniAudioDeviceConfig.Offline)}.", nameof(device));
+
+        miniAudioDevice.Render(frameCount);
+    }
+
+    /// <summary>
+    /// Registers a virtual device, served by the <see cref="MiniAudioBackend.Custom"/> backend. A capture device
+    /// streams an audio file in a loop; a playback device writes a WAV file or discards its output. Registered devices
+    /// are process-wide and appear in <see cref="AudioEngine.PlaybackDevices"/> and <see cref="AudioEngine.CaptureDevices"/>
+    /// of every engine whose backend priority lists <see cref="MiniAudioBackend.Custom"/>, after its next device list update.
+    /// </summary>
+    /// <param name="type">Whether the device plays or captures.</param>
+    /// <param name="name">The device name reported by enumeration.</param>
+    /// <param name="filePath">
+    /// For capture, the file to stream, in any format miniaudio decodes. For playback, the WAV file to write, or null to discard the output.
+    /// </param>
+    /// <param name="rateMultiple">How fast the device runs relative to real time, or 0 to run as fast as possible.</param>
+    /// <returns>The id of the virtual device, for <see cref="RemoveVirtualDevice"/>.</returns>
+    /// <exception cref="ArgumentException">Thrown if a capture device has no file or <paramref name="rateMultiple"/> is negative.</exception>
+    public static int AddVirtualDevice(DeviceType type, string name, string? filePath, float rateMultiple = 1f)
+    {
+        ArgumentNullException.ThrowIfNull(name);
+        if (type == DeviceType.Capture && filePath == null)
+            throw new ArgumentException("A virtual capture device needs a file to stream.", nameof(filePath));
+        ArgumentOutOfRangeException.ThrowIfNegative(rateMultiple);
+
+        var capability = type == DeviceType.Capture ? Capability.Record : Capability.Playback;
+        var result = Native.VirtualDeviceAdd(capability, name, filePath, rateMultiple, out var id);
+        if (result != MiniAudioResult.Success)
+            throw new InvalidOperationException($"Unable to add virtual device {name}. Result: {result}");
+
+        return id;
+    }
+
+    /// <summary>
+    /// Unregisters a virtual device. Devices already initialized on it keep running until disposed.
+    /// </summary>
+    /// <param name="id">The id returned by <see cref="AddVirtualDevice"/>.</param>
+    /// <returns>True if the device was removed; false if no virtual device has that id.</returns>
+    public static bool RemoveVirtualDevice(int id) => Native.VirtualDeviceRemove(id) == MiniAudioResult.Success;
+
+    /// <summary>
+    /// Gets the current time, in nanoseconds, on the monotonic clock used by <see cref="DeviceTiming"/>.
+    /// </summary>
+    public static long GetMonotonicTimestamp() => (long)Native.GetTimeNs();
+
+    private static MiniAudioDevice GetMiniAudioDevice(AudioDevice device) => device switch
+    {
+        MiniAudioPlaybackDevice playback => playback.Device,
+        MiniAudioCaptureDevice capture => capture.Device,
+        _ => throw new ArgumentException($"device must be a playback or capture device created by a {nameof(MiniAudioEngine)}.", nameof(device))
+    };
+
     /// <inheritdoc />
+    /// <remarks>
+    /// Re-enumerates through the engine's device cache before returning, so the lists are current. Only devices
+    /// not seen before are queried in detail, and any change is also reported through <see cref="DeviceAdded"/> and
+    /// <see cref="DeviceRemoved"/>. The lists are otherwise kept current by a background thread, so there is no need
+    /// to call this to pick up hot-plugged devices.
+    /// </remarks>
     public override void UpdateAudioDevicesInfo()
     {
-        var result = Native.GetDevices(_context, out var pPlaybackDevices, out var pCaptureDevices,
-            out var playbackCountUint, out var captureCountUint);
+        if (_deviceCache == nint.Zero)
+        {
+            EnumerateAudioDevices();
+            return;
+        }
 
+        var result = Native.DeviceCacheRefresh(_deviceCache);
         if (result != MiniAudioResult.Success)
             throw new InvalidOperationException($"Unable to get devices. MiniAudio result: {result}");
-        
-        var playbackCount = (int)playbackCountUint;
-        var captureCount = (int)captureCountUint;
 
-        try
+        ReadDeviceCache();
+    }
+
+    /// <summary>
+    /// Copies the device cache's current snapshot into <see cref="AudioEngine.PlaybackDevices"/> and
+    /// <see cref="AudioEngine.CaptureDevices"/>, unless it has not changed since the last read.
+    /// </summary>
+    private void ReadDeviceCache()
+    {
+        lock (_deviceCacheLock)
         {
-            // Marshal playback devices
-            if (playbackCount > 0 && pPlaybackDevices != nint.Zero)
-            {
-                // 1. Create array for native structs
-                var nativePlayback = new DeviceInfoNative[playbackCount];
-                // 2. Read from pointer into native structs
-                pPlaybackDevices.ReadIntoArray(nativePlayback, playbackCount);
-                
-                // 3. Convert to public structs (Deep Copy)
-                PlaybackDevices = new DeviceInfo[playbackCount];
-                for (var i = 0; i < playbackCount; i++)
-                {
-                    PlaybackDevices[i] = ConvertFromNative(nativePlayback[i]);
-                }
-            }
-            else
-            {
-                PlaybackDevices = [];
-            }
+            var snapshot = Native.DeviceCacheAcquire(_deviceCache, out var pPlaybackDevices, out var pCaptureDevices,
+                out var playbackCount, out var captureCount, out var generation);
+            if (snapshot == nint.Zero) return;
 
-            // Marshal capture devices
-            if (captureCount > 0 && pCaptureDevices != nint.Zero)
+            try
             {
-                var nativeCapture = new DeviceInfoNative[captureCount];
-                pCaptureDevices.ReadIntoArray(nativeCapture, captureCount);
-
-                CaptureDevices = new DeviceInfo[captureCount];
-                for (var i = 0; i < captureCount; i++)
-                {
-                    CaptureDevices[i] = ConvertFromNative(nativeCapture[i]);
-                }
+                if (generation == _deviceCacheGeneration) return;
+                PlaybackDevices = ReadDeviceInfos(pPlaybackDevices, (int)playbackCount);
+                CaptureDevices = ReadDeviceInfos(pCaptureDevices, (int)captureCount);
+                _deviceCacheGeneration = generation;
             }
-            else
+            finally
             {
-                CaptureDevices = [];
+                Native.DeviceCacheRelease(snapshot);
             }
         }
+    }
+
+    /// <summary>
+    /// Enumerates devices directly, for when the device cache could not be created.
+    /// </summary>
+    private void EnumerateAudioDevices()
+    {
+        var result = Native.GetDevices(_context, out var pPlaybackDevices, out var pCaptureDevices,
+            out var playbackCountUint, out var captureCountUint);
+
+        if (result != MiniAudioResult.Success)
+            throw new InvalidOperationException($"Unable to get devices. MiniAudio result: {result}");
+
+        try
+        {
+            PlaybackDevices = ReadDeviceInfos(pPlaybackDevices, (int)playbackCountUint);
+            CaptureDevices = ReadDeviceInfos(pCaptureDevices, (int)captureCountUint);
+        }
         finally
         {
-            // 4. Now it is safe to free native memory, as we have copied the data to managed arrays
+            // Now it is safe to free native memory, as we have copied the data to managed arrays
             if (pPlaybackDevices != nint.Zero) Native.FreeDeviceInfos(pPlaybackDevices, playbackCountUint);
             if (pCaptureDevices != nint.Zero) Native.FreeDeviceInfos(pCaptureDevices, captureCountUint);
         }
     }
 
+    private static DeviceInfo[] ReadDeviceInfos(nint pDevices, int count)
+    {
+        if (count <= 0 || pDevices == nint.Zero) return [];
+
+        // 1. Read from pointer into native structs
+        var nativeDevices = new DeviceInfoNative[count];
+        pDevices.ReadIntoArray(nativeDevices, count);
+
+        // 2. Convert to public structs (Deep Copy)
+        var devices = new DeviceInfo[count];
+        for (var i = 0; i < count; i++)
+        {
+            devices[i] = ConvertFromNative(nativeDevices[i]);
+        }
+
+        return devices;
+    }
+
+    [UnmanagedCallersOnly(CallConvs = [typeof(CallConvCdecl)])]
+    private static void OnDeviceListChanged(nint pUserData, Capability deviceType, nint pInfo, uint added)
+    {
+        var wasRaising = _isRaisingDeviceListChanged;
+        try
+        {
+            if (GCHandle.FromIntPtr(pUserData).Target is not MiniAudioEngine engine || engine.IsDisposed) return;
+
+            engine.ReadDeviceCache();
+
+            // deviceType is a ma_device_type, which Capability mirrors.
+            var info = ConvertFromNative(Marshal.PtrToStructure<DeviceInfoNative>(pInfo));
+            var args = new DeviceListChangedEventArgs(info, deviceType == Capability.Record ? DeviceType.Capture : DeviceType.Playback);
+            _isRaisingDeviceListChanged = true;
+            if (added != 0)
+                engine.DeviceAdded?.Invoke(engine, args);
+            else
+                engine.DeviceRemoved?.Invoke(engine, args);
+        }
+        catch (Exception ex)
+        {
+            // Swallow exception to prevent runtime crash; this runs on the native refresh thread.
+            Log.Error($"Device list change handler failed: {ex.Message}");
+        }
+        finally
+        {
+            _isRaisingDeviceListChanged = wasRaising;
+        }
+    }
+
     private static DeviceInfo ConvertFromNative(DeviceInfoNative native)
     {
         // Decode Name
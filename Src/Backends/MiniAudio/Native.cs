@@ -1,6 +1,7 @@
 using System.Reflection;
 using System.Runtime.InteropServices;
 using SoundFlow.Backends.MiniAudio.Enums;
+using SoundFlow.Backends.MiniAudio.Structs;
 using SoundFlow.Enums;
 
 namespace SoundFlow.Backends.MiniAudio;
@@ -11,9 +12,6 @@ internal static unsafe partial class Native
     
     #region Delegates
     
-    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-    public delegate void AudioCallback(nint device, nint output, nint input, uint length);
-
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
     public delegate MiniAudioResult BufferProcessingCallback(
         nint pCodecContext,          // The native decoder/encoder instance pointer (ma_decoder*, ma_encoder*)
@@ -197,15 +195,21 @@ internal static unsafe partial class Native
 
     #region Context
 
-    [LibraryImport(LibraryName, EntryPoint = "ma_context_init")]
-    public static partial MiniAudioResult ContextInit(nint backends, uint backendCount, nint config, nint context);
+    [LibraryImport(LibraryName, EntryPoint = "sf_context_init")]
+    public static partial MiniAudioResult ContextInit(nint backends, uint backendCount, nint pSfConfig, nint context);
     
-    [LibraryImport(LibraryName, EntryPoint = "ma_context_uninit")]
-    public static partial void ContextUninit(nint context);
+    [LibraryImport(LibraryName, EntryPoint = "sf_context_uninit")]
+    public static partial MiniAudioResult ContextUninit(nint context);
 
     [LibraryImport(LibraryName, EntryPoint = "sf_context_get_backend")]
     public static partial MiniAudioBackend ContextGetBackend(nint context);
 
+    [LibraryImport(LibraryName, EntryPoint = "sf_virtual_device_add", StringMarshalling = StringMarshalling.Utf8)]
+    public static partial MiniAudioResult VirtualDeviceAdd(Capability type, string name, string? filePath, float rateMultiple, out int id);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_virtual_device_remove")]
+    public static partial MiniAudioResult VirtualDeviceRemove(int id);
+
     #endregion
 
     #region Device
@@ -213,18 +217,77 @@ internal static unsafe partial class Native
     [LibraryImport(LibraryName, EntryPoint = "sf_get_devices")]
     public static partial MiniAudioResult GetDevices(nint context, out nint pPlaybackDevices, out nint pCaptureDevices, out uint playbackDeviceCount, out uint captureDeviceCount);
 
-    [LibraryImport(LibraryName, EntryPoint = "ma_device_init")]
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_cache_create")]
+    public static partial nint DeviceCacheCreate(nint context, uint refreshIntervalMs);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_cache_destroy")]
+    public static partial void DeviceCacheDestroy(nint cache);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_cache_refresh")]
+    public static partial MiniAudioResult DeviceCacheRefresh(nint cache);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_cache_set_callback")]
+    public static partial void DeviceCacheSetCallback(nint cache, nint onChange, nint pUserData);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_cache_acquire")]
+    public static partial nint DeviceCacheAcquire(nint cache, out nint pPlaybackDevices, out nint pCaptureDevices,
+        out uint playbackDeviceCount, out uint captureDeviceCount, out ulong generation);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_cache_release")]
+    public static partial void DeviceCacheRelease(nint snapshot);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_config_set_callbacks")]
+    public static partial MiniAudioResult DeviceConfigSetCallbacks(nint config, in SfDeviceCallbacks callbacks, nint pUserData);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_init")]
     public static partial MiniAudioResult DeviceInit(nint context, nint config, nint device);
 
-    [LibraryImport(LibraryName, EntryPoint = "ma_device_uninit")]
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_uninit")]
     public static partial void DeviceUninit(nint device);
 
-    [LibraryImport(LibraryName, EntryPoint = "ma_device_start")]
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_start")]
     public static partial MiniAudioResult DeviceStart(nint device);
 
-    [LibraryImport(LibraryName, EntryPoint = "ma_device_stop")]
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_stop")]
     public static partial MiniAudioResult DeviceStop(nint device);
 
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_render")]
+    public static partial MiniAudioResult DeviceRender(nint device, ulong frameCount, nint pOutput);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_is_offline")]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    public static partial bool DeviceIsOffline(nint device);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_ring_write")]
+    public static partial uint DeviceRingWrite(nint device, nint pFrames, uint frameCount);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_ring_available_write")]
+    public static partial uint DeviceRingAvailableWrite(nint device);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_ring_wait")]
+    public static partial MiniAudioResult DeviceRingWait(nint device);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_ring_wake")]
+    public static partial void DeviceRingWake(nint device);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_ring_reset")]
+    public static partial void DeviceRingReset(nint device);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_ring_get_stats")]
+    public static partial MiniAudioResult DeviceRingGetStats(nint device, out SfRingStats stats);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_get_perf_stats")]
+    public static partial MiniAudioResult DeviceGetPerfStats(nint device, out SfPerfStats stats);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_reset_perf_stats")]
+    public static partial void DeviceResetPerfStats(nint device);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_get_autotune_status")]
+    public static partial MiniAudioResult DeviceGetAutoTuneStatus(nint device, out SfAutoTuneStatus status);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_device_get_timing")]
+    public static partial MiniAudioResult DeviceGetTiming(nint device, out SfDeviceTiming timing);
+
     #endregion
 
     #region Allocations
@@ -249,7 +312,7 @@ internal static unsafe partial class Native
         uint sampleRate);
 
     [LibraryImport(LibraryName, EntryPoint = "sf_allocate_device_config")]
-    public static partial nint AllocateDeviceConfig(Capability capabilityType, uint sampleRate, AudioCallback dataCallback, nint pSfConfig);
+    public static partial nint AllocateDeviceConfig(Capability capabilityType, uint sampleRate, nint dataCallback, nint pSfConfig);
 
     #endregion
 
@@ -261,5 +324,14 @@ internal static unsafe partial class Native
     [LibraryImport(LibraryName, EntryPoint = "sf_free_device_infos")]
     public static partial void FreeDeviceInfos(nint deviceInfos, uint count);
 
+    [LibraryImport(LibraryName, EntryPoint = "sf_get_time_ns")]
+    public static partial ulong GetTimeNs();
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_pcm_convert_from_f32")]
+    public static partial void PcmConvertFromF32(nint pDst, SampleFormat dstFormat, float* pSrc, ulong sampleCount, uint dither);
+
+    [LibraryImport(LibraryName, EntryPoint = "sf_pcm_convert_to_f32")]
+    public static partial void PcmConvertToF32(float* pDst, nint pSrc, SampleFormat srcFormat, ulong sampleCount);
+
     #endregion
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+﻿using SoundFlow.Backends.MiniAudio.Enums;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+/// <summary>
+/// The state of a device's period auto-tuner, see <see cref="Devices.MiniAudioDeviceConfig.AutoTune"/>.
+/// </summary>
+/// <param name="PeriodSizeInFrames">The period currently requested from the backend.</param>
+/// <param name="PeriodCount">The number of periods the backend chose.</param>
+/// <param name="StableWindows">The number of observation windows in a row without too many glitches at the current period.</param>
+/// <param name="ReinitializationCount">How many times the device was reinitialized with a larger period.</param>
+/// <param name="IsConverged">Whether the current period has stayed stable long enough to be considered settled.</param>
+/// <param name="IsAtMaximum">Whether the period reached the configured maximum and will not grow further.</param>
+/// <param name="LastResult">The result of the last reinitialization. Tuning stops if it failed.</param>
+public readonly record struct AutoTuneStatus(
+    int PeriodSizeInFrames,
+    int PeriodCount,
+    int StableWindows,
+    int ReinitializationCount,
+    bool IsConverged,
+    bool IsAtMaximum,
+    MiniAudioResult LastResult);
@@ -0,0 +1,91 @@
+﻿namespace SoundFlow.Backends.MiniAudio.Structs;
+
+/// <summary>
+/// A snapshot of how a device's audio callback performs against its real-time deadline.
+/// The budget of a callback is the duration of the audio it produces or consumes; a callback that takes
+/// longer than its budget cannot keep up with the hardware.
+/// </summary>
+public readonly record struct DevicePerformanceStatistics
+{
+    /// <summary>
+    /// The number of callbacks measured.
+    /// </summary>
+    public long CallbackCount { get; init; }
+
+    /// <summary>
+    /// The budget of the most recent callback.
+    /// </summary>
+    public TimeSpan Budget { get; init; }
+
+    /// <summary>
+    /// How long the most recent callback took.
+    /// </summary>
+    public TimeSpan LastDuration { get; init; }
+
+    /// <summary>
+    /// The shortest callback duration.
+    /// </summary>
+    public TimeSpan MinDuration { get; init; }
+
+    /// <summary>
+    /// The mean callback duration.
+    /// </summary>
+    public TimeSpan AverageDuration { get; init; }
+
+    /// <summary>
+    /// The longest callback duration.
+    /// </summary>
+    public TimeSpan MaxDuration { get; init; }
+
+    /// <summary>
+    /// The mean deviation of the time between callbacks from the period they cover.
+    /// </summary>
+    public TimeSpan AverageJitter { get; init; }
+
+    /// <summary>
+    /// The largest deviation of the time between callbacks from the period they cover.
+    /// </summary>
+    public TimeSpan MaxJitter { get; init; }
+
+    /// <summary>
+    /// The number of callbacks that took longer than their budget.
+    /// </summary>
+    public long OverrunCount { get; init; }
+
+    /// <summary>
+    /// The number of render-ahead callbacks that found the ring short and played silence.
+    /// </summary>
+    public long UnderrunCount { get; init; }
+
+    /// <summary>
+    /// The number of callbacks that arrived more than two periods after the previous one, meaning the backend
+    /// was kept waiting.
+    /// </summary>
+    public long LateCallbackCount { get; init; }
+
+    /// <summary>
+    /// The total of overruns, underruns and late callbacks: events likely to be heard as a glitch.
+    /// </summary>
+    public long XrunCount => OverrunCount + UnderrunCount + LateCallbackCount;
+
+    /// <summary>
+    /// The smoothed share of the budget used by recent callbacks, in percent.
+    /// </summary>
+    public float DspLoadPercent { get; init; }
+
+    /// <summary>
+    /// The total callback time over the total budget since measurement began, in percent.
+    /// </summary>
+    public float AverageDspLoadPercent { get; init; }
+
+    /// <summary>
+    /// The highest load of a single callback, in percent.
+    /// </summary>
+    public float PeakDspLoadPercent { get; init; }
+
+    /// <summary>
+    /// Callback counts by load in steps of 10%: index 0 counts callbacks under 10% of their budget,
+    /// and the last index counts callbacks at 150% and over.
+    /// </summary>
+    public long[] LoadHistogram { get; init; }
+}
@@ -0,0 +1,97 @@
+﻿namespace SoundFlow.Backends.MiniAudio.Structs;
+
+/// <summary>
+/// A device's clock and latency, for synchronising audio with video or other media. Frame counts are at the
+/// device's sample rate; timestamps are on the monotonic clock of <see cref="MiniAudioEngine.GetMonotonicTimestamp"/>.
+/// </summary>
+public readonly record struct DeviceTiming
+{
+    /// <summary>
+    /// The total number of frames the device's callback has processed.
+    /// </summary>
+    public long FramesRendered { get; init; }
+
+    /// <summary>
+    /// The number of frames processed before the most recent callback started.
+    /// </summary>
+    public long LastCallbackFramePosition { get; init; }
+
+    /// <summary>
+    /// The number of frames the most recent callback processed.
+    /// </summary>
+    public int LastCallbackFrameCount { get; init; }
+
+    /// <summary>
+    /// The monotonic time, in nanoseconds, at which the most recent callback started, or 0 before the first callback.
+    /// </summary>
+    public long LastCallbackTimestampNs { get; init; }
+
+    /// <summary>
+    /// The monotonic time, in nanoseconds, at which this timing was read.
+    /// </summary>
+    public long TimestampNs { get; init; }
+
+    /// <summary>
+    /// The sample rate the frame counts are in.
+    /// </summary>
+    public int SampleRate { get; init; }
+
+    /// <summary>
+    /// The sample rate the backend runs the hardware at. The backend resamples when it differs from <see cref="SampleRate"/>.
+    /// </summary>
+    public int InternalSampleRate { get; init; }
+
+    /// <summary>
+    /// The period size negotiated with the backend, in frames at <see cref="InternalSampleRate"/>.
+    /// </summary>
+    public int PeriodSizeInFrames { get; init; }
+
+    /// <summary>
+    /// The number of periods in the device buffer.
+    /// </summary>
+    public int PeriodCount { get; init; }
+
+    /// <summary>
+    /// The latency of one period, in frames.
+    /// </summary>
+    public int PeriodLatencyFrames { get; init; }
+
+    /// <summary>
+    /// The latency of the whole device buffer, in frames.
+    /// </summary>
+    public int InternalLatencyFrames { get; init; }
+
+    /// <summary>
+    /// The capacity of the render-ahead ring in frames, or 0 if the device renders in its callback.
+    /// Audio rendered into the ring is this much further ahead of the device.
+    /// </summary>
+    public int RenderAheadFrames { get; init; }
+
+    /// <summary>
+    /// The latency of one period.
+    /// </summary>
+    public TimeSpan PeriodLatency => FramesToTime(PeriodLatencyFrames);
+
+    /// <summary>
+    /// The latency of the whole device buffer.
+    /// </summary>
+    public TimeSpan InternalLatency => FramesToTime(InternalLatencyFrames);
+
+    /// <summary>
+    /// Estimates the frame being heard (for playback) or captured (for capture) at a moment on the monotonic clock,
+    /// by advancing from the most recent callback at the sample rate and subtracting the device buffer latency.
+    /// </summary>
+    /// <param name="timestampNs">The monotonic time, in nanoseconds. Defaults to <see cref="TimestampNs"/>.</param>
+    /// <returns>The estimated frame position, clamped to between 0 and <see cref="FramesRendered"/>.</returns>
+    public long EstimatePresentedFrame(long? timestampNs = null)
+    {
+        if (LastCallbackTimestampNs == 0 || SampleRate == 0) return 0;
+
+        var elapsedNs = Math.Max(0, (timestampNs ?? TimestampNs) - LastCallbackTimestampNs);
+        var position = LastCallbackFramePosition + elapsedNs * SampleRate / 1_000_000_000L - InternalLatencyFrames;
+        return Math.Clamp(position, 0, FramesRendered);
+    }
+
+    private TimeSpan FramesToTime(long frames) =>
+        SampleRate == 0 ? TimeSpan.Zero : TimeSpan.FromTicks(frames * TimeSpan.TicksPerSecond / SampleRate);
+}
@@ -0,0 +1,16 @@
+﻿namespace SoundFlow.Backends.MiniAudio.Structs;
+
+/// <summary>
+/// A snapshot of a playback device's render-ahead ring, see <see cref="Devices.MiniAudioDeviceConfig.RenderAheadPeriods"/>.
+/// </summary>
+/// <param name="CapacityInFrames">The size of the ring in frames.</param>
+/// <param name="FillInFrames">The frames rendered and waiting to be played.</param>
+/// <param name="PeriodSizeInFrames">The device period the ring was sized from.</param>
+/// <param name="UnderrunCount">The number of device callbacks that found the ring short and played silence.</param>
+/// <param name="UnderrunFrames">The total number of frames replaced with silence by those underruns.</param>
+public readonly record struct RenderAheadStatistics(
+    int CapacityInFrames,
+    int FillInFrames,
+    int PeriodSizeInFrames,
+    long UnderrunCount,
+    long UnderrunFrames);
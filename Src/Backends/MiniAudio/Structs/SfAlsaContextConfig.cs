@@ -0,0 +1,9 @@
+﻿using System.Runtime.InteropServices;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential)]
+internal struct SfAlsaContextConfig
+{
+    public uint UseVerboseDeviceEnumeration;
+}
@@ -0,0 +1,13 @@
+﻿using System.Runtime.InteropServices;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential)]
+internal struct SfAutoTuneConfig
+{
+    public uint MinPeriodSizeInFrames;
+    public uint MaxPeriodSizeInFrames;
+    public uint WindowMilliseconds;
+    public uint StableWindows;
+    public uint MaxGlitchesPerWindow;
+}
@@ -0,0 +1,16 @@
+﻿using System.Runtime.InteropServices;
+using SoundFlow.Backends.MiniAudio.Enums;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential)]
+internal struct SfAutoTuneStatus
+{
+    public uint PeriodSizeInFrames;
+    public uint Periods;
+    public uint StableWindows;
+    public uint ReinitCount;
+    public uint Converged;
+    public uint AtMaximum;
+    public MiniAudioResult LastResult;
+}
@@ -0,0 +1,17 @@
+﻿using System.Runtime.InteropServices;
+using SoundFlow.Backends.MiniAudio.Enums;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential)]
+internal struct SfContextConfig
+{
+    public MiniAudioThreadPriority ThreadPriority;
+    public nuint ThreadStackSize;
+    public ulong CpuAffinityMask;
+
+    public nint Alsa;
+    public nint Pulse;
+    public nint Jack;
+    public nint CoreAudio;
+}
@@ -0,0 +1,13 @@
+﻿using System.Runtime.InteropServices;
+using SoundFlow.Backends.MiniAudio.Enums;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential)]
+internal struct SfCoreAudioContextConfig
+{
+    public CoreAudioSessionCategory SessionCategory;
+    public uint SessionCategoryOptions;
+    public uint NoAudioSessionActivate;
+    public uint NoAudioSessionDeactivate;
+}
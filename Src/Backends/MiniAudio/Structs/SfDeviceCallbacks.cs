@@ -0,0 +1,10 @@
+﻿using System.Runtime.InteropServices;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential)]
+internal struct SfDeviceCallbacks
+{
+    public nint OnData;
+    public nint OnNotification;
+}
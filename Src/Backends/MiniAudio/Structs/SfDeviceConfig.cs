@@ -21,4 +21,8 @@ internal struct SfDeviceConfig
     public nint Pulse;
     public nint OpenSL;
     public nint AAudio;
+
+    public uint RenderAheadPeriods;
+    public nint Offline;
+    public nint AutoTune;
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+﻿using System.Runtime.InteropServices;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential)]
+internal struct SfDeviceTiming
+{
+    public ulong FramesRendered;
+    public ulong LastCallbackFramePosition;
+    public ulong LastCallbackTimestampNs;
+    public ulong TimestampNs;
+    public uint LastCallbackFrameCount;
+    public uint SampleRate;
+    public uint InternalSampleRate;
+    public uint PeriodSizeInFrames;
+    public uint Periods;
+    public uint PeriodLatencyFrames;
+    public uint InternalLatencyFrames;
+    public uint RenderAheadFrames;
+}
@@ -0,0 +1,10 @@
+﻿using System.Runtime.InteropServices;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
+internal struct SfJackContextConfig
+{
+    public nint pClientName;
+    public uint TryStartServer;
+}
@@ -0,0 +1,26 @@
+﻿using System.Runtime.InteropServices;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential)]
+internal unsafe struct SfPerfStats
+{
+    public const int HistogramBins = 16;
+
+    public ulong CallbackCount;
+    public ulong BudgetNs;
+    public ulong LastDurationNs;
+    public ulong MinDurationNs;
+    public ulong AvgDurationNs;
+    public ulong MaxDurationNs;
+    public ulong LastIntervalNs;
+    public ulong AvgJitterNs;
+    public ulong MaxJitterNs;
+    public ulong OverrunCount;
+    public ulong UnderrunCount;
+    public ulong LateCallbackCount;
+    public float DspLoad;
+    public float AverageDspLoad;
+    public float PeakDspLoad;
+    public fixed uint Histogram[HistogramBins];
+}
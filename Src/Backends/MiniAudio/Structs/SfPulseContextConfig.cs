@@ -0,0 +1,11 @@
+﻿using System.Runtime.InteropServices;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
+internal struct SfPulseContextConfig
+{
+    public nint pApplicationName;
+    public nint pServerName;
+    public uint TryAutoSpawn;
+}
@@ -0,0 +1,13 @@
+﻿using System.Runtime.InteropServices;
+
+namespace SoundFlow.Backends.MiniAudio.Structs;
+
+[StructLayout(LayoutKind.Sequential)]
+internal struct SfRingStats
+{
+    public uint CapacityInFrames;
+    public uint AvailableFrames;
+    public uint PeriodSizeInFrames;
+    public ulong UnderrunCount;
+    public ulong UnderrunFrames;
+}
@@ -1,6 +1,7 @@
 using System.Buffers;
 using SoundFlow.Components;
 using SoundFlow.Interfaces;
+using SoundFlow.Providers;
 using SoundFlow.Structs;
 
 namespace SoundFlow.Editing;
@@ -869,6 +870,44 @@ public class AudioSegment : IDisposable
         // Calculate the current sample offset within the source pass for the current read request.
         var currentEffectiveSampleOffsetInSourcePass = (long)(timeOffsetInCurrentSourcePass.TotalSeconds * sampleRate * channels);
         
+        // Reversed path, streamed: the decoder reads backwards a block at a time, so memory stays bounded
+        // and playback starts without decoding the whole pass first.
+        if (Settings.IsReversed && SourceDataProvider is StreamDataProvider streamProvider && streamProvider.TrySetReverse(true))
+        {
+            var sourceEndSamples = (long)((SourceStartTime + SourceDuration).TotalSeconds * sampleRate * channels);
+
+            // A segment running past the end of the source reverses from the last sample instead, and its pass
+            // shortens to match, as the cached path does by reading until the end of the stream.
+            var providerLength = SourceDataProvider.Length;
+            if (providerLength > 0 && sourceEndSamples > providerLength)
+            {
+                var passStartSamples = (long)(SourceStartTime.TotalSeconds * sampleRate * channels);
+                sourceEndSamples = providerLength;
+                singlePassSourceSamples = Math.Max(0, providerLength - passStartSamples);
+            }
+
+            var physicalReverseReadPos = sourceEndSamples - currentEffectiveSampleOffsetInSourcePass;
+            var samplesLeftInReversedPass = (int)Math.Min(samplesToReadTotal, singlePassSourceSamples - currentEffectiveSampleOffsetInSourcePass);
+
+            if (samplesLeftInReversedPass <= 0)
+            {
+                outputBuffer.Clear();
+                return 0;
+            }
+
+            if (_isReadStateInvalid || Math.Abs(streamProvider.Position - physicalReverseReadPos) > 32)
+            {
+                streamProvider.Seek((int)physicalReverseReadPos);
+                _isReadStateInvalid = false;
+            }
+
+            var reversedReadCount = streamProvider.ReadBytes(outputBuffer.Slice(0, samplesLeftInReversedPass));
+            if (reversedReadCount < outputBuffer.Length)
+                outputBuffer.Slice(reversedReadCount).Clear();
+
+            return reversedReadCount;
+        }
+
         // Reversed path (Handles reading from a pre-reversed cache)
         if (Settings.IsReversed)
         {
@@ -928,6 +967,12 @@ public class AudioSegment : IDisposable
         }
 
         // Forward path
+        if (SourceDataProvider is StreamDataProvider { IsReversed: true } reversedProvider)
+        {
+            reversedProvider.TrySetReverse(false);
+            _isReadStateInvalid = true;
+        }
+
         var sourceStartSamples = (long)(SourceStartTime.TotalSeconds * sampleRate * channels);
         
         // Calculate the absolute physical position in the underlying data provider
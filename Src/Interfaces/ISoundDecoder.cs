@@ -1,4 +1,5 @@
 using SoundFlow.Enums;
+using SoundFlow.Utils;
 
 namespace SoundFlow.Interfaces;
 
@@ -34,6 +35,23 @@ public interface ISoundDecoder : IDisposable
     /// </summary>
     int SampleRate { get; }
 
+    /// <summary>
+    ///     Decodes the next block of frames with each channel written to its own buffer, for consumers that process
+    ///     channels separately. The default implementation decodes interleaved samples and splits them; decoders that
+    ///     can produce planar output directly override it.
+    /// </summary>
+    /// <param name="channels">One buffer per channel. Decodes up to the length of the shortest buffer.</param>
+    /// <returns>The number of frames decoded, the same for every channel.</returns>
+    int DecodePlanar(Memory<float>[] channels)
+    {
+        ArgumentNullException.ThrowIfNull(channels);
+        if (channels.Length != Channels) throw new ArgumentException("Expected one buffer per channel.", nameof(channels));
+
+        var frameCount = int.MaxValue;
+        foreach (var channel in channels) frameCount = Math.Min(frameCount, channel.Length);
+        return frameCount == 0 ? 0 : DecoderHelper.DecodeAndSplit(this, channels, frameCount);
+    }
+
     /// <summary>
     ///     Seeks the decoder to a desired sample position from the beginning of the audio data.
     /// </summary>
@@ -48,6 +66,48 @@ public interface ISoundDecoder : IDisposable
     /// <returns>The actual number of samples decoded, will be less than or equal to the length of <paramref name="samples" />.</returns>
     int Decode(Span<float> samples);
 
+    /// <summary>
+    ///     Restricts decoding to a range of the audio and seeks to its start. Decoding stops exactly at the end of the
+    ///     range or, when <paramref name="loop" /> is set, continues seamlessly from its start.
+    /// </summary>
+    /// <param name="startSample">The first sample of the range.</param>
+    /// <param name="endSample">The sample to stop before, or 0 to decode to the end of the audio.</param>
+    /// <param name="loop">Whether to wrap to <paramref name="startSample" /> at the end of the range.</param>
+    /// <returns>True if the decoder applied the range; false if it does not support ranges and the caller must bound reads itself.</returns>
+    bool SetRange(int startSample, int endSample, bool loop) => false;
+
+    /// <summary>
+    ///     Switches the decoder between forward and reverse decoding. In reverse mode <see cref="Decode" /> returns the
+    ///     samples before the current position in reverse order, and <see cref="Seek" /> sets the position it reads back from.
+    /// </summary>
+    /// <param name="reverse">Whether to decode backwards.</param>
+    /// <returns>True if the decoder switched modes; false if it cannot decode in reverse.</returns>
+    bool SetReverse(bool reverse) => false;
+
+    /// <summary>
+    ///     Detects leading and trailing silence and restricts decoding to the audio between them, so the silence is never
+    ///     returned by <see cref="Decode" />.
+    /// </summary>
+    /// <param name="thresholdDb">The level, in dBFS, at or below which audio counts as silence.</param>
+    /// <param name="holdMilliseconds">How long sound must last to count; shorter clicks and spikes are treated as silence.</param>
+    /// <param name="startSample">The first sample kept.</param>
+    /// <param name="endSample">The sample after the last one kept.</param>
+    /// <returns>True if the silence was trimmed; false if the decoder cannot detect silence or the audio is entirely silent.</returns>
+    bool TrimSilence(float thresholdDb, int holdMilliseconds, out int startSample, out int endSample)
+    {
+        startSample = endSample = 0;
+        return false;
+    }
+
+    /// <summary>
+    ///     Chains another decoder after this one: once this stream ends, <see cref="Decode" /> continues seamlessly with
+    ///     <paramref name="next" />'s samples in the same call. The next decoder must stay undisposed until the transition,
+    ///     and must produce the same sample format, channel count and sample rate.
+    /// </summary>
+    /// <param name="next">The decoder to continue with, or null to remove a chained decoder.</param>
+    /// <returns>True if the decoder was chained; false if this decoder cannot chain <paramref name="next" />.</returns>
+    bool ChainNext(ISoundDecoder? next) => false;
+
     /// <summary>
     ///     Raised when the end of the audio stream is reached.
     /// </summary>
@@ -139,6 +139,11 @@ public sealed class StreamDataProvider : ISoundDataProvider
     /// <inheritdoc />
     public SoundFormatInfo? FormatInfo { get; }
 
+    /// <summary>
+    ///     Gets a value indicating whether the provider is reading backwards from its position.
+    /// </summary>
+    public bool IsReversed { get; private set; }
+
     /// <inheritdoc />
     public event EventHandler<EventArgs>? EndOfStreamReached;
 
@@ -150,7 +155,7 @@ public sealed class StreamDataProvider : ISoundDataProvider
     {
         if (IsDisposed) return 0;
         var count = _decoder.Decode(buffer);
-        Position += count;
+        Position += IsReversed ? -count : count;
         PositionChanged?.Invoke(this, new PositionChangedEventArgs(Position));
         return count;
     }
@@ -172,6 +177,23 @@ public sealed class StreamDataProvider : ISoundDataProvider
         PositionChanged?.Invoke(this, new PositionChangedEventArgs(Position));
     }
 
+    /// <summary>
+    ///     Switches between forward and reverse reading. In reverse mode <see cref="ReadBytes" /> returns the samples
+    ///     before <see cref="Position" /> in reverse order, decoding them a block at a time.
+    /// </summary>
+    /// <param name="reverse">Whether to read backwards.</param>
+    /// <returns>True if the mode was applied; false if the decoder cannot decode in reverse.</returns>
+    public bool TrySetReverse(bool reverse)
+    {
+        ObjectDisposedException.ThrowIf(IsDisposed, this);
+
+        if (reverse == IsReversed) return true;
+        if (!CanSeek || !_decoder.SetReverse(reverse)) return false;
+
+        IsReversed = reverse;
+        return true;
+    }
+
     /// <inheritdoc />
     public void Dispose()
     {
@@ -0,0 +1,19 @@
+﻿using SoundFlow.Enums;
+
+namespace SoundFlow.Structs.Events;
+
+/// <summary>
+/// Provides data for events raised when a device is connected to or disconnected from the system.
+/// </summary>
+public class DeviceListChangedEventArgs(DeviceInfo device, DeviceType type) : EventArgs
+{
+    /// <summary>
+    /// Gets the device that was added or removed.
+    /// </summary>
+    public DeviceInfo Device { get; } = device;
+
+    /// <summary>
+    /// Gets whether the device appeared in the playback or the capture device list.
+    /// </summary>
+    public DeviceType Type { get; } = type;
+}
@@ -0,0 +1,37 @@
+﻿using System.Buffers;
+using SoundFlow.Interfaces;
+
+namespace SoundFlow.Utils;
+
+/// <summary>
+/// Shared helpers for <see cref="ISoundDecoder"/> implementations.
+/// </summary>
+internal static class DecoderHelper
+{
+    /// <summary>
+    /// Decodes interleaved samples and splits them into one buffer per channel, for decoders without native planar output.
+    /// </summary>
+    /// <param name="decoder">The decoder to read from.</param>
+    /// <param name="channels">One buffer per channel, each at least <paramref name="frameCount"/> long.</param>
+    /// <param name="frameCount">The maximum number of frames to decode.</param>
+    /// <returns>The number of frames decoded, the same for every channel.</returns>
+    public static int DecodeAndSplit(ISoundDecoder decoder, Memory<float>[] channels, int frameCount)
+    {
+        var channelCount = decoder.Channels;
+        var interleaved = ArrayPool<float>.Shared.Rent(frameCount * channelCount);
+        try
+        {
+            var frames = decoder.Decode(interleaved.AsSpan(0, frameCount * channelCount)) / channelCount;
+            for (var c = 0; c < channelCount; c++)
+            {
+                var channel = channels[c].Span;
+                for (var i = 0; i < frames; i++) channel[i] = interleaved[i * channelCount + c];
+            }
+            return frames;
+        }
+        finally
+        {
+            ArrayPool<float>.Shared.Return(interleaved);
+        }
+    }
+}